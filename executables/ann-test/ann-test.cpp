@@ -1,4 +1,5 @@
 #include <classification/ANN.h>
+#include <data/DatasetGroup.h>
 #include <mpi.h>
 #include<arrayfire.h>
 #include <iostream>
@@ -32,8 +33,7 @@ int main(int argc, char *argv[]) {
 	juml::Dataset label(argv[2], "Label");
 
 	int n_classes = 10;
-	data.load_equal_chunks();
-	label.load_equal_chunks();
+	juml::DatasetGroup::joint_load(data, label);
 	cout << "Predicting..." << endl;
 	
 	af::array data_array = data.data();
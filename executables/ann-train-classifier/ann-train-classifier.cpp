@@ -1,4 +1,5 @@
 #include <classification/ANN.h>
+#include <data/DatasetGroup.h>
 #include <mpi.h>
 #include<arrayfire.h>
 #include <iostream>
@@ -76,7 +77,7 @@ struct Arg: public option::Arg
 };
 
 enum optionIndex{O_UNKNOWN, O_HELP, O_FEATURES, O_CLASSES, O_LEARNINGRATE, O_HIDDEN, O_BATCHSIZE, O_EPOCHS, O_MAXERROR,
-	O_DATAFILE, O_DATAFILE_DATA_SET, O_DATAFILE_LABEL_SET, O_SEED, O_BACKEND, O_SYNCTYPE, O_NETFILE, O_SHUFFLE, O_MOMENTUM, O_CUDAMPI, O_TESTFILE, O_TESTFILE_DATA_SET, O_TESTFILE_LABEL_SET, O_WEIGHT_DECAY};
+	O_DATAFILE, O_DATAFILE_DATA_SET, O_DATAFILE_LABEL_SET, O_SEED, O_BACKEND, O_SYNCTYPE, O_NETFILE, O_SHUFFLE, O_MOMENTUM, O_CUDAMPI, O_TESTFILE, O_TESTFILE_DATA_SET, O_TESTFILE_LABEL_SET, O_WEIGHT_DECAY, O_GLOBAL_SHUFFLE, O_PARTIAL_SHUFFLE};
 
 std::vector<int> requiredOptions = {O_FEATURES, O_CLASSES, O_LEARNINGRATE, O_BATCHSIZE, O_MAXERROR, O_DATAFILE, O_NETFILE, O_BACKEND, O_WEIGHT_DECAY};
 
@@ -86,7 +87,7 @@ const option::Descriptor usage[] = {
 		"USAGE: \n"
 		"  juml-ann-train-classifier --help | -h\n"
 		"  juml-ann-train-classifier [--seed=N] (-cpu|--opencl|--cuda) --error=F [--epochs=1000] --batchsize=N --learningrate=F [--momentum=0] "
-		"--features=N [--hidden=N [--hidden=N ...]] --classes=N --data=F [--data-X=Data] [--data-Y=Label] --net=F [--shuffle-samples] [--sync-after-batch|--sync-after-epoch] "
+		"--features=N [--hidden=N [--hidden=N ...]] --classes=N --data=F [--data-X=Data] [--data-Y=Label] --net=F [--shuffle-samples] [--global-shuffle|--partial-shuffle=F] [--sync-after-batch|--sync-after-epoch] "
 		"[--test=F [--test-X=Data] [--test-Y=Label]]"
 		"\n\nGeneral Options:"},
 	{O_HELP, 0, "h", "help", option::Arg::None, "--help, -h\tPrint usage and exit."},
@@ -102,6 +103,8 @@ const option::Descriptor usage[] = {
 	{O_EPOCHS, 0, "", "epochs", Arg::Numeric, "--epochs <N>\tSet the maximum number of training epochs"},
 	{O_BATCHSIZE, 0, "b", "batchsize", Arg::Numeric, "--batchsize <B>, -b <B>\tSet the global batchsize."},
 	{O_SHUFFLE, 0, "","shuffle-samples", option::Arg::None, "--shuffle-samples\tChange the order of the samples for each epoch"},
+	{O_GLOBAL_SHUFFLE, 0, "", "global-shuffle", option::Arg::None, "--global-shuffle\tShuffle the samples across all processes for each epoch"},
+	{O_PARTIAL_SHUFFLE, 0, "", "partial-shuffle", Arg::Float, "--partial-shuffle <F>\tExchange the fraction F of the samples with another process for each epoch"},
 	{O_LEARNINGRATE, 0, "l", "learningrate", Arg::Float, "--learningrate <L>, -l <L>\tLearningrate for training of the ANN"},
 	{O_WEIGHT_DECAY, 0, "", "weight-decay", Arg::Float, "--weight-decay <DECAY>\tSpecify the weight decay"},
 	{O_MOMENTUM, 0, "m", "momentum", Arg::Float, "--momentum <M>, -m <M>\tSpecify the proportion of momentum to be used"},
@@ -173,10 +176,12 @@ int main(int argc, char *argv[]) {
 	bool TESTFILE_PRESENT = false;
 	std::string TESTFILE_PATH, TESTFILE_X_SET = "Data", TESTFILE_Y_SET = "Label";
 	float max_error;
-	int seed;
+	int seed = 0;
 	af::Backend backend = AF_BACKEND_CUDA;
 	bool sync_after_batch_update;
 	bool shuffle_samples = false;
+	bool global_shuffle = false;
+	float partial_shuffle = 0;
 	float momentum = 0;
 
 	std::vector<int> hidden_layers;
@@ -290,6 +295,23 @@ int main(int argc, char *argv[]) {
 			shuffle_samples = true;
 		}
 
+		if (options[O_GLOBAL_SHUFFLE] && options[O_PARTIAL_SHUFFLE]) {
+			fprintf(stderr, "Can only specify one of --global-shuffle, --partial-shuffle\n");
+			return 1;
+		}
+		if (options[O_GLOBAL_SHUFFLE]) {
+			puts("Enabled global shuffling of data");
+			global_shuffle = true;
+		}
+		if (options[O_PARTIAL_SHUFFLE]) {
+			partial_shuffle = atof(options[O_PARTIAL_SHUFFLE].arg);
+			if (partial_shuffle < 0 || partial_shuffle > 1) {
+				fprintf(stderr, "The fraction of --partial-shuffle must be between 0 and 1\n");
+				return 1;
+			}
+			printf("Enabled partial shuffling of %f of the data\n", partial_shuffle);
+		}
+
 		if (options[O_MOMENTUM]) {
 			momentum = atof(options[O_MOMENTUM].arg);
 			printf("Using Momentum: %f\n",momentum);
@@ -389,17 +411,19 @@ int main(int argc, char *argv[]) {
 	juml::Dataset data(trainingFilePath, xDatasetName);
 	juml::Dataset label(trainingFilePath, yDatasetName);
 
-	data.load_equal_chunks();
-	label.load_equal_chunks();
+	// let HDF5 convert during the read instead of holding the partition twice
+	data.set_target_type(f32);
+	label.set_target_type(s32);
+	juml::DatasetGroup::joint_load(data, label);
 
 	double time_loaded_data = MPI_Wtime();
 
 
 	const int dataset_stepsize = 11;
-	af::array data_array = data.data().as(f32);
+	af::array data_array = data.data();
 	af::array full_data = data_array;
 
-	af::array label_array = label.data().as(s32);
+	af::array label_array = label.data();
 
 	int min_label = af::min<int>(label_array);
 	MPI_Allreduce(MPI_IN_PLACE, &min_label, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
@@ -411,8 +435,9 @@ int main(int argc, char *argv[]) {
 	if (TESTFILE_PRESENT) {
 		juml::Dataset testdata_X(TESTFILE_PATH, TESTFILE_X_SET);
 		juml::Dataset testdata_y(TESTFILE_PATH, TESTFILE_Y_SET);
-		testdata_X.load_equal_chunks();
-		testdata_y.load_equal_chunks();
+		testdata_X.set_target_type(f32);
+		testdata_y.set_target_type(s32);
+		juml::DatasetGroup::joint_load(testdata_X, testdata_y);
 		test_array_X = testdata_X.data();
 		test_array_y = testdata_y.data();
 		n_testfile_samples = test_array_X.dims(1);
@@ -473,6 +498,24 @@ int main(int argc, char *argv[]) {
 	af::array shuffled_idx, sorted_randomizer;
 
 	for (int epoch = 0; epoch < max_epochs; epoch++) {
+		if (epoch > 0 && (global_shuffle || partial_shuffle > 0)) {
+			//Exchange samples between the processes, data and labels are permuted identically
+			if (global_shuffle) {
+				data.shuffle(seed + epoch);
+				label.shuffle(seed + epoch);
+			} else {
+				data.partial_shuffle(partial_shuffle, seed + epoch);
+				label.partial_shuffle(partial_shuffle, seed + epoch);
+			}
+			data_array = data.data();
+			full_data = data_array;
+			if (data_array.numdims() > 2) {
+				data_array = af::moddims(data_array, n_features, data_array.dims(data_array.numdims() - 1));
+			}
+			label_array = label.data() - min_label;
+			target = af::constant(0, n_classes, N, s32);
+			target(af::range(N).T() *  n_classes + label_array)= 1;
+		}
 		if (shuffle_samples) {
 			//Generate shuffled array of indexes
 			af::sort(sorted_randomizer, shuffled_idx, af::randu(N));
@@ -0,0 +1,212 @@
+#include <data/CSVReader.h>
+#include <data/ChunkLayout.h>
+#include <data/Dataset.h>
+#include <mpi.h>
+#include <arrayfire.h>
+#include <omp.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "optionparser.h"
+struct Arg: public option::Arg
+{
+	static void printError(const char* msg1, const option::Option& opt, const char* msg2)
+	{
+		fprintf(stderr, "ERROR: %s", msg1);
+		fwrite(opt.name, opt.namelen, 1, stderr);
+		fprintf(stderr, "%s", msg2);
+	}
+
+	static option::ArgStatus Unknown(const option::Option& option, bool msg)
+	{
+		if (msg) printError("Unknown option '", option, "'\n");
+		return option::ARG_ILLEGAL;
+	}
+
+	static option::ArgStatus NonEmpty(const option::Option& option, bool msg)
+	{
+		if (option.arg != 0 && option.arg[0] != 0)
+			return option::ARG_OK;
+
+		if (msg) printError("Option '", option, "' requires a non-empty argument\n");
+		return option::ARG_ILLEGAL;
+	}
+
+	static option::ArgStatus Character(const option::Option& option, bool msg)
+	{
+		if (option.arg != 0 && option.arg[0] != 0 && (option.arg[1] == 0 || std::string(option.arg) == "\\t"))
+			return option::ARG_OK;
+
+		if (msg) printError("Option '", option, "' requires a single character\n");
+		return option::ARG_ILLEGAL;
+	}
+
+	static option::ArgStatus Numeric(const option::Option& option, bool msg)
+	{
+		char* endptr = 0;
+		if (option.arg != 0 && strtol(option.arg, &endptr, 10)){};
+		if (endptr != option.arg && *endptr == 0)
+			return option::ARG_OK;
+
+		if (msg) printError("Option '", option, "' requires an integer argument\n");
+		return option::ARG_ILLEGAL;
+	}
+
+	static option::ArgStatus ExistingFile(const option::Option& option, bool msg) {
+		struct stat buffer;
+		if (option.arg != 0 && stat(option.arg, &buffer) == 0) {
+			return option::ARG_OK;
+		}
+		if (msg) printError("Option '", option, "' requires a file argument\n");
+		return option::ARG_ILLEGAL;
+	}
+};
+
+enum optionIndex{O_UNKNOWN, O_HELP, O_INPUT, O_DELIMITER, O_HEADER, O_THREADS, O_OUTPUT, O_OUTPUT_DATA_SET,
+	O_OUTPUT_LABEL_SET, O_LABEL_COLUMN, O_CHUNK, O_DEFLATE, O_SHUFFLE};
+
+const option::Descriptor usage[] = {
+	{O_UNKNOWN, 0, "", "", Arg::Unknown,
+		"USAGE: \n"
+		"  juml-ingest --help | -h\n"
+		"  juml-ingest --input=F [--delimiter=,] [--header] [--threads=N] --output=F [--output-X=Data] "
+		"[--label-column=N [--output-Y=Label]] [--chunk=N] [--deflate=N [--shuffle]]"
+		"\n\nConverts a numeric CSV file into an HDF5 dataset. Each process parses the lines starting in its own byte "
+		"range of the file with OpenMP threads, the samples are written collectively in file order."
+		"\n\nInput Options:"},
+	{O_HELP, 0, "h", "help", option::Arg::None, "--help, -h\tPrint usage and exit."},
+	{O_INPUT, 0, "i", "input", Arg::ExistingFile, "--input PATH, -i PATH\tPath to the CSV file"},
+	{O_DELIMITER, 0, "", "delimiter", Arg::Character, "--delimiter <C>\tThe character separating the values, \\t for tabs"},
+	{O_HEADER, 0, "", "header", option::Arg::None, "--header\tSkip the first line holding the column names"},
+	{O_THREADS, 0, "t", "threads", Arg::Numeric, "--threads <N>, -t <N>\tNumber of OpenMP threads per process"},
+
+	{O_UNKNOWN, 0, "", "", NULL, 0},
+	{O_UNKNOWN, 0, "", "", Arg::Unknown, "\nOutput Options:"},
+	{O_OUTPUT, 0, "o", "output", Arg::NonEmpty, "--output PATH, -o PATH\tPath to the HDF5 file, will be created if it does not exist"},
+	{O_OUTPUT_DATA_SET, 0, "", "output-X", Arg::NonEmpty, "--output-X <S>\tSet the name of the Dataset inside the HDF5 file that receives the features"},
+	{O_LABEL_COLUMN, 0, "", "label-column", Arg::Numeric, "--label-column <N>\tWrite the zero-based column N as integer labels into a separate Dataset"},
+	{O_OUTPUT_LABEL_SET, 0, "", "output-Y", Arg::NonEmpty, "--output-Y <S>\tSet the name of the Dataset inside the HDF5 file that receives the labels"},
+	{O_CHUNK, 0, "", "chunk", Arg::Numeric, "--chunk <N>\tStore the datasets in chunks of N samples, zero aligns the chunks to the processes"},
+	{O_DEFLATE, 0, "", "deflate", Arg::Numeric, "--deflate <N>\tCompress the datasets with gzip level N"},
+	{O_SHUFFLE, 0, "", "shuffle", option::Arg::None, "--shuffle\tApply the byte shuffle filter before compression"},
+	{0, 0, 0, 0, 0, 0}
+};
+
+int main(int argc, char *argv[]) {
+	MPI_Init(&argc, &argv);
+	int mpi_size, mpi_rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
+
+	std::string inputPath;
+	std::string outputPath;
+	std::string xDatasetName = "Data";
+	std::string yDatasetName = "Label";
+	char delimiter = ',';
+	bool header = false;
+	int labelColumn = -1;
+	juml::ChunkLayout layout;
+
+	{
+		option::Stats stats(usage, argc - 1, argv + 1);
+		std::vector<option::Option> options(stats.options_max);
+		std::vector<option::Option> buffer(stats.buffer_max);
+		option::Parser parse(usage, argc - 1, argv + 1, &options[0], &buffer[0]);
+
+		if (parse.error()) {
+			MPI_Finalize();
+			return 1;
+		}
+		if (options[O_HELP] || argc == 1 || !options[O_INPUT] || !options[O_OUTPUT]) {
+			if (mpi_rank == 0) option::printUsage(std::cout, usage);
+			MPI_Finalize();
+			return options[O_HELP] ? 0 : 1;
+		}
+
+		inputPath = options[O_INPUT].arg;
+		outputPath = options[O_OUTPUT].arg;
+		if (options[O_OUTPUT_DATA_SET]) xDatasetName = options[O_OUTPUT_DATA_SET].arg;
+		if (options[O_OUTPUT_LABEL_SET]) yDatasetName = options[O_OUTPUT_LABEL_SET].arg;
+		if (options[O_DELIMITER]) delimiter = options[O_DELIMITER].arg[1] == 0 ? options[O_DELIMITER].arg[0] : '\t';
+		if (options[O_HEADER]) header = true;
+		if (options[O_THREADS]) omp_set_num_threads(std::max(1, atoi(options[O_THREADS].arg)));
+		if (options[O_LABEL_COLUMN]) labelColumn = atoi(options[O_LABEL_COLUMN].arg);
+		if (options[O_CHUNK]) {
+			layout.chunked = true;
+			layout.chunk_samples = static_cast<hsize_t>(std::max(0LL, atoll(options[O_CHUNK].arg)));
+		}
+		if (options[O_DEFLATE]) layout.deflate = atoi(options[O_DEFLATE].arg);
+		if (options[O_SHUFFLE]) layout.shuffle = true;
+	}
+	af::setBackend(AF_BACKEND_CPU);
+
+	double time_start = MPI_Wtime();
+	af::array data;
+	try {
+		juml::CSVReader reader(inputPath, delimiter, header);
+		data = reader.read();
+	} catch (const std::exception& e) {
+		// all nodes fail together, each reports its own cause
+		fprintf(stderr, "[%02d] ERROR: %s\n", mpi_rank, e.what());
+		MPI_Finalize();
+		return 1;
+	}
+	double time_parsed = MPI_Wtime();
+
+	// split off the label column
+	af::array labels;
+	long long n_features = data.isempty() ? 0 : data.dims(0);
+	MPI_Allreduce(MPI_IN_PLACE, &n_features, 1, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+	if (labelColumn >= 0 && (labelColumn >= n_features || n_features < 2)) {
+		if (mpi_rank == 0) fprintf(stderr, "ERROR: Invalid label column %d for %lld columns, at least one feature column has to remain\n", labelColumn, n_features);
+		MPI_Finalize();
+		return 1;
+	}
+	if (labelColumn >= 0 && !data.isempty()) {
+		labels = data(labelColumn, af::span).as(s32);
+		if (labelColumn == 0) {
+			data = data.rows(1, n_features - 1);
+		} else if (labelColumn == n_features - 1) {
+			data = data.rows(0, n_features - 2);
+		} else {
+			data = af::join(0, data.rows(0, labelColumn - 1), data.rows(labelColumn + 1, n_features - 1));
+		}
+	}
+
+	juml::WriteStatistics statistics;
+	try {
+		juml::Dataset features(data);
+		statistics = features.dump_equal_chunks(outputPath, xDatasetName, layout);
+		if (labelColumn >= 0) {
+			juml::Dataset label(labels);
+			juml::WriteStatistics label_statistics = label.dump_equal_chunks(outputPath, yDatasetName, layout);
+			statistics.raw_bytes += label_statistics.raw_bytes;
+			statistics.stored_bytes += label_statistics.stored_bytes;
+			statistics.seconds += label_statistics.seconds;
+		}
+	} catch (const std::exception& e) {
+		fprintf(stderr, "[%02d] ERROR: %s\n", mpi_rank, e.what());
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	double time_written = MPI_Wtime();
+
+	long long n_samples = data.isempty() ? 0 : data.dims(1);
+	MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+	double parse_time = time_parsed - time_start;
+	MPI_Allreduce(MPI_IN_PLACE, &parse_time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+	if (mpi_rank == 0) {
+		printf("Samples:  %lld\n", n_samples);
+		printf("Features: %lld\n", n_features - (labelColumn >= 0 ? 1 : 0));
+		printf("Parsing:  %3.4f s with %d processes x %d threads\n", parse_time, mpi_size, omp_get_max_threads());
+		printf("Writing:  %3.4f s, %.3f GB/s, compression ratio %.2f\n", time_written - time_parsed,
+		       statistics.bandwidth() / 1e9, statistics.compression_ratio());
+	}
+
+	MPI_Finalize();
+	return 0;
+}
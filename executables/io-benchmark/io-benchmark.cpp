@@ -0,0 +1,179 @@
+#include <data/Dataset.h>
+#include <data/IOProfile.h>
+#include <mpi.h>
+#include <arrayfire.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "optionparser.h"
+struct Arg: public option::Arg
+{
+	static void printError(const char* msg1, const option::Option& opt, const char* msg2)
+	{
+		fprintf(stderr, "ERROR: %s", msg1);
+		fwrite(opt.name, opt.namelen, 1, stderr);
+		fprintf(stderr, "%s", msg2);
+	}
+
+	static option::ArgStatus Unknown(const option::Option& option, bool msg)
+	{
+		if (msg) printError("Unknown option '", option, "'\n");
+		return option::ARG_ILLEGAL;
+	}
+
+	static option::ArgStatus NonEmpty(const option::Option& option, bool msg)
+	{
+		if (option.arg != 0 && option.arg[0] != 0)
+			return option::ARG_OK;
+
+		if (msg) printError("Option '", option, "' requires a non-empty argument\n");
+		return option::ARG_ILLEGAL;
+	}
+
+	static option::ArgStatus Numeric(const option::Option& option, bool msg)
+	{
+		char* endptr = 0;
+		if (option.arg != 0 && strtol(option.arg, &endptr, 10)){};
+		if (endptr != option.arg && *endptr == 0)
+			return option::ARG_OK;
+
+		if (msg) printError("Option '", option, "' requires an integer argument\n");
+		return option::ARG_ILLEGAL;
+	}
+
+	static option::ArgStatus ExistingFile(const option::Option& option, bool msg) {
+		struct stat buffer;
+		if (option.arg != 0 && stat(option.arg, &buffer) == 0) {
+			return option::ARG_OK;
+		}
+		if (msg) printError("Option '", option, "' requires a file argument\n");
+		return option::ARG_ILLEGAL;
+	}
+};
+
+enum optionIndex{O_UNKNOWN, O_HELP, O_BACKEND, O_DATAFILE, O_DATAFILE_DATA_SET, O_REPEAT, O_CB_NODES, O_STRIPING_FACTOR,
+	O_STRIPING_UNIT, O_ALIGNMENT};
+
+const option::Descriptor usage[] = {
+	{O_UNKNOWN, 0, "", "", Arg::Unknown,
+		"USAGE: \n"
+		"  juml-io-benchmark --help | -h\n"
+		"  juml-io-benchmark [--cpu|--opencl|--cuda] --data=F [--data-X=Data] [--repeat=3] [--cb-nodes=N [--cb-nodes=N ...]] "
+		"[--striping-factor=N] [--striping-unit=N] [--alignment=N]"
+		"\n\nLoads an HDF5 dataset in equal chunks with independent and collective MPI-IO transfers and reports the "
+		"achieved bandwidth in GB/s for each setting."
+		"\n\nGeneral Options:"},
+	{O_HELP, 0, "h", "help", option::Arg::None, "--help, -h\tPrint usage and exit."},
+	{O_BACKEND, 1, "", "cpu", option::Arg::None, "--cpu \tUse the ArrayFire CPU Backend (default)"},
+	{O_BACKEND, 2, "", "opencl", option::Arg::None, "--opencl\tUse the ArrayFire OpenCL Backend"},
+	{O_BACKEND, 3, "", "cuda", option::Arg::None, "--cuda \tUse the ArrayFire Cuda Backend"},
+	{O_REPEAT, 0, "r", "repeat", Arg::Numeric, "--repeat <N>, -r <N>\tNumber of timed loads per setting"},
+
+	{O_UNKNOWN, 0, "", "", NULL, 0},
+	{O_UNKNOWN, 0, "", "", Arg::Unknown, "\nI/O Options:"},
+	{O_CB_NODES, 0, "", "cb-nodes", Arg::Numeric, "--cb-nodes <N>\tAdd a collective setting with N collective buffering nodes"},
+	{O_STRIPING_FACTOR, 0, "", "striping-factor", Arg::Numeric, "--striping-factor <N>\tMPI-IO striping_factor hint for all settings"},
+	{O_STRIPING_UNIT, 0, "", "striping-unit", Arg::Numeric, "--striping-unit <N>\tMPI-IO striping_unit hint in bytes for all settings"},
+	{O_ALIGNMENT, 0, "", "alignment", Arg::Numeric, "--alignment <N>\tHDF5 object alignment in bytes for all settings"},
+
+	{O_UNKNOWN, 0, "", "", NULL, 0},
+	{O_UNKNOWN, 0, "", "", Arg::Unknown, "\nInput Options:"},
+	{O_DATAFILE, 0, "d", "data", Arg::ExistingFile, "--data PATH, -d PATH\tPath to HDF5 File, that contains the data"},
+	{O_DATAFILE_DATA_SET, 0, "", "data-X", Arg::NonEmpty, "--data-X <S>\tSet the name of the Dataset inside the HDF5 data file"},
+	{0, 0, 0, 0, 0, 0}
+};
+
+int main(int argc, char *argv[]) {
+	MPI_Init(&argc, &argv);
+	int mpi_size, mpi_rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
+
+	af::Backend backend = AF_BACKEND_CPU;
+	std::string filePath;
+	std::string datasetName = "Data";
+	int repeat = 3;
+	int striping_factor = 0;
+	int striping_unit = 0;
+	hsize_t alignment = 0;
+	std::vector<int> cb_nodes;
+
+	{
+		option::Stats stats(usage, argc - 1, argv + 1);
+		std::vector<option::Option> options(stats.options_max);
+		std::vector<option::Option> buffer(stats.buffer_max);
+		option::Parser parse(usage, argc - 1, argv + 1, &options[0], &buffer[0]);
+
+		if (parse.error()) {
+			MPI_Finalize();
+			return 1;
+		}
+		if (options[O_HELP] || argc == 1 || !options[O_DATAFILE]) {
+			if (mpi_rank == 0) option::printUsage(std::cout, usage);
+			MPI_Finalize();
+			return options[O_HELP] ? 0 : 1;
+		}
+
+		filePath = options[O_DATAFILE].arg;
+		if (options[O_DATAFILE_DATA_SET]) datasetName = options[O_DATAFILE_DATA_SET].arg;
+		if (options[O_REPEAT]) repeat = std::max(1, atoi(options[O_REPEAT].arg));
+		if (options[O_STRIPING_FACTOR]) striping_factor = atoi(options[O_STRIPING_FACTOR].arg);
+		if (options[O_STRIPING_UNIT]) striping_unit = atoi(options[O_STRIPING_UNIT].arg);
+		if (options[O_ALIGNMENT]) alignment = static_cast<hsize_t>(atoll(options[O_ALIGNMENT].arg));
+		if (options[O_BACKEND]) {
+			switch (options[O_BACKEND].last()->type()) {
+				case 1: backend = AF_BACKEND_CPU; break;
+				case 2: backend = AF_BACKEND_OPENCL; break;
+				case 3: backend = AF_BACKEND_CUDA; break;
+			}
+		}
+		for (option::Option* opt = options[O_CB_NODES]; opt; opt = opt->next()) {
+			cb_nodes.push_back(atoi(opt->arg));
+		}
+	}
+	af::setBackend(backend);
+
+	// independent transfers, collective transfers with the MPI default and each requested aggregator count
+	std::vector<juml::IOProfile> profiles;
+	profiles.push_back(juml::IOProfile(false, 0, striping_factor, striping_unit, alignment));
+	profiles.push_back(juml::IOProfile(true, 0, striping_factor, striping_unit, alignment));
+	for (int nodes : cb_nodes) {
+		profiles.push_back(juml::IOProfile(true, nodes, striping_factor, striping_unit, alignment));
+	}
+
+	juml::Dataset data(filePath, datasetName);
+	if (mpi_rank == 0) {
+		printf("%-12s %10s %10s %10s\n", "transfer", "cb_nodes", "best GB/s", "mean GB/s");
+	}
+	for (const juml::IOProfile& profile : profiles) {
+		data.set_io_profile(profile);
+		double best = 0.0;
+		double total = 0.0;
+		for (int i = 0; i < repeat; ++i) {
+			MPI_Barrier(MPI_COMM_WORLD);
+			double start = MPI_Wtime();
+			data.load_equal_chunks(true);
+			data.data().eval();
+			af::sync();
+			MPI_Barrier(MPI_COMM_WORLD);
+			double elapsed = MPI_Wtime() - start;
+
+			double bytes = static_cast<double>(data.data().bytes());
+			MPI_Allreduce(MPI_IN_PLACE, &bytes, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+			double bandwidth = bytes / elapsed / 1e9;
+			best = std::max(best, bandwidth);
+			total += bandwidth;
+		}
+		if (mpi_rank == 0) {
+			printf("%-12s %10d %10.3f %10.3f\n", profile.collective ? "collective" : "independent", profile.cb_nodes,
+			       best, total / repeat);
+		}
+	}
+
+	MPI_Finalize();
+	return 0;
+}
@@ -140,7 +140,10 @@ namespace juml {
 			const af::array& forward(const af::array& input) override {
 				// matmul(transpose(IxN), (Ixb))  =
 				// matmul(         (NxI), (Ixb))  = (Nxb)
-				af::array sumOfWeightedInputs = af::matmulTN(this->weights, input);
+				// sparse input (first layer) holds the samples as rows (bxI): transpose(matmul(bxI, IxN)) = (Nxb)
+				af::array sumOfWeightedInputs = input.issparse()
+					? af::transpose(af::matmul(input, this->weights))
+					: af::matmulTN(this->weights, input);
 				// Nxb += tile(Nx1, 1, b) = Nxb
 				sumOfWeightedInputs += af::tile(this->bias, 1, sumOfWeightedInputs.dims(1));
 				this->lastOutput = activation<T>(sumOfWeightedInputs);
@@ -153,10 +156,15 @@ namespace juml {
 				// scalar_mult(Nxb, Nxb) = Nxb
 				af::array delta = error * activation_deriv<T>(this->lastOutput);
 				// matmul(Ixb, transpose(Nxb)) = matmul(Ixb, bxN) = (Ixb)*(bxN) = IxN
-				this->weights_update += matmulNT(input, delta);
+				// sparse input (bxI): matmul(transpose(bxI), bxN) = IxN
+				if (input.issparse()) {
+					this->weights_update += af::matmul(input, af::transpose(delta), AF_MAT_TRANS);
+				} else {
+					this->weights_update += matmulNT(input, delta);
+				}
 				// (Nx1) += sum(Nxb, 1) = Nx1
 				this->bias_update += af::sum(delta, 1);
-				this->update_count += input.dims(1);
+				this->update_count += delta.dims(1);
 				// matmul(IxN, Nxb) = Ixb;
 				this->lastOutput = af::matmul(this->weights, delta);
 				return this->lastOutput;
@@ -20,6 +20,7 @@
 
 #include "core/Algorithm.h"
 #include "data/Dataset.h"
+#include "data/DatasetWriter.h"
 #include "preprocessing/ClassNormalizer.h"
 
 namespace juml {
@@ -55,13 +56,29 @@ namespace juml {
         /**
          * (Abstract) predict
          *
-         * Classifies a dataset according to the previously trained model.
+         * Classifies a dataset according to the previously trained model. The labels are distributed like X and
+         * across its communicator, implementations must not communicate on comm_ as predict_to classifies node-local
+         * blocks.
          *
          * @param X - The test data to classify
          * @returns The predicted labels
          */
         virtual Dataset predict(Dataset& X) const = 0;
 
+        /**
+         * predict_to
+         *
+         * Predicts a dataset block by block and appends the labels to an output writer, so that the memory
+         * consumption does not depend on the number of samples. Out-of-core datasets are read block-wise as well.
+         * The blocks are predicted on MPI_COMM_SELF, so that nodes with fewer blocks cannot miss a collective call.
+         * Collective operation on the writer's communicator.
+         *
+         * @param X          - The data to predict
+         * @param output     - The writer the labels are appended to
+         * @param block_size - The number of samples per block, defaults to the block size of X
+         */
+        void predict_to(Dataset& X, DatasetWriter& output, dim_t block_size=-1) const;
+
         /**
          * (Abstract) accuracy
          *
@@ -69,6 +69,16 @@ namespace juml {
          */
         af::array theta_;
 
+        /**
+         * Calculates the class probabilities of sparse samples in log space using sparse matrix products, without
+         * densifying the samples. Variances are floored at a small fraction of the largest one, as features that are
+         * zero within a class have none, and the joint log-likelihoods are taken relative to the most likely class
+         * before exponentiating, as their exponentials over many features would under- or overflow.
+         * @param X The samples as n x f sparse array in CSR format
+         * @returns The posterior probabilities for each class (c x n), summing to one per sample
+         */
+        af::array sparse_probability(const af::array& X) const;
+
     public:
         /**
          * GaussianNaiveBayes constructor
@@ -78,7 +88,8 @@ namespace juml {
         GaussianNaiveBayes(int backend=Backend::CPU, MPI_Comm comm=MPI_COMM_WORLD);
 
         /**
-         * Fits GNB classifier based on the passed training data and labels
+         * Fits GNB classifier based on the passed training data and labels. The training data may be out-of-core
+         * (@see Dataset::set_block_size) or sparse (@see SparseDataset), the labels are held in memory.
          * @param X The training dataset
          * @param y The label dataset to train on
          */
@@ -92,7 +103,8 @@ namespace juml {
         virtual Dataset predict(Dataset& X) const override;
 
         /**
-         * Predicts the probability estimates of the passed test data based on the previously fit model.
+         * Predicts the probability estimates of the passed test data based on the previously fit model. For sparse
+         * samples these are the posteriors, normalized per sample.
          * @param X The test dataset
          * @return The predicted probabilities for each class (f x n) as dataset
          */
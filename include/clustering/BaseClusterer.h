@@ -19,6 +19,7 @@
 #include "core/Algorithm.h"
 #include "core/Backend.h"
 #include "data/Dataset.h"
+#include "data/DatasetWriter.h"
 
 namespace juml {
     class BaseClusterer : public Algorithm {
@@ -46,10 +47,26 @@ namespace juml {
          * (Abstract) predict
          *
          * Predicts to which clusters new, unseen data items belong to, requires that the model was previously fit.
+         * The assignments are distributed like X and across its communicator, implementations must not communicate on
+         * comm_ as predict_to assigns node-local blocks.
          *
          * @returns The predicted cluster assignment
          */
         virtual Dataset predict(Dataset& X) const = 0;
+
+        /**
+         * predict_to
+         *
+         * Predicts a dataset block by block and appends the cluster assignments to an output writer, so that the memory
+         * consumption does not depend on the number of samples. Out-of-core datasets are read block-wise as well.
+         * The blocks are predicted on MPI_COMM_SELF, so that nodes with fewer blocks cannot miss a collective call.
+         * Collective operation on the writer's communicator.
+         *
+         * @param X          - The data to predict
+         * @param output     - The writer the cluster assignments are appended to
+         * @param block_size - The number of samples per block, defaults to the block size of X
+         */
+        void predict_to(Dataset& X, DatasetWriter& output, dim_t block_size=-1) const;
     };
 } // namespace juml
 
@@ -119,7 +119,8 @@ namespace juml {
          * cluster
          *
          * Internal implementation meat that performs the Lloyd iterations on the data. Performs convergence and
-         * maximum iteration checks. The centroids are synchronized across all nodes.
+         * maximum iteration checks. The centroids are synchronized across all nodes. The data is visited block-wise,
+         * so that out-of-core datasets are never held in memory as a whole.
          *
          * @param data - The training dataset passed to fit
          */
@@ -18,8 +18,11 @@
 
 #include <arrayfire.h>
 #include <hdf5.h>
+#include <mpi.h>
 #include <string>
 
+#include "data/IOProfile.h"
+
 namespace juml {
 namespace hdf5 {
     af::dtype h5_to_af(hid_t h5_type);
@@ -28,8 +31,9 @@ namespace hdf5 {
     hid_t open_file(const std::string &filename);
     void close_file(hid_t& file_id);
     void write_array(hid_t file_id, const std::string& dataset, const af::array& data);
-    hid_t popen_file(const std::string &filename, MPI_Comm comm);
+    hid_t popen_file(const std::string &filename, MPI_Comm comm, const IOProfile& profile=IOProfile());
     af::array pread_array(hid_t file_id, const std::string& dataset);
+    af::array pread_array(hid_t file_id, const std::string& dataset, af::dtype type);
 } // namespace hdf5
 } // namespace juml
 
@@ -0,0 +1,123 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: CSVReader.h
+*
+* Description: Header of class CSVReader
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include <arrayfire.h>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+namespace juml {
+    /**
+     * CSVReader
+     *
+     * Reads a numeric CSV file in parallel. The file is split into equal byte ranges, one per node, and each node
+     * parses the lines starting in its range, i.e. the ranges are aligned to line boundaries without any
+     * communication. The lines are parsed by the OpenMP threads of the node with a locale-independent float parser.
+     * The result is the local portion of a Dataset, which can be written to HDF5 with dump_equal_chunks.
+     *
+     * Example:
+     *
+     * @code
+     * CSVReader reader("train.csv", ',', true);
+     * Dataset X(reader.read());
+     * X.dump_equal_chunks("train.h5", "Data");
+     * @endcode
+     */
+    class CSVReader {
+    protected:
+        /**
+         * @var   filename_
+         * @brief The name of the CSV file
+         */
+        const std::string filename_;
+        /**
+         * @var   delimiter_
+         * @brief The character separating the values of a line
+         */
+        const char delimiter_;
+        /**
+         * @var   header_
+         * @brief True if the first line holds column names and is skipped
+         */
+        const bool header_;
+        /**
+         * @var   comm_
+         * @brief The MPI communicator the file is read by
+         */
+        const MPI_Comm comm_;
+        /**
+         * @var   mpi_rank_
+         * @brief The node's MPI rank in comm_
+         */
+        int mpi_rank_;
+        /**
+         * @var   mpi_size_
+         * @brief The size of comm_
+         */
+        int mpi_size_;
+
+        /**
+         * read_range
+         *
+         * Reads the lines starting in the node's byte range of the file. The preceding byte is read along to decide
+         * whether the range begins with a line, the last line is read beyond the range up to its end.
+         *
+         * @param buffer - Receives the local lines, including their line breaks
+         * @throws runtime_error if the file cannot be opened or read
+         */
+        void read_range(std::vector<char>& buffer) const;
+
+    public:
+        /**
+         * CSVReader constructor
+         *
+         * @param filename  - The name of the CSV file
+         * @param delimiter - The character separating the values of a line
+         * @param header    - True if the first line holds column names and is skipped
+         * @param comm      - The MPI communicator the file is read by
+         */
+        CSVReader(const std::string& filename, char delimiter=',', bool header=false, MPI_Comm comm=MPI_COMM_WORLD);
+
+        /**
+         * read
+         *
+         * Parses the local lines of the file. Empty lines are skipped, empty values are read as NaN. Collective
+         * operation on comm_.
+         *
+         * @returns The local samples as f32 array with one column per line (features x samples)
+         * @throws runtime_error if the file cannot be read on any node, nodes that could read it report so
+         * @throws domain_error  if a value is not a number or the lines have differing numbers of values
+         */
+        af::array read() const;
+
+        /**
+         * parse_float
+         *
+         * Parses a decimal floating point number with optional sign, fraction and exponent, independent of the
+         * locale. Surrounding blanks are skipped, nan and inf are accepted as well.
+         *
+         * @param cursor - The position of the number, advanced behind it and the following blanks on success
+         * @param end    - The end of the line
+         * @param value  - Receives the parsed number
+         * @returns True if a number has been parsed, false otherwise
+         */
+        static bool parse_float(const char*& cursor, const char* end, float& value);
+    }; // CSVReader
+} // namespace juml
+
+#endif // CSV_READER_H
@@ -0,0 +1,291 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: ChunkIterator.h
+*
+* Description: Header of class ChunkIterator
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef CHUNK_ITERATOR_H
+#define CHUNK_ITERATOR_H
+
+#include <arrayfire.h>
+#include <condition_variable>
+#include <hdf5.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "data/Dataset.h"
+
+namespace juml {
+    /**
+     * ChunkIterator
+     *
+     * Walks the local portion of a dataset in consecutive blocks of a fixed number of samples. Out-of-core datasets
+     * (@see Dataset::set_block_size) are read block-wise from the HDF5 file using hyperslab selections, so that only
+     * a single block is held in memory at any time. In-memory datasets are sliced without touching the disk, half
+     * precision and quantized samples are expanded to f32 block by block (@see Dataset::set_half_precision and
+     * Dataset::quantize).
+     *
+     * Example:
+     *
+     * @code
+     * Dataset X("train.h5", "data");
+     * X.set_block_size(1 << 16);
+     * X.load_equal_chunks();
+     *
+     * for (ChunkIterator blocks(X); blocks.has_next();) {
+     *     const af::array& block = blocks.next();
+     *     // process block
+     * }
+     * @endcode
+     */
+    class ChunkIterator {
+    protected:
+        /**
+         * @var   dataset_
+         * @brief The iterated dataset, must have been loaded using load_equal_chunks before
+         */
+        const Dataset& dataset_;
+        /**
+         * @var   block_size_
+         * @brief The number of samples per block, the last block may be smaller
+         */
+        dim_t block_size_;
+        /**
+         * @var   position_
+         * @brief The local sample offset of the next block
+         */
+        dim_t position_;
+        /**
+         * @var   offset_
+         * @brief The local sample offset of the current block
+         */
+        dim_t offset_;
+        /**
+         * @var   block_
+         * @brief The current block of samples
+         */
+        af::array block_;
+        /**
+         * @var   file_id_
+         * @brief The HDF5 file handle for out-of-core datasets, negative otherwise
+         */
+        hid_t file_id_;
+        /**
+         * @var   data_id_
+         * @brief The HDF5 dataset handle for out-of-core datasets, negative otherwise
+         */
+        hid_t data_id_;
+        /**
+         * @var   type_
+         * @brief The arrayfire type of the out-of-core samples
+         */
+        af::dtype type_;
+        /**
+         * @var   block_dims_
+         * @brief The arrayfire dimensions of a full out-of-core block
+         */
+        af::dim4 block_dims_;
+
+        /**
+         * @var   prefetch_
+         * @brief Whether blocks are read ahead by the background I/O thread
+         */
+        bool prefetch_;
+        /**
+         * @var   block_index_
+         * @brief The index of the next block handed out to the consumer
+         */
+        dim_t block_index_;
+        /**
+         * @var   buffers_
+         * @brief The two reusable host buffers the I/O thread reads into
+         */
+        std::vector<uint8_t> buffers_[2];
+        /**
+         * @var   filled_
+         * @brief Marks whether a buffer contains a block that has not been consumed yet
+         */
+        bool filled_[2];
+        /**
+         * @var   failed_
+         * @brief Marks whether reading the block of a buffer failed
+         */
+        bool failed_[2];
+        /**
+         * @var   durations_
+         * @brief The time in seconds it took to read the block of a buffer
+         */
+        double durations_[2];
+        /**
+         * @var   stop_
+         * @brief Signals the I/O thread to terminate
+         */
+        bool stop_;
+        /**
+         * @var   io_thread_
+         * @brief The background I/O thread
+         */
+        std::thread io_thread_;
+        /**
+         * @var   mutex_
+         * @brief Guards the buffer states
+         */
+        std::mutex mutex_;
+        /**
+         * @var   buffer_changed_
+         * @brief Notifies the consumer and the I/O thread about buffer state changes
+         */
+        std::condition_variable buffer_changed_;
+        /**
+         * @var   stall_times_
+         * @brief The time in seconds the consumer waited for each block
+         */
+        std::vector<double> stall_times_;
+        /**
+         * @var   read_times_
+         * @brief The time in seconds it took to read each block from disk
+         */
+        std::vector<double> read_times_;
+
+        /**
+         * slice
+         *
+         * Selects a range of samples along the sample dimension of an in-memory array.
+         *
+         * @param data  - The in-memory data
+         * @param begin - The local index of the first sample
+         * @param end   - The local index of the last sample (inclusive)
+         * @returns The selected samples
+         */
+        af::array slice(const af::array& data, dim_t begin, dim_t end) const;
+        /**
+         * block_count
+         *
+         * @param block - The index of the block
+         * @returns The number of samples in the block
+         */
+        dim_t block_count(dim_t block) const;
+        /**
+         * start_prefetching
+         *
+         * Starts the background I/O thread at the current block.
+         */
+        void start_prefetching();
+        /**
+         * stop_prefetching
+         *
+         * Terminates the background I/O thread and discards prefetched blocks.
+         */
+        void stop_prefetching();
+        /**
+         * prefetch
+         *
+         * Body of the background I/O thread, reads the blocks alternately into the two host buffers.
+         *
+         * @param first_block - The index of the first block to read
+         */
+        void prefetch(dim_t first_block);
+
+    public:
+        /**
+         * ChunkIterator constructor
+         *
+         * Opens the backing HDF5 file for out-of-core datasets. Collective operation on the dataset's communicator in
+         * this case.
+         *
+         * @param dataset    - The dataset to iterate, must be loaded
+         * @param block_size - The number of samples per block, defaults to the block size of the dataset or to 65536
+         *                     samples for in-memory half precision or quantized datasets. Zero yields the whole local
+         *                     portion as a single block.
+         * @throws runtime_error if the backing file cannot be opened
+         */
+        ChunkIterator(const Dataset& dataset, dim_t block_size=-1);
+        ChunkIterator(const ChunkIterator&) = delete;
+        ChunkIterator& operator=(const ChunkIterator&) = delete;
+        /**
+         * ChunkIterator destructor
+         *
+         * Stops the I/O thread and releases the HDF5 handles. Collective operation for out-of-core datasets.
+         */
+        ~ChunkIterator();
+
+        /**
+         * has_next
+         *
+         * @returns True if there are further blocks to be visited, false otherwise
+         */
+        bool has_next() const;
+        /**
+         * next
+         *
+         * Advances the iterator and provides the next block of samples.
+         *
+         * @returns The next block of samples, valid until the next call of next
+         * @throws out_of_range  if there are no further blocks
+         * @throws runtime_error if the block could not be read from disk
+         */
+        const af::array& next();
+        /**
+         * reset
+         *
+         * Rewinds the iterator to the first block, allows multiple passes over the data.
+         */
+        void reset();
+
+        /**
+         * offset
+         *
+         * @returns The local sample offset of the current block
+         */
+        dim_t offset() const;
+        /**
+         * global_offset
+         *
+         * @returns The global sample offset of the current block
+         */
+        dim_t global_offset() const;
+        /**
+         * n_blocks
+         *
+         * @returns The number of blocks of the local portion
+         */
+        dim_t n_blocks() const;
+        /**
+         * block_size
+         *
+         * @returns The number of samples per block
+         */
+        dim_t block_size() const;
+        /**
+         * is_prefetching
+         *
+         * @returns True if blocks are read ahead by a background I/O thread, false otherwise
+         */
+        bool is_prefetching() const;
+        /**
+         * stall_times
+         *
+         * @returns The time in seconds the consumer had to wait for each of the handed out blocks. Is close to zero
+         *          for compute bound applications and approaches the read times for I/O bound ones.
+         */
+        const std::vector<double>& stall_times() const;
+        /**
+         * read_times
+         *
+         * @returns The time in seconds it took to read each of the handed out blocks from disk, empty for in-memory
+         *          datasets
+         */
+        const std::vector<double>& read_times() const;
+    }; // ChunkIterator
+}  // juml
+#endif // CHUNK_ITERATOR_H
@@ -0,0 +1,116 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: ChunkLayout.h
+*
+* Description: Header of structs ChunkLayout and WriteStatistics
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef CHUNK_LAYOUT_H
+#define CHUNK_LAYOUT_H
+
+#include <hdf5.h>
+
+namespace juml {
+    /**
+     * ChunkLayout
+     *
+     * Describes the storage layout of HDF5 datasets written by Dataset::dump_equal_chunks. The defaults produce a
+     * contiguous, uncompressed dataset. Filters require a chunked layout and are applied using HDF5's parallel
+     * compressed writes, which need collective transfers (HDF5 1.10.2 or later).
+     */
+    struct ChunkLayout {
+        /**
+         * @var   chunked
+         * @brief Store the dataset in chunks instead of contiguously, implied by deflate and shuffle
+         */
+        bool    chunked;
+        /**
+         * @var   chunk_samples
+         * @brief The number of samples per chunk, a chunk always spans all features. Zero aligns the chunks to the
+         *        node partitions, i.e. uses the smallest local sample count bounded by max_chunk_bytes.
+         */
+        hsize_t chunk_samples;
+        /**
+         * @var   deflate
+         * @brief The gzip compression level from 1 (fastest) to 9 (smallest), zero disables compression
+         */
+        int     deflate;
+        /**
+         * @var   shuffle
+         * @brief Apply the byte shuffle filter before compression, usually improves the ratio for numeric data
+         */
+        bool    shuffle;
+        /**
+         * @var   max_chunk_bytes
+         * @brief The upper bound of the size of automatically determined chunks in bytes
+         */
+        hsize_t max_chunk_bytes;
+
+        /**
+         * ChunkLayout constructor
+         *
+         * @param chunked         - Use a chunked layout, defaults to false (contiguous)
+         * @param chunk_samples   - Samples per chunk, defaults to zero (aligned to the node partitions)
+         * @param deflate         - The gzip compression level, defaults to zero (uncompressed)
+         * @param shuffle         - Apply the shuffle filter, defaults to false
+         * @param max_chunk_bytes - Upper bound of automatic chunk sizes, defaults to 4 MiB
+         */
+        ChunkLayout(bool    chunked=false,
+                    hsize_t chunk_samples=0,
+                    int     deflate=0,
+                    bool    shuffle=false,
+                    hsize_t max_chunk_bytes=4 << 20);
+
+        /**
+         * is_chunked
+         *
+         * @returns True if the dataset is stored in chunks, i.e. chunking or any filter is requested
+         */
+        bool is_chunked() const;
+    }; // ChunkLayout
+
+    /**
+     * WriteStatistics
+     *
+     * Reports the outcome of a parallel dataset write, identical on all nodes.
+     */
+    struct WriteStatistics {
+        /**
+         * @var   raw_bytes
+         * @brief The uncompressed size of the written dataset in bytes
+         */
+        hsize_t raw_bytes = 0;
+        /**
+         * @var   stored_bytes
+         * @brief The size of the dataset in the file in bytes
+         */
+        hsize_t stored_bytes = 0;
+        /**
+         * @var   seconds
+         * @brief The wall time of the slowest node for creating and writing the dataset
+         */
+        double  seconds = 0.0;
+
+        /**
+         * compression_ratio
+         *
+         * @returns The ratio of raw to stored bytes, one if nothing has been written
+         */
+        double compression_ratio() const;
+        /**
+         * bandwidth
+         *
+         * @returns The write bandwidth with respect to the raw bytes in bytes per second
+         */
+        double bandwidth() const;
+    }; // WriteStatistics
+}  // juml
+#endif // CHUNK_LAYOUT_H
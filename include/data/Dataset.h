@@ -18,11 +18,96 @@
 
 #include <arrayfire.h>
 #include <hdf5.h>
+#include <memory>
 #include <mpi.h>
 #include <string>
 #include <sys/stat.h>
+#include <vector>
+
+#include "data/ChunkLayout.h"
+#include "data/IOProfile.h"
 
 namespace juml {
+    class ChunkIterator;
+    class DatasetGroup;
+
+    /**
+     * Moments
+     *
+     * The global per-feature statistics of a dataset as computed by Dataset::moments, identical on all nodes. All
+     * arrays are f64, so that counts and sums of squares stay exact for large datasets, and shaped like a single
+     * sample.
+     */
+    struct Moments {
+        /**
+         * @var   count
+         * @brief The number of samples
+         */
+        af::array count;
+        /**
+         * @var   mean
+         * @brief The mean value
+         */
+        af::array mean;
+        /**
+         * @var   m2
+         * @brief The sum of squared deviations from the mean
+         */
+        af::array m2;
+        /**
+         * @var   minimum
+         * @brief The smallest value
+         */
+        af::array minimum;
+        /**
+         * @var   maximum
+         * @brief The largest value
+         */
+        af::array maximum;
+        /**
+         * @var   type
+         * @brief The floating type of the samples, f64 for double precision samples and f32 otherwise
+         */
+        af::dtype type;
+
+        /**
+         * variance
+         *
+         * @returns The population variance, i.e. m2 divided by count
+         */
+        af::array variance() const;
+        /**
+         * stddev
+         *
+         * @returns The population standard deviation
+         */
+        af::array stddev() const;
+    }; // Moments
+
+    /**
+     * FileVersion
+     *
+     * Identifies the state of a file more precisely than its modification time with a resolution of seconds, so that
+     * e.g. the node-local cache detects a file rewritten or appended to within the same second.
+     */
+    struct FileVersion {
+        /**
+         * @var   modified_time
+         * @brief The UNIX timestamp of the last modification
+         */
+        time_t modified_time;
+        /**
+         * @var   modified_nanoseconds
+         * @brief The nanoseconds of the last modification in addition to the timestamp
+         */
+        long long modified_nanoseconds;
+        /**
+         * @var   size
+         * @brief The size of the file in bytes
+         */
+        long long size;
+    }; // FileVersion
+
     /**
      * Dataset
      *
@@ -30,6 +115,18 @@ namespace juml {
      * memory arrays. It is used in algorithms as a mean to pass data samples and labels and capture prediction results.
      */
     class Dataset {
+    public:
+        /**
+         * Partitioning
+         *
+         * Dataset partitioning symbols, i.e. how the samples x features matrix of a file is distributed
+         */
+        enum Partitioning {
+            SAMPLES,  /** Each node holds all features of a consecutive range of samples */
+            FEATURES, /** Each node holds all samples of a consecutive range of features */
+            BLOCKS    /** The nodes form a grid, each one holding a block of consecutive samples and features */
+        };
+
     protected:
         /**
          * @var   data_
@@ -75,17 +172,173 @@ namespace juml {
          * @brief The dimension index which contains the samples, usually the highest dimension, e.g. for 2D data the
          *        sample dimension is 1 or for 3D data 2.
          */
-        dim_t sample_dim_;
+        mutable dim_t sample_dim_;
         /**
          * @var   global_n_samples_
          * @brief The number of samples distributed across all nodes
          */
-        dim_t global_n_samples_;
+        mutable dim_t global_n_samples_;
         /**
          * @var   global_offset_
          * @brief The global sample offset of the local data portion, only meaningful for consecutive data chunks
          */
-        dim_t global_offset_;
+        mutable dim_t global_offset_;
+        /**
+         * @var   metadata_pending_
+         * @brief Whether the global metadata of a dataset created from an array has not been exchanged yet
+         */
+        mutable bool metadata_pending_ = false;
+        /**
+         * @var   sample_dim_pending_
+         * @brief Whether the sample dimension of a dataset created from an array is only guessed from the local array
+         *        and has not been agreed on yet
+         */
+        mutable bool sample_dim_pending_ = false;
+
+        /**
+         * @var   weights_
+         * @brief The relative portion sizes of the nodes the data has been partitioned with, empty for equal portions
+         */
+        std::vector<double> weights_;
+
+        /**
+         * @var   block_size_
+         * @brief The number of samples per block in out-of-core mode, zero if the local portion is held in memory
+         */
+        dim_t block_size_ = 0;
+        /**
+         * @var   prefetch_
+         * @brief Whether out-of-core blocks are read ahead by a background I/O thread
+         */
+        bool prefetch_ = false;
+        /**
+         * @var   local_dims_
+         * @brief The dimensions of the local portion as it is partitioned in the HDF5 file, also valid if data_ is
+         *        not held in memory
+         */
+        af::dim4 local_dims_;
+        /**
+         * @var   io_profile_
+         * @brief The MPI-IO transfer mode, hints and alignment used when accessing the HDF5 backing file
+         */
+        IOProfile io_profile_;
+
+        /**
+         * @var   features_
+         * @brief The strictly ascending indices of the loaded feature columns, empty to load all features
+         */
+        std::vector<hsize_t> features_;
+        /**
+         * @var   sample_begin_
+         * @brief The index of the first selected row in the HDF5 dataset
+         */
+        hsize_t sample_begin_ = 0;
+        /**
+         * @var   sample_end_
+         * @brief The index after the last selected row in the HDF5 dataset, zero to select up to the last row
+         */
+        hsize_t sample_end_ = 0;
+        /**
+         * @var   sample_stride_
+         * @brief The distance between two selected rows in the HDF5 dataset
+         */
+        hsize_t sample_stride_ = 1;
+
+        /**
+         * @var   convert_
+         * @brief Whether the samples are converted to target_type_ while being read
+         */
+        bool convert_ = false;
+        /**
+         * @var   target_type_
+         * @brief The arrayfire type the samples are converted to by HDF5 during the read, only meaningful if convert_
+         */
+        af::dtype target_type_ = f32;
+
+        /**
+         * @var   memory_map_
+         * @brief Whether contiguous HDF5 datasets are memory mapped instead of read on the CPU backend
+         */
+        bool memory_map_ = false;
+        /**
+         * @var   half_precision_
+         * @brief Whether the local samples are stored as f16 instead of the file or target type
+         */
+        bool half_precision_ = false;
+        /**
+         * @var   mapping_
+         * @brief The memory mapping backing data_ if it has been mapped. Released with the last dataset or view holding
+         *        it, the pages are unmapped once no array shares the mapped buffer anymore. Declared before mapped_ so
+         *        that the array is destroyed before the mapping.
+         */
+        std::shared_ptr<void> mapping_;
+        /**
+         * @var   mapped_
+         * @brief A reference to the memory mapped array. As the mapped buffer is therefore always shared, arrayfire
+         *        copies it before handing out a writable device pointer instead of modifying or releasing the mapping.
+         */
+        af::array mapped_;
+
+        /**
+         * @var   shared_metadata_
+         * @brief Whether only rank zero queries the backing file's metadata and loaded partitions are shared through
+         *        the process-wide load registry
+         */
+        bool shared_metadata_ = false;
+        /**
+         * @var   cache_directory_
+         * @brief The node-local directory partitions are cached in, empty if caching is disabled
+         */
+        std::string cache_directory_;
+        /**
+         * @var   scale_
+         * @brief The per-feature step of the u8 quantized samples (f32 column), empty if the samples are not quantized
+         */
+        af::array scale_;
+        /**
+         * @var   offset_
+         * @brief The per-feature value of the quantization level zero (f32 column), empty if not quantized
+         */
+        af::array offset_;
+        /**
+         * @var   partitioning_
+         * @brief The partitioning mode of subsequent loads
+         */
+        Partitioning partitioning_ = SAMPLES;
+        /**
+         * @var   feature_parts_
+         * @brief The number of feature ranges, the nodes form a (mpi_size_ / feature_parts_) x feature_parts_ grid
+         */
+        int feature_parts_ = 1;
+        /**
+         * @var   global_n_features_
+         * @brief The number of features of all nodes, only maintained if the features are partitioned
+         */
+        dim_t global_n_features_ = 0;
+        /**
+         * @var   feature_offset_
+         * @brief The global index of the first local feature, only maintained if the features are partitioned
+         */
+        dim_t feature_offset_ = 0;
+        /**
+         * @var   feature_comm_
+         * @brief The nodes holding the other features of the local samples, unset for the sample partitioning
+         */
+        std::shared_ptr<MPI_Comm> feature_comm_;
+        /**
+         * @var   sample_comm_
+         * @brief The nodes holding the other samples of the local features, unset for the sample partitioning
+         */
+        std::shared_ptr<MPI_Comm> sample_comm_;
+
+        /**
+         * resolve_metadata
+         *
+         * Exchanges the local sample shapes once in a single allgather and derives the agreed sample dimension, the
+         * global sample count and the global offset. Does nothing if the metadata is already known. Collective
+         * operation on comm_ while pending.
+         */
+        void resolve_metadata() const;
 
         /**
          * h5_to_af
@@ -96,7 +349,7 @@ namespace juml {
          * @returns The arrayfire type equivalent
          * @throws domain_error if there is no conversion equivalent
          */
-        af::dtype h5_to_af(hid_t h5_type);
+        af::dtype h5_to_af(hid_t h5_type) const;
 
         /**
          * af_to_h5
@@ -107,7 +360,352 @@ namespace juml {
          * @returns The HDF5 type handle equivalent
          * @throws domain_error if there is no conversion equivalent
          */
-        hid_t af_to_h5(af::dtype af_type);
+        hid_t af_to_h5(af::dtype af_type) const;
+
+        /**
+         * partition
+         *
+         * Determines the consecutive range of samples of this node. Without weights each sample range of the node grid
+         * is assigned an equal portion, where the first ranges hold one additional sample if the samples are not evenly
+         * divisible. Otherwise, the portions are proportional to the weights.
+         *
+         * @param n_samples - The global number of samples
+         * @param weights   - The relative portion size of each node in comm_, empty for equal portions
+         * @param offset    - Output, the global index of the first sample of this node
+         * @param count     - Output, the number of samples of this node
+         */
+        void partition(hsize_t n_samples, const std::vector<double>& weights, hsize_t& offset, hsize_t& count) const;
+        /**
+         * selected_samples
+         *
+         * @param n_rows - The number of rows in the HDF5 dataset
+         * @returns The number of samples in the selected sample range
+         */
+        hsize_t selected_samples(hsize_t n_rows) const;
+        /**
+         * check_weights
+         *
+         * @param weights - The relative portion size of each node in comm_
+         * @throws invalid_argument if there is not exactly one non-negative weight per node or all weights are zero
+         */
+        void check_weights(const std::vector<double>& weights) const;
+        /**
+         * check_sample_partitioning
+         *
+         * @param operation - The operation named in the error message
+         * @throws domain_error if the features are partitioned
+         */
+        void check_sample_partitioning(const std::string& operation) const;
+        /**
+         * local_features
+         *
+         * @param n_columns - The number of columns of the two-dimensional HDF5 dataset
+         * @returns The columns read by this node, i.e. the feature projection restricted to the node's feature range,
+         *          empty if all columns are read
+         * @throws domain_error if there are less features than feature ranges
+         */
+        std::vector<hsize_t> local_features(hsize_t n_columns) const;
+        /**
+         * load_chunks
+         *
+         * Loads the local consecutive portion of the data from the HDF5 file as determined by partition. Data will only
+         * be loaded once, unless it has changed on disk or the weights differ from the previous load.
+         *
+         * @param weights - The relative portion size of each node in comm_, empty for equal portions
+         * @param force   - Force the load data from disk, even if it has not been modified since the initial load
+         * @throws runtime_error if the file or dataset does not exist or cannot be accessed
+         * @throws domain_error  if the data in the HDF5 has more then four dimensions
+         */
+        virtual void load_chunks(const std::vector<double>& weights, bool force);
+        /**
+         * sample_extent
+         *
+         * Checks the dimensionality of an opened HDF5 dataset and determines the sample dimension accordingly.
+         *
+         * @param data_id - The HDF5 dataset handle
+         * @returns The global number of selected samples in the HDF5 dataset
+         * @throws runtime_error if the file space of the dataset cannot be accessed
+         * @throws domain_error  if the HDF5 dataset has more than four dimensions
+         */
+        hsize_t sample_extent(hid_t data_id);
+        /**
+         * load_partition
+         *
+         * Sets the global index and the local shape of the passed partition and loads, maps or, in out-of-core mode,
+         * only registers the local samples.
+         *
+         * @param data_id    - The HDF5 dataset handle
+         * @param n_samples  - The global number of selected samples
+         * @param position   - The global index of the first local sample
+         * @param chunk_size - The number of local samples
+         * @throws runtime_error if the samples cannot be read
+         * @throws domain_error  if the data type, dimensionality or feature projection is not supported
+         */
+        void load_partition(hid_t data_id, hsize_t n_samples, hsize_t position, hsize_t chunk_size);
+
+        /**
+         * open_file
+         *
+         * Opens the HDF5 backing file for parallel read access using the MPI-IO hints of the I/O profile. Collective
+         * operation on comm_.
+         *
+         * @returns The HDF5 file handle
+         * @throws runtime_error if the file cannot be accessed
+         */
+        hid_t open_file() const;
+        /**
+         * open_dataset
+         *
+         * Opens the HDF5 dataset in an opened backing file.
+         *
+         * @param file_id - The HDF5 file handle as returned by open_file
+         * @returns The HDF5 dataset handle
+         * @throws runtime_error if the dataset does not exist or cannot be accessed
+         */
+        hid_t open_dataset(hid_t file_id) const;
+        /**
+         * sample_type
+         *
+         * @param data_id - The HDF5 dataset handle
+         * @returns The target type if set, the arrayfire type equivalent of the HDF5 dataset's native type otherwise
+         * @throws domain_error if there is no conversion equivalent
+         */
+        af::dtype sample_type(hid_t data_id) const;
+        /**
+         * memory_type
+         *
+         * @param data_id - The HDF5 dataset handle
+         * @returns A copy of the HDF5 type the samples are read as, i.e. the target type if set or the native type of
+         *          the HDF5 dataset otherwise. Must be closed by the caller.
+         */
+        hid_t memory_type(hid_t data_id) const;
+        /**
+         * sample_dims
+         *
+         * @param data_id - The HDF5 dataset handle
+         * @param count   - The number of samples
+         * @returns The arrayfire dimensions of count consecutive samples of the HDF5 dataset with projected features
+         * @throws runtime_error if the file space of the dataset cannot be accessed
+         * @throws domain_error  if the HDF5 dataset has more than four dimensions or the feature projection does not
+         *                       match the dataset
+         */
+        af::dim4 sample_dims(hid_t data_id, hsize_t count) const;
+        /**
+         * partition_key
+         *
+         * @param weights - The relative portion sizes of the partition
+         * @returns A key identifying the node's partition of the HDF5 dataset, including the selection and the
+         *          conversion
+         */
+        std::string partition_key(const std::vector<double>& weights) const;
+        /**
+         * registry_key
+         *
+         * @param weights - The relative portion sizes of the partition
+         * @returns A key identifying the node's partition of the HDF5 dataset in the load registry, the partition key
+         *          extended by the active arrayfire backend and device
+         */
+        std::string registry_key(const std::vector<double>& weights) const;
+        /**
+         * read_partition
+         *
+         * Opens the HDF5 file and reads the node's partition, @see load_partition. Collective operation on comm_.
+         *
+         * @param weights - The relative portion sizes of the nodes, empty for equal portions
+         * @throws runtime_error if the file or dataset does not exist or cannot be accessed
+         * @throws domain_error  if the data in the HDF5 has more then four dimensions
+         */
+        void read_partition(const std::vector<double>& weights);
+        /**
+         * is_registered
+         *
+         * @returns True if loaded partitions are shared through the load registry, @see set_shared_metadata
+         */
+        bool is_registered() const;
+        /**
+         * is_cached
+         *
+         * @returns True if loaded partitions are kept in the node-local cache, @see set_cache_directory
+         */
+        bool is_cached() const;
+        /**
+         * lookup_partition
+         *
+         * Takes the node's partition from the load registry or the node-local cache instead of the HDF5 file. Either
+         * is only used if all nodes hold a valid copy, a cache hit is registered. Collective operation on comm_ if
+         * the registry or the cache is enabled.
+         *
+         * @param weights - The relative portion sizes of the nodes, empty for equal portions
+         * @param version - The version of the HDF5 file
+         * @param force   - Skip the lookup, so that the partition is read anew
+         * @returns True if the partition has been loaded, false if it has to be read from the HDF5 file
+         */
+        bool lookup_partition(const std::vector<double>& weights, const FileVersion& version, bool force);
+        /**
+         * store_partition
+         *
+         * Writes a freshly read partition to the node-local cache and the load registry, if enabled.
+         *
+         * @param weights - The relative portion sizes of the nodes, empty for equal portions
+         * @param version - The version of the HDF5 file the partition has been read from, determined before reading
+         */
+        void store_partition(const std::vector<double>& weights, const FileVersion& version);
+        /**
+         * register_partition
+         *
+         * Adds the node's partition to the load registry, if enabled.
+         *
+         * @param weights  - The relative portion sizes of the nodes, empty for equal portions
+         * @param mod_time - The modification time of the HDF5 file the partition has been read from
+         */
+        void register_partition(const std::vector<double>& weights, time_t mod_time);
+        /**
+         * cache_path
+         *
+         * @param key - The partition key
+         * @returns The path of the node-local cache file of the partition
+         */
+        std::string cache_path(const std::string& key) const;
+        /**
+         * read_cache
+         *
+         * Loads the node's partition from the node-local cache, memory mapped if requested. The header is validated
+         * before it is used, a corrupt or foreign file is treated as a miss.
+         *
+         * @param key     - The partition key
+         * @param version - The version of the HDF5 file the cache must have been created from
+         * @returns True if a valid cache file has been loaded, false otherwise
+         */
+        bool read_cache(const std::string& key, const FileVersion& version);
+        /**
+         * write_cache
+         *
+         * Stores the node's partition as raw binary with a header in the node-local cache. The file is written to a
+         * temporary name and renamed, so that concurrent jobs never see partial files. Failures are ignored, as the
+         * cache is optional.
+         *
+         * @param key     - The partition key
+         * @param version - The version of the HDF5 file the partition has been read from
+         */
+        void write_cache(const std::string& key, const FileVersion& version) const;
+        /**
+         * file_version
+         *
+         * Collective if shared metadata access is enabled, as rank zero broadcasts the version.
+         *
+         * @returns The modification time and size of the HDF5 backing file
+         * @throws runtime_error if the file cannot be accessed
+         */
+        FileVersion file_version() const;
+        /**
+         * read_samples
+         *
+         * Reads a consecutive range of the selected samples, i.e. (strided) rows in the HDF5 dataset restricted to the
+         * projected features, using a hyperslab selection into a raw buffer. The buffer must be large enough to hold
+         * the samples in their memory type.
+         *
+         * @param data_id  - The HDF5 dataset handle
+         * @param offset   - The global index of the first selected sample to read
+         * @param count    - The number of samples to read
+         * @param buffer   - The target (host or CPU device) memory
+         * @param transfer - The HDF5 dataset transfer property list, defaults to H5P_DEFAULT (independent)
+         * @returns A negative value on failure
+         */
+        herr_t read_samples(hid_t data_id, hsize_t offset, hsize_t count, void* buffer,
+                            hid_t transfer=H5P_DEFAULT) const;
+        /**
+         * read_samples
+         *
+         * Reads a consecutive range of the selected samples, i.e. (strided) rows in the HDF5 dataset restricted to the
+         * projected features, using a hyperslab selection.
+         *
+         * @param data_id  - The HDF5 dataset handle
+         * @param offset   - The global index of the first selected sample to read
+         * @param count    - The number of samples to read
+         * @param transfer - The HDF5 dataset transfer property list, defaults to H5P_DEFAULT (independent)
+         * @returns An arrayfire array containing the samples along the sample dimension
+         * @throws runtime_error if the hyperslab cannot be selected or read
+         * @throws domain_error  if the data type or dimensionality of the HDF5 dataset is not supported
+         */
+        af::array read_samples(hid_t data_id, hsize_t offset, hsize_t count, hid_t transfer=H5P_DEFAULT) const;
+        /**
+         * map_samples
+         *
+         * Memory maps a consecutive range of samples of a contiguous, unfiltered HDF5 dataset stored in native byte
+         * order and wraps the mapped file range in an arrayfire array without copying. The mapping is read-only and
+         * private, modifications copy the samples first. Only available on the CPU backend.
+         *
+         * @param data_id - The HDF5 dataset handle
+         * @param offset  - The global index of the first sample to map
+         * @param count   - The number of samples to map
+         * @returns True if the samples have been mapped into data_, false if the dataset cannot be mapped
+         */
+        bool map_samples(hid_t data_id, hsize_t offset, hsize_t count);
+        /**
+         * compact
+         *
+         * Converts freshly read samples to the storage representation of the dataset, i.e. quantizes them with the
+         * current parameters or narrows them to half precision.
+         *
+         * @param samples - The samples in the file or target type
+         * @returns The samples as stored in data_
+         */
+        af::array compact(const af::array& samples) const;
+        /**
+         * map_file
+         *
+         * Memory maps a byte range of a file read-only and privately and wraps it in an arrayfire array without
+         * copying. Only available on the CPU backend.
+         *
+         * @param path  - The path of the file
+         * @param begin - The file offset of the first byte
+         * @param dims  - The arrayfire dimensions of the mapped data
+         * @param type  - The arrayfire type of the mapped data
+         * @param bytes - The number of bytes to map
+         * @returns True if the range has been mapped into data_, false otherwise
+         */
+        bool map_file(const std::string& path, off_t begin, const af::dim4& dims, af::dtype type, size_t bytes);
+
+        /**
+         * sample_layout
+         *
+         * Gathers the local sample counts of all nodes and the shape of a single sample. Collective operation on comm_.
+         *
+         * @param counts       - Output, the number of local samples of each node in comm_
+         * @param dimensions   - Output, the dimensions of a non-empty local portion
+         * @param type         - Output, the arrayfire type of the samples
+         * @param sample_bytes - Output, the size of a single sample in bytes
+         * @returns False if there are no samples on any node, true otherwise
+         * @throws invalid_argument if the sample shapes or types of the nodes differ
+         * @throws runtime_error    if the dataset is out-of-core
+         */
+        bool sample_layout(std::vector<dim_t>& counts, af::dim4& dimensions, af::dtype& type,
+                           size_t& sample_bytes) const;
+        /**
+         * exchange
+         *
+         * Sends consecutive groups of local samples to the nodes in rank order using MPI_Alltoallv and replaces the
+         * local portion by the received samples, also ordered by source rank. Does not update the global offset.
+         * Collective operation on comm_.
+         *
+         * @param send_counts  - The number of samples sent to each node in comm_
+         * @param dimensions   - The dimensions of a non-empty local portion as returned by sample_layout
+         * @param type         - The arrayfire type of the samples
+         * @param sample_bytes - The size of a single sample in bytes
+         * @throws runtime_error if the data exchange fails
+         */
+        void exchange(const std::vector<int>& send_counts, af::dim4 dimensions, af::dtype type, size_t sample_bytes);
+        /**
+         * permute
+         *
+         * Reorders the local samples.
+         *
+         * @param order - The local sample indices in their new order
+         */
+        void permute(const std::vector<unsigned int>& order);
+
+        friend class ChunkIterator;
+        friend class DatasetGroup;
 
     public:
         /**
@@ -123,13 +721,24 @@ namespace juml {
         /**
          * Dataset constructor
          *
-         * Creates a new dataset from in-memory data. It is considered to be the local portion of the global data.
+         * Creates a new dataset from in-memory data. It is considered to be the local portion of the global data. No
+         * communication takes place, the global metadata is exchanged lazily on the first call of global_n_samples or
+         * global_offset, which is therefore collective. Unless passed, the sample dimension has to be agreed on as
+         * well, as a local array may lack trailing dimensions, e.g. a single sample of 3D data. The first call of
+         * n_samples or sample_dim is then collective, too.
          *
-         * @param filename - The name of the HDF5 file to load
-         * @param dataset  - The HDF5 dataset name
-         * @param comm     - The MPI comm the data will be distributed across
+         * @param data       - The local portion of the samples
+         * @param comm       - The MPI comm the data will be distributed across
+         * @param sample_dim - The dimension index which contains the samples, the same on all nodes, negative if it
+         *                     has to be agreed on
+         */
+        Dataset(const af::array& data, MPI_Comm comm=MPI_COMM_WORLD, dim_t sample_dim=-1);
+        /**
+         * Dataset destructor
+         *
+         * Releases the local samples. A memory mapping is unmapped once no array copied from data() is left.
          */
-        Dataset(const af::array& data, MPI_Comm comm=MPI_COMM_WORLD);
+        virtual ~Dataset();
 
         /**
          * load_equal_chunks
@@ -142,23 +751,430 @@ namespace juml {
          * @throws runtime_error if the file or dataset does not exist or cannot be accessed
          * @throws domain_error  if the data in the HDF5 has more then four dimensions
          */
-        void load_equal_chunks(bool force=false);
+        virtual void load_equal_chunks(bool force=false);
+        /**
+         * load_weighted_chunks
+         *
+         * Loads data from a HDF5 file on disk like load_equal_chunks, but the consecutive portion sizes are
+         * proportional to the passed weights, e.g. the throughput of heterogeneous nodes. The global sample count and
+         * offsets remain consistent, so that the algorithms work unchanged. If no weights are passed they are
+         * determined by calibrate_weights on every (re)load. Collective operation on comm_.
+         *
+         * @param weights - The relative portion size of each node in comm_, must be identical on all nodes, defaults
+         *                  to empty (auto calibration)
+         * @param force   - Force the load data from disk, even if it has not been modified since the initial load
+         * @throws invalid_argument if there is not exactly one non-negative weight per node or all weights are zero
+         * @throws runtime_error    if the file or dataset does not exist or cannot be accessed
+         * @throws domain_error     if the data in the HDF5 has more then four dimensions
+         */
+        void load_weighted_chunks(const std::vector<double>& weights=std::vector<double>(), bool force=false);
+        /**
+         * load_incremental
+         *
+         * Extends a loaded dataset by the rows that have been appended to the HDF5 dataset since, e.g. by an
+         * extendible dataset growing during ingest, without re-reading the already loaded samples. The appended rows
+         * are added to the portion of the last node, keeping the nodes' portions consecutive, and optionally
+         * rebalanced in memory afterwards. The HDF5 dataset is assumed to only grow, a shrunk dataset is reloaded
+         * entirely. Falls back to load_equal_chunks if nothing has been loaded yet or the dataset is out-of-core.
+         * Collective operation on comm_.
+         *
+         * @param rebalance - Redistribute the samples into equal portions after appending, defaults to false
+         * @throws runtime_error if the file or dataset does not exist or cannot be accessed
+         * @throws domain_error  if the data in the HDF5 has more then four dimensions
+         */
+        virtual void load_incremental(bool rebalance=false);
+        /**
+         * calibrate_weights
+         *
+         * Measures the throughput of each node in comm_ by timing a short series of matrix multiplications on the
+         * active arrayfire backend. Collective operation on comm_.
+         *
+         * @param size        - The edge length of the square matrices, defaults to 512
+         * @param repetitions - The number of timed multiplications, defaults to 5
+         * @returns The measured throughput of each node in comm_, identical on all nodes
+         */
+        std::vector<double> calibrate_weights(dim_t size=512, int repetitions=5) const;
+        /**
+         * weights
+         *
+         * @returns The relative portion sizes the data has been loaded with, empty for equal portions
+         */
+        const std::vector<double>& weights() const;
+
+        /**
+         * set_block_size
+         *
+         * Switches the dataset into out-of-core mode. A subsequent load_equal_chunks will only determine the local
+         * partition, the actual samples are then read in blocks of block_size samples using a ChunkIterator. The
+         * memory consumption is therefore bounded by the block size and not by the partition size.
+         *
+         * @param block_size - The number of samples per block, zero keeps the whole local portion in memory
+         * @param prefetch   - Read the next block in a background I/O thread while the current one is processed using
+         *                     two reusable host buffers. Requires MPI_THREAD_MULTIPLE and a thread-safe HDF5 build,
+         *                     falls back to synchronous reads otherwise. Defaults to false.
+         * @throws invalid_argument if block_size is negative
+         */
+        void set_block_size(dim_t block_size, bool prefetch=false);
+        /**
+         * block_size
+         *
+         * @returns The number of samples per block in out-of-core mode, zero if the data is held in memory
+         */
+        dim_t block_size() const;
+        /**
+         * is_streamed
+         *
+         * @returns True if the dataset is backed by a file and read block-wise, false if held in memory
+         */
+        bool is_streamed() const;
+        /**
+         * prefetch
+         *
+         * @returns True if out-of-core blocks are prefetched in the background, false otherwise
+         */
+        bool prefetch() const;
+
+        /**
+         * set_features
+         *
+         * Projects the samples of a two-dimensional HDF5 dataset onto a subset of its features (columns). Only the
+         * selected columns are read from disk using a hyperslab selection.
+         *
+         * @param features - The strictly ascending feature indices, empty to load all features
+         * @throws invalid_argument if the feature indices are not strictly ascending
+         */
+        void set_features(const std::vector<hsize_t>& features);
+        /**
+         * features
+         *
+         * @returns The projected feature indices, empty if all features are loaded
+         */
+        const std::vector<hsize_t>& features() const;
+        /**
+         * set_partitioning
+         *
+         * Selects how subsequent loads distribute a two-dimensional HDF5 dataset. Wide data, i.e. many more features
+         * than samples, is better partitioned along the features so that no node has to hold entire samples. In the
+         * BLOCKS mode node r holds the (r / feature_parts)-th sample range and the (r % feature_parts)-th feature
+         * range, FEATURES and SAMPLES are the grids with a single sample or feature range. The feature ranges split
+         * the feature projection if one is set. Per-feature statistics are then reduced along sample_comm, per-sample
+         * quantities such as distances along feature_comm. Weighted partitions, sparse and NumPy datasets, dumping and
+         * the sample exchanges require the sample partitioning, load_incremental reloads the whole grid. Partitions
+         * of split features are neither cached nor shared through the load registry. Collective operation on comm_.
+         *
+         * @param mode          - The partitioning mode
+         * @param feature_parts - The number of feature ranges of the BLOCKS grid, has to divide the number of nodes,
+         *                        zero selects a balanced grid. Ignored by the other modes.
+         * @throws invalid_argument if feature_parts is negative or does not divide the number of nodes
+         */
+        void set_partitioning(Partitioning mode, int feature_parts=0);
+        /**
+         * partitioning
+         *
+         * @returns The partitioning mode of subsequent loads
+         */
+        Partitioning partitioning() const;
+        /**
+         * feature_parts
+         *
+         * @returns The number of feature ranges the nodes are arranged in
+         */
+        int feature_parts() const;
+        /**
+         * sample_parts
+         *
+         * @returns The number of sample ranges the nodes are arranged in
+         */
+        int sample_parts() const;
+        /**
+         * comm
+         *
+         * @returns The communicator the samples are distributed across
+         */
+        MPI_Comm comm() const;
+        /**
+         * feature_comm
+         *
+         * @returns The communicator of the nodes holding the other features of the local samples, MPI_COMM_SELF if
+         *          the features are not partitioned
+         */
+        MPI_Comm feature_comm() const;
+        /**
+         * sample_comm
+         *
+         * @returns The communicator of the nodes holding the other samples of the local features, comm_ if the
+         *          features are not partitioned
+         */
+        MPI_Comm sample_comm() const;
+        /**
+         * global_n_features
+         *
+         * @returns The number of features of all nodes
+         */
+        dim_t global_n_features() const;
+        /**
+         * feature_offset
+         *
+         * @returns The global index of the first local feature
+         */
+        dim_t feature_offset() const;
+        /**
+         * set_sample_range
+         *
+         * Restricts loading to a (strided) range of rows in the HDF5 dataset, e.g. every 100th sample. Only the
+         * selected rows are read from disk using a hyperslab selection. The selected samples are partitioned across
+         * the nodes as if they were the entire dataset, i.e. the global sample count and offsets refer to the
+         * selection.
+         *
+         * @param begin  - The index of the first row to select
+         * @param end    - The index after the last row to select, defaults to zero (up to the last row)
+         * @param stride - The distance between two selected rows, defaults to one
+         * @throws invalid_argument if stride is zero or end precedes begin
+         */
+        void set_sample_range(hsize_t begin, hsize_t end=0, hsize_t stride=1);
+
+        /**
+         * set_target_type
+         *
+         * Sets the arrayfire type the samples are loaded as. The conversion is performed by HDF5 while reading into the
+         * final buffer, so that no intermediate array of the file type is created. Memory mapping is only applied if
+         * the target type matches the file type.
+         *
+         * @param type - The target arrayfire type
+         * @throws domain_error if there is no HDF5 equivalent of the type
+         */
+        void set_target_type(af::dtype type);
+        /**
+         * clear_target_type
+         *
+         * Loads the samples in the native type of the HDF5 dataset again.
+         */
+        void clear_target_type();
+        /**
+         * has_target_type
+         *
+         * @returns True if the samples are converted to a target type while being read, false otherwise
+         */
+        bool has_target_type() const;
+        /**
+         * target_type
+         *
+         * @returns The target type, only meaningful if has_target_type returns true
+         */
+        af::dtype target_type() const;
+
+        /**
+         * set_half_precision
+         *
+         * Stores the local samples as f16 after loading, which halves the memory of the node's portion and the
+         * bandwidth of every pass over it. The samples are read in the file or target type and converted once, the
+         * algorithms widen them to f32 block-wise while processing, see widen. Memory mapping is not applied to
+         * half precision datasets, out-of-core blocks are streamed as read.
+         *
+         * @param half_precision - Enable or disable the half precision storage
+         */
+        void set_half_precision(bool half_precision);
+        /**
+         * half_precision
+         *
+         * @returns True if the local samples are stored as f16, false otherwise
+         */
+        bool half_precision() const;
+
+        /**
+         * set_memory_map
+         *
+         * Enables zero-copy loading on the CPU backend. Subsequent loads memory map the node's portion of contiguous,
+         * uncompressed HDF5 datasets in native byte order instead of reading them, so that pages are only faulted in
+         * when accessed. Other datasets and backends transparently fall back to regular reads. The pages are mapped
+         * read-only, arrayfire copies them before any in-place modification. Arrays copied from data() keep the
+         * mapping alive beyond the next load or the destruction of the dataset.
+         *
+         * @param memory_map - Enable or disable memory mapping
+         */
+        void set_memory_map(bool memory_map);
+        /**
+         * memory_map
+         *
+         * @returns True if memory mapping has been requested, false otherwise
+         */
+        bool memory_map() const;
+        /**
+         * is_memory_mapped
+         *
+         * @returns True if the local portion is currently backed by a memory mapping of the HDF5 file
+         */
+        bool is_memory_mapped() const;
+
+        /**
+         * set_shared_metadata
+         *
+         * Enables shared metadata access for large node counts. Rank zero is then the only node that stats the backing
+         * file, the modification time is broadcast to the other nodes. Additionally, loaded partitions are recorded in
+         * a process-wide registry, so that loading the same (file, dataset, partition) again, e.g. through another
+         * dataset instance, costs a broadcast and an allreduce instead of a read while any dataset still holds the
+         * partition. The registry does not keep partitions alive on its own. All nodes of the communicator must use
+         * the same mode. Out-of-core and memory mapped datasets are not registered.
+         *
+         * @param shared - Enable or disable shared metadata access
+         */
+        void set_shared_metadata(bool shared);
+        /**
+         * shared_metadata
+         *
+         * @returns True if shared metadata access is enabled, false otherwise
+         */
+        bool shared_metadata() const;
+        /**
+         * set_cache_directory
+         *
+         * Enables the node-local partition cache, e.g. on a local scratch disk. After loading from the HDF5 file each
+         * node stores its decoded partition there as raw binary with a header (partition bounds, shape, type and the
+         * file's size and modification time with nanoseconds). Subsequent loads, also by later jobs with the same node
+         * count, selection and file version, read the cache sequentially instead of the HDF5 file, or map it if memory
+         * mapping is enabled. The cache is only used if it is valid on all nodes. All nodes of the communicator must
+         * use the same setting. Out-of-core datasets are not cached.
+         *
+         * @param directory - The existing cache directory, empty to disable caching
+         */
+        void set_cache_directory(const std::string& directory);
+        /**
+         * cache_directory
+         *
+         * @returns The node-local cache directory, empty if caching is disabled
+         */
+        const std::string& cache_directory() const;
+
+        /**
+         * clear_registry
+         *
+         * Forgets all partitions recorded in the process-wide load registry, subsequent loads read them again.
+         */
+        static void clear_registry();
+        /**
+         * widen
+         *
+         * Converts half precision samples to f32 for computation, other types are passed through unchanged.
+         *
+         * @param data - A block of samples
+         * @returns The samples as f32 if they are stored as f16, otherwise data itself
+         */
+        static af::array widen(const af::array& data);
+
+        /**
+         * set_io_profile
+         *
+         * Sets the MPI-IO transfer mode, hints and HDF5 alignment used for subsequent loads and dumps. Collective
+         * transfers only apply to load_equal_chunks, out-of-core blocks are always read independently as the number of
+         * blocks may differ between the nodes.
+         *
+         * @param profile - The I/O profile
+         */
+        void set_io_profile(const IOProfile& profile);
+        /**
+         * io_profile
+         *
+         * @returns The I/O profile used when accessing the HDF5 backing file
+         */
+        const IOProfile& io_profile() const;
 
         /**
          * dump_equal_chunks
          *
          * Stores data in the dataset on the disk in an HDF5 file. The data is assumed to be consecutive, offset by the
-         * multiples of the chunk sizes of each MPI node's rank in the communicator.
+         * multiples of the chunk sizes of each MPI node's rank in the communicator. The dataset is created
+         * collectively, optionally chunked and compressed according to the passed layout, and written with the
+         * transfer mode of the I/O profile, always collectively if filters are set. Quantized and half precision
+         * samples are written as f32 values.
          *
          * @param filename - The name of the HDF5 file to store the data in, will be created if it does not exist.
          * @param dataset  - The name of the HDF5 dataset to store the data in
+         * @param layout   - The storage layout, defaults to a contiguous, uncompressed dataset
+         * @returns The raw and stored size of the dataset and the time it took to write it, identical on all nodes
+         * @throws runtime_error if compression is requested but the deflate filter is not available, or if the file
+         *                       cannot be opened or writing the samples fails on any node
          */
-        void dump_equal_chunks(const std::string& filename, const std::string& dataset);
+        WriteStatistics dump_equal_chunks(const std::string& filename, const std::string& dataset,
+                                          const ChunkLayout& layout=ChunkLayout());
+
+        /**
+         * redistribute
+         *
+         * Moves samples between the nodes in memory, e.g. to rebalance skewed portions after filtering. The global
+         * order of the samples is preserved, i.e. the nodes hold consecutive ranges in rank order afterwards and the
+         * global offset is updated accordingly. Collective operation on comm_.
+         *
+         * @param counts - The number of samples each node in comm_ should hold, must be identical on all nodes and
+         *                 sum up to the global number of samples, defaults to empty (equal portions)
+         * @throws invalid_argument if the counts are invalid or the sample shapes or types of the nodes differ
+         * @throws runtime_error    if the dataset is out-of-core or the data exchange fails
+         */
+        void redistribute(const std::vector<dim_t>& counts=std::vector<dim_t>());
+
+        /**
+         * shuffle
+         *
+         * Globally shuffles the samples across all nodes. Each sample is sent to a random node with a single
+         * MPI_Alltoallv, the received samples are randomly reordered and the previous portion sizes are restored
+         * afterwards. The permutation only depends on the seed and the portion sizes, datasets with identical
+         * partitions, e.g. data and labels, are therefore shuffled consistently. Collective operation on comm_.
+         *
+         * @param seed - The seed of the random permutation, must be identical on all nodes
+         * @throws invalid_argument if the sample shapes or types of the nodes differ
+         * @throws runtime_error    if the dataset is out-of-core or the data exchange fails
+         */
+        void shuffle(unsigned long long seed);
+        /**
+         * partial_shuffle
+         *
+         * Cheaper alternative to shuffle, each node exchanges a random fraction of its samples with a peer at a random
+         * rank distance and restores the previous portion sizes afterwards. Consistent for identically partitioned
+         * datasets like shuffle. Collective operation on comm_.
+         *
+         * @param fraction - The fraction of local samples sent to the peer, in [0, 1]
+         * @param seed     - The seed of the selection and the peer distance, must be identical on all nodes
+         * @throws invalid_argument if the fraction is not in [0, 1] or the sample shapes or types of the nodes differ
+         * @throws runtime_error    if the dataset is out-of-core or the data exchange fails
+         */
+        void partial_shuffle(float fraction, unsigned long long seed);
+
+        /**
+         * moments
+         *
+         * Calculates the sample count, mean, sum of squared deviations (M2), minimum and maximum per feature in a
+         * single pass over the local samples. The local samples are visited block by block using a ChunkIterator,
+         * so that out-of-core, half precision and quantized datasets are supported. The blocks and the partials of
+         * the nodes are merged with the parallel variant of Welford's algorithm (Chan et al.) in double precision,
+         * the latter using a single allreduce with a custom reduction operator. Collective operation on comm_.
+         * If the features are partitioned, the per-feature moments of the local features are only reduced along
+         * sample_comm, while the total moments still span all nodes.
+         *
+         * @param total - True if all values are treated as a single feature, defaults to false (per feature)
+         * @returns The global moments, identical on all nodes holding the same features
+         * @throws domain_error if the dataset is sparse
+         */
+        Moments moments(bool total=false) const;
+        /**
+         * view
+         *
+         * Creates a dataset over a range of the local samples without copying them, the view shares the memory of
+         * this dataset (copy on write). Half precision and quantization settings carry over. As for datasets created
+         * from arrays, the global metadata of the view is only exchanged when first requested, so that no collective
+         * operation is required to create it, e.g. for the folds of a cross validation. The view takes the sample
+         * dimension of this dataset, which is agreed on first if it is still pending.
+         *
+         * @param begin - The local index of the first sample
+         * @param end   - The local index after the last sample
+         * @returns The view of the samples
+         * @throws invalid_argument if the range exceeds the local samples
+         * @throws domain_error     if the dataset is out-of-core or sparse
+         */
+        Dataset view(dim_t begin, dim_t end) const;
 
         /**
          * mean
          *
-         * Calculates the mean/average value of the dataset
+         * Calculates the mean/average value of the dataset in the floating type of the samples, @see moments
          *
          * @param total - True if the mean should be calculated locally or false of globally, defaults to false
          */
@@ -166,7 +1182,8 @@ namespace juml {
         /**
          * stddev
          *
-         * Calculates the standard deviation of the dataset
+         * Calculates the (population) standard deviation of the dataset in a single pass in the floating type of the
+         * samples, @see moments
          *
          * @param total - True if the mean should be calculated locally or false of globally, defaults to false
          */
@@ -174,7 +1191,8 @@ namespace juml {
         /**
          * normalize
          *
-         * Normalizes the features of the dataset to a predefined interval (usually 0-1).
+         * Normalizes the features of the dataset to a predefined interval (usually 0-1). The feature range is obtained
+         * from moments, quantized datasets only adapt their affine parameters.
          *
          * @param min                  - The lower boundary of the normalization interval, defaults to 0
          * @param max                  - The upper boundary of the normalization interval, defaults to 1
@@ -188,7 +1206,8 @@ namespace juml {
         /**
          * normalize_stddev
          *
-         * Normalized the features of the dataset to multiples of the feature's standard deviation.
+         * Normalized the features of the dataset to multiples of the feature's standard deviation. Mean and standard
+         * deviation are obtained from a single call of moments, quantized datasets only adapt their affine parameters.
          *
          * @param x_std                - The multiple of standard deviations that is normalized to one, defaults to one
          * @param independent_features - Determines whether each feature column is normalized separately all the whole
@@ -198,6 +1217,81 @@ namespace juml {
          */
         void normalize_stddev(float x_std=1, bool independent_features=true,
                               const af::array &selected_features=af::array());
+        /**
+         * scale_features
+         *
+         * Applies the per-feature affine transformation value * scale + offset to the local samples in place. Quantized
+         * datasets only adapt their parameters, other samples are transformed with scale_features(data, ...).
+         *
+         * @param scale  - The per-feature factor (f32 column with one entry per feature)
+         * @param offset - The per-feature summand (f32 column with one entry per feature)
+         * @throws invalid_argument if the samples are not two-dimensional or the parameters do not match the features
+         * @throws domain_error     if the dataset is out-of-core or sparse
+         */
+        void scale_features(const af::array& scale, const af::array& offset);
+        /**
+         * scale_features
+         *
+         * Applies the per-feature affine transformation value * scale + offset to a features x samples array in place.
+         * f32 and f64 arrays on the CPU backend are transformed by a single OpenMP loop over the array's own memory
+         * without any temporaries, f16 arrays by the same loop over a widened copy. Other backends broadcast the
+         * parameters with batchFunc, so the JIT evaluates one kernel without tiling them to the size of the samples.
+         *
+         * @param data   - The samples to transform (features x samples)
+         * @param scale  - The per-feature factor (f32 column with one entry per feature)
+         * @param offset - The per-feature summand (f32 column with one entry per feature)
+         * @throws invalid_argument if the parameters do not match the features of data
+         */
+        static void scale_features(af::array& data, const af::array& scale, const af::array& offset);
+        /**
+         * quantize
+         *
+         * Stores the features as u8 levels with per-feature affine parameters, i.e. value = level * scale + offset,
+         * which quarters the memory of f32 samples. The parameters map the global minimum and maximum of each
+         * feature to the levels 0 and 255, they are found in one distributed pass. Consumers dequantize block by
+         * block, see dequantize and ChunkIterator. Samples appended by load_incremental are quantized with the same
+         * parameters and clamped, a reload from disk restores the original samples. Collective operation on comm_.
+         *
+         * @throws invalid_argument if the samples are not two-dimensional (features x samples)
+         * @throws domain_error     if the dataset is out-of-core or sparse
+         */
+        void quantize();
+        /**
+         * is_quantized
+         *
+         * @returns True if the samples are stored as quantized u8 levels, false otherwise
+         */
+        bool is_quantized() const;
+        /**
+         * is_compact
+         *
+         * @returns True if the in-memory samples are quantized or stored in half precision and have to be expanded
+         *          before computing with them, false otherwise
+         */
+        bool is_compact() const;
+        /**
+         * scale
+         *
+         * @returns The per-feature quantization step as f32 column, empty if not quantized
+         */
+        const af::array& scale() const;
+        /**
+         * offset
+         *
+         * @returns The per-feature value of the quantization level zero as f32 column, empty if not quantized
+         */
+        const af::array& offset() const;
+        /**
+         * dequantize
+         *
+         * Expands a block of stored samples to f32 for computation. The conversion and the affine transformation are
+         * element-wise and therefore fused into a single kernel by the arrayfire JIT. Half precision samples are
+         * widened, other samples are passed through unchanged.
+         *
+         * @param block - A block of samples of this dataset (features x samples)
+         * @returns The block in f32
+         */
+        af::array dequantize(const af::array& block) const;
 
         /**
          * loading_time
@@ -208,9 +1302,12 @@ namespace juml {
         /**
          * modified_time
          *
+         * Collective if shared metadata access is enabled, as rank zero broadcasts the timestamp.
+         *
          * @returns The UNIX timestamp when the HDF5 backing file was last modified on disk
+         * @throws runtime_error if the file cannot be accessed
          */
-        time_t modified_time() const;
+        virtual time_t modified_time() const;
 
         virtual af::array& data();
         virtual const af::array& data() const;
@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: DatasetGroup.h
+*
+* Description: Header of class DatasetGroup
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef DATASET_GROUP_H
+#define DATASET_GROUP_H
+
+#include <vector>
+
+#include "data/Dataset.h"
+
+namespace juml {
+    /**
+     * DatasetGroup
+     *
+     * Loads several datasets located in the same HDF5 file, e.g. samples and labels, with a single collective file
+     * open and a shared partition. The sample counts of the datasets are compared locally, as all nodes see the same
+     * file metadata no additional collective operations are required.
+     *
+     * Example:
+     *
+     * @code
+     * Dataset X("train.h5", "data");
+     * Dataset y("train.h5", "labels");
+     *
+     * DatasetGroup group;
+     * group.add(X).add(y);
+     * group.load_equal_chunks();
+     * @endcode
+     */
+    class DatasetGroup {
+    protected:
+        /**
+         * @var   datasets_
+         * @brief The grouped datasets, all backed by the same HDF5 file and distributed over the same communicator
+         */
+        std::vector<Dataset*> datasets_;
+
+        /**
+         * check_samples
+         *
+         * @param dataset   - The dataset to check
+         * @param n_samples - The number of (selected) samples of the dataset
+         * @param reference - A dataset of the group whose global number of samples is already known
+         * @throws domain_error if the number of samples differs from the one of the reference
+         */
+        void check_samples(const Dataset& dataset, hsize_t n_samples, const Dataset& reference) const;
+
+    public:
+        /**
+         * add
+         *
+         * Adds a dataset to the group. The dataset must outlive the group.
+         *
+         * @param dataset - The dataset to add
+         * @returns The group itself
+         * @throws invalid_argument if the dataset is not backed by the same HDF5 file or not distributed over the same
+         *                          communicator as the datasets already in the group
+         */
+        DatasetGroup& add(Dataset& dataset);
+        /**
+         * size
+         *
+         * @returns The number of datasets in the group
+         */
+        size_t size() const;
+
+        /**
+         * load_equal_chunks
+         *
+         * Loads all datasets in equal consecutive portions like Dataset::load_equal_chunks, but opens the HDF5 file
+         * only once and partitions all datasets identically. The datasets are only loaded if one of them has not been
+         * loaded since the file was last modified. The per-dataset settings, e.g. block size, selection or target type,
+         * are respected, datasets held by the load registry or the node-local cache are taken from there like in
+         * Dataset::load_equal_chunks and only the remaining ones are read. Collective operation on the datasets'
+         * communicator.
+         *
+         * @param force - Force the load data from disk, even if it has not been modified since the initial load
+         * @throws runtime_error if the file or a dataset does not exist or cannot be accessed
+         * @throws domain_error  if the sample counts of the datasets differ or their dimensionality is not supported
+         */
+        void load_equal_chunks(bool force=false);
+
+        /**
+         * joint_load
+         *
+         * Loads two datasets in equal portions, jointly using a DatasetGroup if both are backed by the same HDF5 file
+         * and distributed over the same communicator, separately otherwise.
+         *
+         * @param X     - The first dataset, e.g. the samples
+         * @param y     - The second dataset, e.g. the labels
+         * @param force - Force the load data from disk, even if it has not been modified since the initial load
+         * @throws runtime_error if a file or dataset does not exist or cannot be accessed
+         * @throws domain_error  if the sample counts of jointly loaded datasets differ
+         */
+        static void joint_load(Dataset& X, Dataset& y, bool force=false);
+    }; // DatasetGroup
+}  // juml
+#endif // DATASET_GROUP_H
@@ -0,0 +1,199 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: DatasetWriter.h
+*
+* Description: Header of class DatasetWriter
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef DATASET_WRITER_H
+#define DATASET_WRITER_H
+
+#include <arrayfire.h>
+#include <functional>
+#include <hdf5.h>
+#include <mpi.h>
+#include <string>
+
+#include "data/ChunkLayout.h"
+#include "data/Dataset.h"
+#include "data/IOProfile.h"
+
+namespace juml {
+    /**
+     * DatasetWriter
+     *
+     * Appends blocks of samples to an extendible, chunked HDF5 dataset. Each append is collective, the nodes'
+     * blocks are stored consecutively in rank order behind the previously written samples and the extent of the
+     * dataset grows accordingly. Only the current block is held in memory, so that arbitrarily many samples can be
+     * written, e.g. when batch-scoring a large dataset.
+     *
+     * Example:
+     *
+     * @code
+     * Dataset X("test.h5", "data");
+     * X.set_block_size(1 << 16);
+     * X.load_equal_chunks();
+     *
+     * DatasetWriter output("predictions.h5", "labels");
+     * classifier.predict_to(X, output);
+     * output.close();
+     * @endcode
+     */
+    class DatasetWriter {
+    protected:
+        /**
+         * @var   filename_
+         * @brief The name of the HDF5 file the samples are written to
+         */
+        const std::string filename_;
+        /**
+         * @var   dataset_
+         * @brief The name of the extendible HDF5 dataset the samples are appended to
+         */
+        const std::string dataset_;
+        /**
+         * @var   comm_
+         * @brief The MPI communicator the writing nodes are in
+         */
+        const MPI_Comm comm_;
+        /**
+         * @var   mpi_rank_
+         * @brief The node's MPI rank in comm_
+         */
+        int mpi_rank_;
+        /**
+         * @var   mpi_size_
+         * @brief The size of comm_
+         */
+        int mpi_size_;
+        /**
+         * @var   layout_
+         * @brief The chunking and compression of the HDF5 dataset, it is always chunked as it is extendible
+         */
+        ChunkLayout layout_;
+        /**
+         * @var   io_profile_
+         * @brief The MPI-IO hints and alignment used when accessing the HDF5 file
+         */
+        IOProfile io_profile_;
+
+        /**
+         * @var   file_id_
+         * @brief The HDF5 file handle, negative until the first append
+         */
+        hid_t file_id_;
+        /**
+         * @var   data_id_
+         * @brief The HDF5 dataset handle, negative until the first append
+         */
+        hid_t data_id_;
+        /**
+         * @var   type_
+         * @brief The arrayfire type of the written samples, determined by the first append
+         */
+        af::dtype type_;
+        /**
+         * @var   sample_dims_
+         * @brief The arrayfire dimensions of the written samples, the sample dimension being the last one
+         */
+        af::dim4 sample_dims_;
+        /**
+         * @var   n_dims_
+         * @brief The number of dimensions of the HDF5 dataset, at least two (samples and features)
+         */
+        int n_dims_;
+        /**
+         * @var   written_
+         * @brief The number of samples written by all nodes
+         */
+        hsize_t written_;
+
+        /**
+         * create
+         *
+         * Creates the extendible HDF5 dataset, opening or creating the file. The sample shape and type are agreed on
+         * by all nodes, nodes without samples adopt them. Collective operation on comm_.
+         *
+         * @param block - The first block of local samples, may be empty
+         * @throws runtime_error if the file or the dataset cannot be created
+         */
+        void create(const af::array& block);
+
+    public:
+        /**
+         * DatasetWriter constructor
+         *
+         * The file and dataset are created lazily on the first append. An existing dataset of the same name is not
+         * overwritten, its creation fails instead.
+         *
+         * @param filename - The name of the HDF5 file, will be created if it does not exist
+         * @param dataset  - The name of the HDF5 dataset to append to
+         * @param comm     - The MPI communicator of the writing nodes, defaults to MPI_COMM_WORLD
+         * @param layout   - The chunking and compression, the default chunk length is the sample count of the first
+         *                   append bounded by the maximum chunk size
+         * @param profile  - The MPI-IO hints and alignment used when accessing the file
+         */
+        DatasetWriter(const std::string& filename, const std::string& dataset, MPI_Comm comm=MPI_COMM_WORLD,
+                      const ChunkLayout& layout=ChunkLayout(true), const IOProfile& profile=IOProfile());
+        DatasetWriter(const DatasetWriter&) = delete;
+        DatasetWriter& operator=(const DatasetWriter&) = delete;
+        /**
+         * DatasetWriter destructor
+         *
+         * Closes the HDF5 file if it has not been closed explicitly. Collective operation on comm_ in this case.
+         */
+        ~DatasetWriter();
+
+        /**
+         * append
+         *
+         * Appends a block of local samples to the HDF5 dataset, growing its extent collectively. Must be called by all
+         * nodes the same number of times, nodes without samples pass an empty array. Half precision samples are
+         * widened to f32. Collective operation on comm_.
+         *
+         * @param block - The local samples, arranged like the data of a Dataset (features x samples)
+         * @throws invalid_argument if the shape or type of the samples on any node differs from the previously written
+         *                          ones
+         * @throws runtime_error    if extending or writing the dataset fails
+         */
+        void append(const af::array& block);
+        /**
+         * append_blocks
+         *
+         * Walks the local portion of a dataset block by block, transforms each block, e.g. by predicting it, and
+         * appends the results. Nodes with fewer blocks append empty blocks, so that the number of appends matches.
+         * The transform is only applied to local blocks and therefore must not communicate. Collective operation on
+         * comm_.
+         *
+         * @param X          - The input dataset, loaded if necessary
+         * @param transform  - Maps a block of input samples to a block of output samples with the same sample count
+         * @param block_size - The number of samples per block, defaults to the block size of X. Zero transforms the
+         *                     whole local portion at once.
+         */
+        void append_blocks(Dataset& X, const std::function<af::array(const af::array&)>& transform,
+                           dim_t block_size=-1);
+        /**
+         * close
+         *
+         * Releases the HDF5 handles. Collective operation on comm_.
+         */
+        void close();
+
+        /**
+         * written
+         *
+         * @returns The number of samples written by all nodes
+         */
+        hsize_t written() const;
+    }; // DatasetWriter
+} // namespace juml
+
+#endif // DATASET_WRITER_H
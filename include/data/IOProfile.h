@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: IOProfile.h
+*
+* Description: Header of struct IOProfile
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef IOPROFILE_H
+#define IOPROFILE_H
+
+#include <hdf5.h>
+#include <mpi.h>
+
+namespace juml {
+    /**
+     * IOProfile
+     *
+     * Bundles the tunables of parallel HDF5 I/O: the MPI-IO transfer mode, collective buffering and file system
+     * striping hints passed to MPI-IO, as well as the HDF5 object alignment. The defaults correspond to HDF5's and the
+     * MPI implementation's defaults, i.e. independent transfer and no hints.
+     */
+    struct IOProfile {
+        /**
+         * @var   collective
+         * @brief Use collective instead of independent MPI-IO transfers when reading
+         */
+        bool    collective;
+        /**
+         * @var   cb_nodes
+         * @brief The number of collective buffering aggregator nodes (MPI-IO hint cb_nodes), zero for MPI's default
+         */
+        int     cb_nodes;
+        /**
+         * @var   striping_factor
+         * @brief The number of file system stripes (MPI-IO hint striping_factor), zero for the file system default
+         */
+        int     striping_factor;
+        /**
+         * @var   striping_unit
+         * @brief The stripe size in bytes (MPI-IO hint striping_unit), zero for the file system default
+         */
+        int     striping_unit;
+        /**
+         * @var   alignment
+         * @brief The alignment of HDF5 objects in the file in bytes, zero or one to disable
+         */
+        hsize_t alignment;
+        /**
+         * @var   alignment_threshold
+         * @brief Objects of at least this size in bytes are aligned
+         */
+        hsize_t alignment_threshold;
+
+        /**
+         * IOProfile constructor
+         *
+         * @param collective          - Use collective transfers, defaults to false (independent)
+         * @param cb_nodes            - Collective buffering node count, defaults to zero (MPI default)
+         * @param striping_factor     - Number of stripes, defaults to zero (file system default)
+         * @param striping_unit       - Stripe size in bytes, defaults to zero (file system default)
+         * @param alignment           - Object alignment in bytes, defaults to zero (no alignment)
+         * @param alignment_threshold - Minimum size of aligned objects in bytes, defaults to one
+         */
+        IOProfile(bool    collective=false,
+                  int     cb_nodes=0,
+                  int     striping_factor=0,
+                  int     striping_unit=0,
+                  hsize_t alignment=0,
+                  hsize_t alignment_threshold=1);
+
+        /**
+         * info
+         *
+         * Creates the MPI info object containing the MPI-IO hints. Must be freed by the caller using MPI_Info_free
+         * unless it is MPI_INFO_NULL.
+         *
+         * @returns The MPI info object or MPI_INFO_NULL if no hints are set
+         */
+        MPI_Info info() const;
+        /**
+         * file_access_list
+         *
+         * Creates an HDF5 file access property list for parallel I/O on the passed communicator with the hints and the
+         * alignment of this profile. Must be closed by the caller.
+         *
+         * @param comm - The MPI communicator the file is accessed by
+         * @returns The HDF5 file access property list
+         * @throws runtime_error if the property list cannot be created
+         */
+        hid_t file_access_list(MPI_Comm comm) const;
+        /**
+         * transfer_list
+         *
+         * Creates an HDF5 dataset transfer property list with the transfer mode of this profile. Must be closed by the
+         * caller.
+         *
+         * @returns The HDF5 dataset transfer property list
+         * @throws runtime_error if the property list cannot be created
+         */
+        hid_t transfer_list() const;
+    }; // IOProfile
+}  // juml
+#endif // IOPROFILE_H
@@ -0,0 +1,186 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: NumpyDataset.h
+*
+* Description: Header of class NumpyDataset
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef NUMPY_DATASET_H
+#define NUMPY_DATASET_H
+
+#include <arrayfire.h>
+#include <hdf5.h>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+#include "data/Dataset.h"
+
+namespace juml {
+    /**
+     * NumpyDataset
+     *
+     * A distributed dataset loaded from a NumPy .npy file or a headerless raw binary file instead of HDF5. The first
+     * axis of the array enumerates the samples, like the rows of an HDF5 dataset, and the samples are partitioned
+     * exactly as by Dataset::load_equal_chunks or load_weighted_chunks. Each node reads only its own rows with
+     * positioned reads (pread), or maps them if memory mapping is enabled.
+     *
+     * C-ordered arrays store each sample consecutively, which already is the features x samples layout of arrayfire.
+     * Fortran-ordered arrays store each feature column consecutively, so the local rows of every column are read into
+     * their place of a samples-major buffer and reordered once on the device. The sample range, the feature
+     * projection and the target type of Dataset apply, out-of-core processing does not.
+     *
+     * Example:
+     *
+     * @code
+     * NumpyDataset X("embeddings.npy");
+     * X.load_equal_chunks();
+     * @endcode
+     */
+    class NumpyDataset : public Dataset {
+    protected:
+        /**
+         * @var   shape_
+         * @brief The shape of the array in NumPy (row-major) order, the first entry being the number of samples
+         */
+        std::vector<hsize_t> shape_;
+        /**
+         * @var   type_
+         * @brief The arrayfire type of the stored elements
+         */
+        af::dtype type_ = f32;
+        /**
+         * @var   type_size_
+         * @brief The size of a stored element in bytes
+         */
+        size_t type_size_ = 4;
+        /**
+         * @var   fortran_order_
+         * @brief True if the array is stored in column-major (Fortran) order
+         */
+        bool fortran_order_ = false;
+        /**
+         * @var   data_offset_
+         * @brief The file offset of the first element in bytes
+         */
+        size_t data_offset_ = 0;
+        /**
+         * @var   raw_
+         * @brief True if the file has no .npy header and its layout has been passed explicitly
+         */
+        bool raw_ = false;
+
+        /**
+         * read_header
+         *
+         * Parses the .npy header, i.e. the magic string, the version and the dictionary holding descr, fortran_order
+         * and shape, and stores the layout.
+         *
+         * @throws runtime_error if the file cannot be opened or is not a .npy file
+         * @throws domain_error  if the element type, the byte order or the number of dimensions is not supported
+         */
+        void read_header();
+        /**
+         * array_dims
+         *
+         * @param count - The number of local samples
+         * @returns The arrayfire dimensions of the local samples, the sample dimension being the last one
+         */
+        af::dim4 array_dims(hsize_t count) const;
+        /**
+         * read_rows
+         *
+         * Reads the selected samples in the file's own order, i.e. samples-major for Fortran-ordered arrays.
+         *
+         * @param fd       - The file descriptor
+         * @param position - The index of the first local sample among the selected ones
+         * @param count    - The number of local samples
+         * @param buffer   - The destination of count samples
+         * @returns True on success, false if a read failed
+         */
+        bool read_rows(int fd, hsize_t position, hsize_t count, uint8_t* buffer) const;
+        /**
+         * map_rows
+         *
+         * Memory maps the local samples, only possible for consecutive, unconverted and unprojected samples of a
+         * C-ordered array on the CPU backend.
+         *
+         * @param position - The index of the first local sample among the selected ones
+         * @param count    - The number of local samples
+         * @returns True if the samples have been mapped into data_, false otherwise
+         */
+        bool map_rows(hsize_t position, hsize_t count);
+
+        /**
+         * load_chunks
+         *
+         * Loads the local consecutive portion of the samples from the .npy or raw file as determined by partition.
+         * Data will only be loaded once, unless it has changed on disk or the weights differ from the previous load.
+         *
+         * @param weights - The relative portion size of each node in comm_, empty for equal portions
+         * @param force   - Force the load data from disk, even if it has not been modified since the initial load
+         * @throws runtime_error if the file cannot be opened or read
+         * @throws domain_error  if the layout is not supported, the dataset is out-of-core or its features are
+         *                       partitioned
+         */
+        virtual void load_chunks(const std::vector<double>& weights, bool force) override;
+
+    public:
+        /**
+         * NumpyDataset constructor
+         *
+         * Creates a new dataset from a NumPy .npy file (format version 1.0 to 3.0).
+         *
+         * @param filename - The name of the .npy file to load
+         * @param comm     - The MPI comm the data will be distributed across
+         */
+        NumpyDataset(const std::string& filename, const MPI_Comm comm=MPI_COMM_WORLD);
+        /**
+         * NumpyDataset constructor
+         *
+         * Creates a new dataset from a raw binary file holding the elements of an array in native byte order.
+         *
+         * @param filename      - The name of the raw binary file to load
+         * @param shape         - The shape of the array in NumPy (row-major) order, samples first, one to four axes
+         * @param type          - The arrayfire type of the elements
+         * @param fortran_order - True if the array is stored in column-major (Fortran) order
+         * @param offset        - The file offset of the first element in bytes
+         * @param comm          - The MPI comm the data will be distributed across
+         * @throws domain_error if the shape has less than one or more than four axes
+         */
+        NumpyDataset(const std::string& filename, const std::vector<hsize_t>& shape, af::dtype type,
+                     bool fortran_order=false, size_t offset=0, const MPI_Comm comm=MPI_COMM_WORLD);
+
+        /**
+         * shape
+         *
+         * @returns The shape of the array in NumPy (row-major) order, empty until the header has been read
+         */
+        const std::vector<hsize_t>& shape() const;
+        /**
+         * fortran_order
+         *
+         * @returns True if the array is stored in column-major (Fortran) order
+         */
+        bool fortran_order() const;
+
+        /**
+         * type_size
+         *
+         * @param type - An arrayfire type
+         * @returns The size of an element of the type in bytes
+         * @throws domain_error if the type is not supported
+         */
+        static size_t type_size(af::dtype type);
+    }; // NumpyDataset
+} // namespace juml
+
+#endif // NUMPY_DATASET_H
@@ -0,0 +1,201 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: ShardedDataset.h
+*
+* Description: Header of class ShardedDataset
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef SHARDED_DATASET_H
+#define SHARDED_DATASET_H
+
+#include <arrayfire.h>
+#include <ctime>
+#include <hdf5.h>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+#include "data/Dataset.h"
+
+namespace juml {
+    /**
+     * ShardedDataset
+     *
+     * A distributed dataset stored in several HDF5 files (shards), e.g. one file per day, that are read as a single
+     * logical dataset. The shards are concatenated along the samples in the order of the passed file names, glob
+     * patterns are expanded in lexicographic order. A virtual dataset (VDS) whose sources are stacked row bands of
+     * whole datasets is replaced by its sources, any other virtual dataset is read as a single shard.
+     *
+     * If there are at least as many shards as nodes, the nodes are assigned whole consecutive shards with a balanced
+     * number of samples, so that every node reads its own files with independent POSIX I/O and no file is shared.
+     * Fewer shards are split into equal sample ranges like by Dataset::load_equal_chunks. Only rank zero touches the
+     * file system metadata for expanding the patterns, the row counts are queried by the nodes round-robin and
+     * exchanged in a single allreduce. The feature projection, the target type and the storage modes of Dataset
+     * apply, the sample range selection, out-of-core processing and the feature partitioning do not.
+     *
+     * Example:
+     *
+     * @code
+     * ShardedDataset X({"lake/2017-*.h5"}, "Data");
+     * X.load_equal_chunks();
+     * @endcode
+     */
+    class ShardedDataset : public Dataset {
+    public:
+        /**
+         * Shard
+         *
+         * A single HDF5 dataset of the logical dataset.
+         */
+        struct Shard {
+            /**
+             * @var   filename
+             * @brief The name of the HDF5 file
+             */
+            std::string filename;
+            /**
+             * @var   dataset
+             * @brief The name of the dataset within the file
+             */
+            std::string dataset;
+            /**
+             * @var   modified_time
+             * @brief The UNIX timestamp of the last modification of the file
+             */
+            time_t modified_time;
+            /**
+             * @var   n_samples
+             * @brief The number of samples of the shard, zero until it has been loaded
+             */
+            hsize_t n_samples;
+        };
+
+    protected:
+        /**
+         * @var   patterns_
+         * @brief The file names or glob patterns of the shards in sample order
+         */
+        const std::vector<std::string> patterns_;
+        /**
+         * @var   shards_
+         * @brief The shards of the last load in sample order
+         */
+        std::vector<Shard> shards_;
+
+        /**
+         * expand_shards
+         *
+         * Expands the patterns and virtual datasets into the list of shards on rank zero and broadcasts it, so that
+         * all nodes agree on the shards even if the directory changes concurrently. Collective operation on comm_.
+         *
+         * @returns The shards in sample order, the sample counts not yet determined
+         * @throws runtime_error if a pattern matches no file or a file or dataset cannot be accessed
+         */
+        std::vector<Shard> expand_shards() const;
+        /**
+         * add_shards
+         *
+         * Appends the dataset of a single file to the shards, or the sources of a virtual dataset if they can be
+         * read directly.
+         *
+         * @param filename - The name of the HDF5 file
+         * @param shards   - The shards to append to
+         * @throws runtime_error if the file or dataset cannot be accessed
+         */
+        void add_shards(const std::string& filename, std::vector<Shard>& shards) const;
+        /**
+         * count_samples
+         *
+         * Determines the number of samples of every shard and checks that their samples have the same shape and
+         * type. Each node queries every mpi_size_-th shard. Collective operation on comm_.
+         *
+         * @param shards - The shards, receive their sample counts
+         * @throws runtime_error if a file or dataset cannot be accessed
+         * @throws domain_error  if the shards have differing sample shapes or types
+         */
+        void count_samples(std::vector<Shard>& shards) const;
+        /**
+         * open_shard
+         *
+         * Opens a shard for independent, process-local reading.
+         *
+         * @param shard   - The shard
+         * @param file_id - Output, the HDF5 file handle
+         * @returns The HDF5 dataset handle
+         * @throws runtime_error if the file or dataset cannot be accessed
+         */
+        hid_t open_shard(const Shard& shard, hid_t& file_id) const;
+
+        /**
+         * load_chunks
+         *
+         * Loads the local consecutive portion of the samples from the shards. Data will only be loaded once, unless
+         * the shards have changed on disk, a shard has been added or removed or the weights differ from the
+         * previous load.
+         *
+         * @param weights - The relative portion size of each node in comm_, empty for equal portions
+         * @param force   - Force the load data from disk, even if it has not been modified since the initial load
+         * @throws runtime_error if a file or dataset does not exist or cannot be accessed
+         * @throws domain_error  if the shards are incompatible or a unsupported mode is selected
+         */
+        virtual void load_chunks(const std::vector<double>& weights, bool force) override;
+
+    public:
+        /**
+         * ShardedDataset constructor
+         *
+         * Creates a new dataset from several HDF5 files holding a dataset of the same name.
+         *
+         * @param patterns - The file names or glob patterns of the shards in sample order
+         * @param dataset  - The name of the dataset in each of the files
+         * @param comm     - The MPI comm the data will be distributed across
+         * @throws invalid_argument if no pattern is passed
+         */
+        ShardedDataset(const std::vector<std::string>& patterns, const std::string& dataset,
+                       const MPI_Comm comm=MPI_COMM_WORLD);
+
+        /**
+         * load_incremental
+         *
+         * Expands the patterns again and reloads the dataset if shards have been added, removed or modified, e.g.
+         * when the shard of a new day has arrived. The partition is computed anew and therefore always balanced.
+         * Collective operation on comm_.
+         *
+         * @param rebalance - Ignored, the reloaded portions are balanced anyway
+         * @throws runtime_error if a file or dataset does not exist or cannot be accessed
+         */
+        virtual void load_incremental(bool rebalance=false) override;
+        /**
+         * modified_time
+         *
+         * Expands the patterns, collective operation on comm_.
+         *
+         * @returns The UNIX timestamp of the most recently modified shard
+         * @throws runtime_error if a pattern matches no file or a file cannot be accessed
+         */
+        virtual time_t modified_time() const override;
+
+        /**
+         * patterns
+         *
+         * @returns The file names or glob patterns of the shards
+         */
+        const std::vector<std::string>& patterns() const;
+        /**
+         * shards
+         *
+         * @returns The shards of the last load in sample order, empty if not loaded yet
+         */
+        const std::vector<Shard>& shards() const;
+    }; // ShardedDataset
+} // namespace juml
+
+#endif // SHARDED_DATASET_H
@@ -0,0 +1,143 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: SparseDataset.h
+*
+* Description: Header of class SparseDataset
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef SPARSE_DATASET_H
+#define SPARSE_DATASET_H
+
+#include <arrayfire.h>
+#include <hdf5.h>
+#include <mpi.h>
+#include <string>
+
+#include "data/Dataset.h"
+
+namespace juml {
+    /**
+     * SparseDataset
+     *
+     * A distributed dataset of sparse samples held in compressed sparse row (CSR) format. In contrast to the dense
+     * Dataset, the local portion is a samples x features arrayfire sparse array, i.e. each row is a sample. It is
+     * loaded from an HDF5 group containing the one-dimensional datasets indptr (row pointers, n_samples + 1 entries),
+     * indices (column indices) and values, as written by e.g. scipy or h5sparse. The number of features is taken from
+     * the optional group attribute shape (rows, columns), otherwise from the largest column index. The rows are
+     * partitioned into equal consecutive portions with the global offset semantics of Dataset.
+     *
+     * Only the algorithms with sparse code paths accept sparse datasets, i.e. the distance functions, Gaussian Naive
+     * Bayes and the first layer of the neural network. The dense statistics and normalization of Dataset as well as
+     * out-of-core processing do not apply.
+     *
+     * Example:
+     *
+     * @code
+     * SparseDataset X("clicks.h5", "features");
+     * X.load_equal_chunks();
+     * af::array csr = X.data(); // X.n_samples() x X.n_features()
+     * @endcode
+     */
+    class SparseDataset : public Dataset {
+    protected:
+        /**
+         * @var   n_features_
+         * @brief The global number of features (columns) of the sparse matrix
+         */
+        dim_t n_features_ = 0;
+
+        /**
+         * read_range
+         *
+         * Reads a consecutive range of a one-dimensional dataset in the sparse group.
+         *
+         * @param group_id - The HDF5 group handle
+         * @param name     - The name of the dataset in the group
+         * @param offset   - The index of the first element
+         * @param count    - The number of elements
+         * @param type     - The arrayfire type to read the elements as
+         * @returns The elements as a column vector
+         * @throws runtime_error if the dataset cannot be opened or read
+         */
+        af::array read_range(hid_t group_id, const std::string& name, hsize_t offset, hsize_t count,
+                             af::dtype type) const;
+        /**
+         * value_type
+         *
+         * @param group_id - The HDF5 group handle
+         * @returns The arrayfire type of the loaded values, the target type if set, f64 for double precision values
+         *          and f32 otherwise, as arrayfire sparse arrays only support floating point values
+         */
+        af::dtype value_type(hid_t group_id) const;
+
+    public:
+        /**
+         * SparseDataset constructor
+         *
+         * Creates a new sparse dataset from an HDF5 group.
+         *
+         * @param filename - The name of the HDF5 file to load
+         * @param group    - The name of the HDF5 group containing indptr, indices and values
+         * @param comm     - The MPI comm the data will be distributed across
+         */
+        SparseDataset(const std::string& filename, const std::string& group, const MPI_Comm comm=MPI_COMM_WORLD);
+        /**
+         * SparseDataset constructor
+         *
+         * Creates a new sparse dataset from an in-memory CSR array. It is considered to be the local portion of the
+         * global data. Collective operation on comm.
+         *
+         * @param data - The local samples as samples x features arrayfire sparse array in CSR format
+         * @param comm - The MPI comm the data will be distributed across
+         * @throws invalid_argument if the array is not a CSR sparse array
+         */
+        SparseDataset(const af::array& data, MPI_Comm comm=MPI_COMM_WORLD);
+
+        /**
+         * load_equal_chunks
+         *
+         * Loads the rows of the sparse matrix in equal consecutive portions. Only the row pointers of the local rows
+         * and their non-zero entries are read. Collective operation on comm_.
+         *
+         * @param force - Force the load data from disk, even if it has not been modified since the initial load
+         * @throws runtime_error if the file, the group or one of its datasets does not exist or cannot be accessed
+         * @throws domain_error  if the row pointers are inconsistent with the shape or the features are partitioned
+         */
+        virtual void load_equal_chunks(bool force=false) override;
+
+        virtual dim_t n_features() const override;
+
+        /**
+         * rows
+         *
+         * Selects a range of rows of a CSR array without densifying it.
+         *
+         * @param csr   - The arrayfire sparse array in CSR format
+         * @param begin - The index of the first row
+         * @param end   - The index of the last row (inclusive)
+         * @returns The selected rows as CSR array
+         */
+        static af::array rows(const af::array& csr, dim_t begin, dim_t end);
+        /**
+         * empty_rows
+         *
+         * Creates a CSR array without non-zero entries directly from zero row pointers, i.e. without a dense array.
+         *
+         * @param n_rows    - The number of rows
+         * @param n_columns - The number of columns
+         * @param type      - The arrayfire type of the (absent) values, f32 or f64
+         * @returns The empty rows as CSR array
+         */
+        static af::array empty_rows(dim_t n_rows, dim_t n_columns, af::dtype type);
+    }; // SparseDataset
+} // namespace juml
+
+#endif // SPARSE_DATASET_H
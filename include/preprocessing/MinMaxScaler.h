@@ -0,0 +1,104 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: MinMaxScaler.h
+*
+* Description: Header of class MinMaxScaler
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef MIN_MAX_SCALER_H
+#define MIN_MAX_SCALER_H
+
+#include <arrayfire.h>
+#include <mpi.h>
+#include <string>
+
+#include "core/Backend.h"
+#include "data/Dataset.h"
+#include "preprocessing/Scaler.h"
+
+namespace juml {
+    /**
+     * MinMaxScaler
+     *
+     * Scales each feature to a predefined interval (usually 0-1) with respect to the global minimum and maximum of
+     * the feature in the fitted dataset. Constant features are mapped to the lower boundary of the interval.
+     *
+     * Example:
+     *
+     * @code
+     * MinMaxScaler scaler;
+     * scaler.fit_transform(X_train);
+     * scaler.save("scaler.h5");
+     * scaler.transform(X_test);
+     * @endcode
+     */
+    class MinMaxScaler : public Scaler {
+    protected:
+        /**
+         * @var   min_
+         * @brief The lower boundary of the target interval
+         */
+        float min_;
+        /**
+         * @var   max_
+         * @brief The upper boundary of the target interval
+         */
+        float max_;
+        /**
+         * @var   data_min_
+         * @brief The global per-feature minimum of the fitted dataset, empty before fit
+         */
+        af::array data_min_;
+        /**
+         * @var   data_max_
+         * @brief The global per-feature maximum of the fitted dataset, empty before fit
+         */
+        af::array data_max_;
+
+    public:
+        /**
+         * MinMaxScaler constructor
+         *
+         * @param min     - The lower boundary of the target interval, defaults to 0
+         * @param max     - The upper boundary of the target interval, defaults to 1
+         * @param backend - The execution backend, defaults to CPU
+         * @param comm    - The MPI communicator for the execution, defaults to world communicator
+         * @throws invalid_argument if max is not larger than min
+         */
+        MinMaxScaler(float min=0, float max=1, int backend=Backend::CPU, MPI_Comm comm=MPI_COMM_WORLD);
+
+        /**
+         * fit
+         *
+         * Computes the global per-feature minimum and maximum in a single pass. Collective operation.
+         *
+         * @param X - The dataset to fit the scaler on, loaded if necessary
+         */
+        virtual void fit(Dataset& X) override;
+
+        /**
+         * data_min
+         *
+         * @returns The global per-feature minimum of the fitted dataset, empty before fit
+         */
+        const af::array& data_min() const;
+        /**
+         * data_max
+         *
+         * @returns The global per-feature maximum of the fitted dataset, empty before fit
+         */
+        const af::array& data_max() const;
+
+        virtual void load(const std::string& filename) override;
+        virtual void save(const std::string& filename, bool override=true) const override;
+    }; // MinMaxScaler
+}  // juml
+#endif // MIN_MAX_SCALER_H
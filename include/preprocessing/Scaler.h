@@ -0,0 +1,148 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: Scaler.h
+*
+* Description: Header of class Scaler
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef SCALER_H
+#define SCALER_H
+
+#include <arrayfire.h>
+#include <mpi.h>
+#include <string>
+
+#include "core/Algorithm.h"
+#include "core/Backend.h"
+#include "data/Dataset.h"
+
+namespace juml {
+    /**
+     * Scaler
+     *
+     * Abstract base of the feature scalers. A scaler is fitted once on a (training) dataset with a single global
+     * reduction, @see Dataset::moments, and condenses the statistics into a per-feature affine transformation
+     * value * scale + offset. The fitted scaler can be saved and loaded like the other algorithms and applied to
+     * arbitrary further datasets, e.g. inference data, in place and without recomputing any statistics.
+     */
+    class Scaler : public Algorithm {
+    protected:
+        /**
+         * @var   scale_
+         * @brief The per-feature factor of the transformation (f32 column), empty before fit
+         */
+        af::array scale_;
+        /**
+         * @var   offset_
+         * @brief The per-feature summand of the transformation (f32 column), empty before fit
+         */
+        af::array offset_;
+
+        /**
+         * check_fitted
+         *
+         * @param n_features - The number of features of the data to transform
+         * @throws runtime_error    if the scaler has not been fitted
+         * @throws invalid_argument if the number of features differs from the fitted one
+         */
+        void check_fitted(dim_t n_features) const;
+
+    public:
+        /**
+         * Scaler constructor
+         *
+         * @param backend - The execution backend, defaults to CPU
+         * @param comm    - The MPI communicator for the execution, defaults to world communicator
+         */
+        Scaler(int backend=Backend::CPU, MPI_Comm comm=MPI_COMM_WORLD);
+        virtual ~Scaler() = default;
+
+        /**
+         * fit
+         *
+         * Computes the global statistics of the dataset in a single pass. Collective operation.
+         *
+         * @param X - The dataset to fit the scaler on, loaded if necessary
+         */
+        virtual void fit(Dataset& X) = 0;
+        /**
+         * transform
+         *
+         * Applies the fitted transformation to the local samples of an in-memory dataset in place. Out-of-core
+         * datasets are transformed block by block with the array variant.
+         *
+         * @param X - The dataset to transform, loaded if necessary
+         * @throws runtime_error    if the scaler has not been fitted
+         * @throws invalid_argument if the number of features differs from the fitted one
+         */
+        void transform(Dataset& X) const;
+        /**
+         * transform
+         *
+         * Applies the fitted transformation to a block of samples in place.
+         *
+         * @param data - The samples to transform (features x samples)
+         * @throws runtime_error    if the scaler has not been fitted
+         * @throws invalid_argument if the number of features differs from the fitted one
+         */
+        void transform(af::array& data) const;
+        /**
+         * fit_transform
+         *
+         * Fits the scaler on the dataset and transforms it in place.
+         *
+         * @param X - The dataset to fit and transform
+         */
+        void fit_transform(Dataset& X);
+        /**
+         * inverse_transform
+         *
+         * Reverts the fitted transformation of the local samples of an in-memory dataset in place.
+         *
+         * @param X - The transformed dataset
+         * @throws runtime_error    if the scaler has not been fitted
+         * @throws invalid_argument if the number of features differs from the fitted one
+         */
+        void inverse_transform(Dataset& X) const;
+
+        /**
+         * scale
+         *
+         * @returns The per-feature factor of the transformation, empty before fit
+         */
+        const af::array& scale() const;
+        /**
+         * offset
+         *
+         * @returns The per-feature summand of the transformation, empty before fit
+         */
+        const af::array& offset() const;
+
+        /**
+         * load
+         *
+         * Loads the fitted transformation from an HDF5 file. Collective operation.
+         *
+         * @param filename - The name of the HDF5 file
+         */
+        virtual void load(const std::string& filename);
+        /**
+         * save
+         *
+         * Saves the fitted transformation to an HDF5 file. Collective operation.
+         *
+         * @param filename - The name of the HDF5 file
+         * @param override - If true (default) an existing file is overriden, else an exception is thrown
+         */
+        virtual void save(const std::string& filename, bool override=true) const;
+    }; // Scaler
+}  // juml
+#endif // SCALER_H
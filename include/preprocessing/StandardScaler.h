@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: StandardScaler.h
+*
+* Description: Header of class StandardScaler
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#ifndef STANDARD_SCALER_H
+#define STANDARD_SCALER_H
+
+#include <arrayfire.h>
+#include <mpi.h>
+#include <string>
+
+#include "core/Backend.h"
+#include "data/Dataset.h"
+#include "preprocessing/Scaler.h"
+
+namespace juml {
+    /**
+     * StandardScaler
+     *
+     * Centers each feature on its global mean and scales it to multiples of its global (population) standard
+     * deviation in the fitted dataset. Constant features are only centered.
+     *
+     * Example:
+     *
+     * @code
+     * StandardScaler scaler;
+     * scaler.fit(X_train);
+     * scaler.save("scaler.h5");
+     *
+     * StandardScaler loaded;
+     * loaded.load("scaler.h5");
+     * loaded.transform(X_test);
+     * @endcode
+     */
+    class StandardScaler : public Scaler {
+    protected:
+        /**
+         * @var   x_std_
+         * @brief The multiple of standard deviations that is scaled to one
+         */
+        float x_std_;
+        /**
+         * @var   mean_
+         * @brief The global per-feature mean of the fitted dataset, empty before fit
+         */
+        af::array mean_;
+        /**
+         * @var   stddev_
+         * @brief The global per-feature standard deviation of the fitted dataset, empty before fit
+         */
+        af::array stddev_;
+
+    public:
+        /**
+         * StandardScaler constructor
+         *
+         * @param x_std   - The multiple of standard deviations that is scaled to one, defaults to one
+         * @param backend - The execution backend, defaults to CPU
+         * @param comm    - The MPI communicator for the execution, defaults to world communicator
+         * @throws invalid_argument if x_std is not larger than zero
+         */
+        StandardScaler(float x_std=1, int backend=Backend::CPU, MPI_Comm comm=MPI_COMM_WORLD);
+
+        /**
+         * fit
+         *
+         * Computes the global per-feature mean and standard deviation in a single pass. Collective operation.
+         *
+         * @param X - The dataset to fit the scaler on, loaded if necessary
+         */
+        virtual void fit(Dataset& X) override;
+
+        /**
+         * mean
+         *
+         * @returns The global per-feature mean of the fitted dataset, empty before fit
+         */
+        const af::array& mean() const;
+        /**
+         * stddev
+         *
+         * @returns The global per-feature standard deviation of the fitted dataset, empty before fit
+         */
+        const af::array& stddev() const;
+
+        virtual void load(const std::string& filename) override;
+        virtual void save(const std::string& filename, bool override=true) const override;
+    }; // StandardScaler
+}  // juml
+#endif // STANDARD_SCALER_H
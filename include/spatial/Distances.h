@@ -17,6 +17,7 @@
 #define DISTANCES_H
 
 #include <arrayfire.h>
+#include <mpi.h>
 
 namespace juml {
     typedef af::array (*Distance)(const af::array&, const af::array&);
@@ -24,7 +25,8 @@ namespace juml {
     /**
      * euclidean
      *
-     * Calculates the euclidean distance matrix of two, multi-dimensional point sets.
+     * Calculates the euclidean distance matrix of two, multi-dimensional point sets. The source points may also be
+     * a n x f sparse array in CSR format (samples as rows, @see SparseDataset), which is not densified.
      *
      * @param   from - the source points, must be a two-dimensional matrix with n x f items
      * @param   to - the destination points, must be a two-dimensional matrix with k x f items
@@ -36,7 +38,8 @@ namespace juml {
     /**
      * manhattan
      *
-     * Calculates the manhattan distance matrix of two, multi-dimensional point sets.
+     * Calculates the manhattan distance matrix of two, multi-dimensional point sets. The source points may also be
+     * a n x f sparse array in CSR format (samples as rows, @see SparseDataset), which is not densified.
      *
      * @param   from - the source points, must be a two-dimensional matrix with n x f items
      * @param   to - the destination points, must be a two-dimensional matrix with k x f items
@@ -44,6 +47,37 @@ namespace juml {
      * @throws  invalid_argument, if from or to has more then two dimensions or from and to have varying feature count
      */
     af::array manhattan(const af::array& from, const af::array& to);
+
+    /**
+     * euclidean
+     *
+     * Calculates the euclidean distance matrix of two point sets whose features are partitioned across the nodes of
+     * comm, e.g. the local features of a feature partitioned Dataset and the same range of the centroid features
+     * (@see Dataset::feature_comm). The squared distances along the local features are summed up in a single
+     * allreduce before the root is taken. Collective operation on comm.
+     *
+     * @param   from - the local features of the source points, must be a two-dimensional matrix with n x f items
+     * @param   to - the local features of the destination points, must be a two-dimensional matrix with k x f items
+     * @param   comm - the nodes holding the other features of the same points
+     * @returns A n x k matrix that contains the distance from a singular from point to all to points in each row
+     * @throws  invalid_argument, if from or to has more then two dimensions or from and to have varying feature count
+     */
+    af::array euclidean(const af::array& from, const af::array& to, MPI_Comm comm);
+
+    /**
+     * manhattan
+     *
+     * Calculates the manhattan distance matrix of two point sets whose features are partitioned across the nodes of
+     * comm, @see euclidean. The distances along the local features are summed up in a single allreduce. Collective
+     * operation on comm.
+     *
+     * @param   from - the local features of the source points, must be a two-dimensional matrix with n x f items
+     * @param   to - the local features of the destination points, must be a two-dimensional matrix with k x f items
+     * @param   comm - the nodes holding the other features of the same points
+     * @returns A n x k matrix that contains the distance from a singular from point to all to points in each row
+     * @throws  invalid_argument, if from or to has more then two dimensions or from and to have varying feature count
+     */
+    af::array manhattan(const af::array& from, const af::array& to, MPI_Comm comm);
 } // juml
 
 #endif // DISTANCES_H
@@ -16,14 +16,31 @@
 
 
 #include "classification/ANN.h"
+#include "data/ChunkIterator.h"
+#include "data/DatasetGroup.h"
+#include "data/SparseDataset.h"
 #include <stdexcept>
 #include <iostream>
 namespace juml {
 
 Dataset SequentialNeuralNet::predict(Dataset& X) const {
 	X.load_equal_chunks();
-	af::array result = this->predict_array(X.data());
-	return Dataset(result, this->comm_);
+	if (!X.is_streamed() && !X.is_compact()) {
+		af::array result = this->predict_array(X.data());
+		return Dataset(result, X.comm(), 1);
+	}
+
+	// out-of-core or compact data, only a single block of samples is expanded at a time
+	if (this->layers.size() == 0) {
+		throw std::runtime_error("Need at least 1 layer");
+	}
+	af::array result = af::constant(0, this->layers.back()->node_count, X.n_samples());
+	for (ChunkIterator blocks(X); blocks.has_next();) {
+		const af::array& block = blocks.next();
+		af::seq samples(blocks.offset(), blocks.offset() + block.dims(1) - 1);
+		result(af::span, samples) = this->predict_array(block);
+	}
+	return Dataset(result, X.comm(), 1);
 }
 
 af::array SequentialNeuralNet::predict_array(af::array X) const {
@@ -42,9 +59,10 @@ af::array SequentialNeuralNet::classify_array(af::array X) const {
 }
 
 Dataset SequentialNeuralNet::classify(Dataset& X) const {
-	X.load_equal_chunks();
-	af::array result = this->classify_array(X.data());
-	return Dataset(result, this->comm_);
+	Dataset result = this->predict(X);
+	af::array values, idxs;
+	af::max(values, idxs, result.data(), 0);
+	return Dataset(idxs, X.comm(), 1);
 }
 
 int SequentialNeuralNet::classify_accuracy_array(const af::array X, const af::array y) const {
@@ -55,14 +73,25 @@ int SequentialNeuralNet::classify_accuracy_array(const af::array X, const af::ar
 }
 
 float SequentialNeuralNet::classify_accuracy(Dataset& X, Dataset& y) const {
-	X.load_equal_chunks();
-	y.load_equal_chunks();
-	return this->classify_accuracy(X.data(), y.data());
+	DatasetGroup::joint_load(X, y);
+	if (X.data().issparse()) {
+		return this->classify_accuracy(X.data(), y.data());
+	}
+
+	// only a single block of samples is expanded or read at a time
+	long long counts[2] = {0, X.n_samples()};
+	for (ChunkIterator blocks(X); blocks.has_next();) {
+		const af::array& block = blocks.next();
+		af::seq samples(blocks.offset(), blocks.offset() + block.dims(1) - 1);
+		counts[0] += af::count<int>(this->classify_array(block) == y.data()(af::span, samples));
+	}
+	MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_LONG_LONG, MPI_SUM, this->comm_);
+	return static_cast<float>(counts[0]) / counts[1];
 }
 
 float SequentialNeuralNet::classify_accuracy(af::array X, af::array y) const {
 	int correct = classify_accuracy_array(X, y);
-	int all = X.dims(1);
+	int all = X.issparse() ? X.dims(0) : X.dims(1);
 	MPI_Allreduce(MPI_IN_PLACE, &all, 1, MPI_INT, MPI_SUM, this->comm_);
 
 	return ((float)correct)/all;
@@ -82,9 +111,31 @@ void SequentialNeuralNet::classify_confusion_array(const af::array& X, const af:
 }
 
 void SequentialNeuralNet::classify_confusion(Dataset& X, Dataset& y, af::array& outconfusion, float* outaccuracy) const {
-	X.load_equal_chunks();
-	y.load_equal_chunks();
-	this->classify_confusion(X.data(), y.data(), outconfusion, outaccuracy);
+	DatasetGroup::joint_load(X, y);
+	if (X.data().issparse()) {
+		this->classify_confusion(X.data(), y.data(), outconfusion, outaccuracy);
+		return;
+	}
+	if (this->layers.size() == 0) {
+		throw std::runtime_error("Need at least 1 layer");
+	}
+
+	// the confusion and the correct count are accumulated block by block
+	const int n_classes = this->layers.back()->node_count;
+	outconfusion = af::constant(0, n_classes, n_classes, u32);
+	long long counts[2] = {0, X.n_samples()};
+	for (ChunkIterator blocks(X); blocks.has_next();) {
+		const af::array& block = blocks.next();
+		af::seq samples(blocks.offset(), blocks.offset() + block.dims(1) - 1);
+		af::array confusion;
+		int correct;
+		this->classify_confusion_array(block, y.data()(af::span, samples), confusion, &correct);
+		outconfusion += confusion;
+		counts[0] += correct;
+	}
+	mpi::allreduce_inplace(outconfusion, MPI_SUM, this->comm_);
+	MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_LONG_LONG, MPI_SUM, this->comm_);
+	*outaccuracy = static_cast<float>(counts[0]) / counts[1];
 }
 
 void SequentialNeuralNet::classify_confusion(const af::array& X, af::array& y, af::array& outconfusion, float* outaccuracy) const {
@@ -92,7 +143,7 @@ void SequentialNeuralNet::classify_confusion(const af::array& X, af::array& y, a
 	this->classify_confusion_array(X, y, outconfusion, &count);
 	mpi::allreduce_inplace(outconfusion, MPI_SUM, this->comm_);
 	MPI_Allreduce(MPI_IN_PLACE, &count, 1, MPI_INT, MPI_SUM, this->comm_);
-	int all = X.dims(1);
+	int all = X.issparse() ? X.dims(0) : X.dims(1);
 	MPI_Allreduce(MPI_IN_PLACE, &all, 1, MPI_INT, MPI_SUM, this->comm_);
 	*outaccuracy = ((float)count) / all;
 }
@@ -101,19 +152,18 @@ void SequentialNeuralNet::fit(Dataset& X, Dataset& y) {
 	if (this->layers.size() == 0) {
 		throw std::runtime_error("Need at least 1 layer");
 	}
-	X.load_equal_chunks();
-	if (X.data().dims(0) != this->layers[0]->input_count) {
+	DatasetGroup::joint_load(X, y);
+	if (X.n_features() != this->layers[0]->input_count) {
 		std::stringstream errMsg;
-		errMsg << "Number of features (" << X.data().dims(0) 
+		errMsg << "Number of features (" << X.n_features() 
 			<< ") does not match inputs to neural net in first layer ("
 			<< this->layers[0]->input_count << ")";
 		throw std::runtime_error(errMsg.str());
 	}
-	y.load_equal_chunks();
-	if (X.data().dims(1) != y.data().dims(1)) {
+	if (X.n_samples() != y.data().dims(1)) {
 		std::stringstream errMsg;
 		errMsg << "Number of samples ("
-			<< X.data().dims(1)
+			<< X.n_samples()
 			<< ") does not match number of labels ("
 			<< y.data().dims(1)
 			<< ")";
@@ -134,8 +184,8 @@ void SequentialNeuralNet::fit(Dataset& X, Dataset& y) {
 	const float learningrate = 1;
 	af::array& Xdata = X.data();
 	af::array ydata = y.data();
-	const int n_samples = Xdata.dims(1);
-	const int n_features = Xdata.dims(0);
+	const int n_samples = X.n_samples();
+	const int n_features = X.n_features();
 	const int batchsize = 1;
 	const float max_error = 0.001;
 	af::array target(this->layers.back()->node_count, batchsize);
@@ -146,8 +196,9 @@ void SequentialNeuralNet::fit(Dataset& X, Dataset& y) {
 			// (Number of Nodes in last layer=O)xb
 			int last_batch_index = std::min(i+batchsize - 1, (int)ydata.dims(1) - 1);
 			target = ydata(af::span, af::seq(i, last_batch_index));
-			// Fxb
-			af::array sample = Xdata(af::span, af::seq(i, last_batch_index));
+			// Fxb, or bxF for sparse samples
+			af::array sample = Xdata.issparse() ? SparseDataset::rows(Xdata, i, last_batch_index)
+			                                    : X.dequantize(Xdata(af::span, af::seq(i, last_batch_index)));
 			error += this->fitBatch(sample, target, learningrate);
 		}
 		if (this->mpi_rank_ == 0) {
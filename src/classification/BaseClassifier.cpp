@@ -23,4 +23,11 @@ namespace juml {
     void BaseClassifier::fit(Dataset& X, Dataset& y) {
         this->class_normalizer_.index(y);
     };
+
+    void BaseClassifier::predict_to(Dataset& X, DatasetWriter& output, dim_t block_size) const {
+        output.append_blocks(X, [this](const af::array& block) {
+            Dataset samples(block, MPI_COMM_SELF);
+            return this->predict(samples).data();
+        }, block_size);
+    }
 } // namespace juml
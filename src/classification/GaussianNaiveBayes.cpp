@@ -20,9 +20,26 @@
 #include "core/Backend.h"
 #include "core/MPI.h"
 #include "classification/GaussianNaiveBayes.h"
+#include "data/ChunkIterator.h"
+#include "data/DatasetGroup.h"
 #include "stats/Distributions.h"
 
 namespace juml {
+    // relative variance floor for features that are constant within a class, like var_smoothing of scikit-learn
+    static const double VARIANCE_SMOOTHING = 1e-9;
+
+    static af::array add(const af::array& lhs, const af::array& rhs) {
+        return lhs + rhs;
+    }
+
+    static af::array subtract(const af::array& lhs, const af::array& rhs) {
+        return lhs - rhs;
+    }
+
+    static af::array divide(const af::array& lhs, const af::array& rhs) {
+        return lhs / rhs;
+    }
+
     GaussianNaiveBayes::GaussianNaiveBayes(int backend, MPI_Comm comm)
       : BaseClassifier(backend, comm)
     {}
@@ -30,11 +47,9 @@ namespace juml {
     void GaussianNaiveBayes::fit(Dataset& X, Dataset& y) {
         Backend::set(this->backend_.get());
         
-        X.load_equal_chunks();
-        y.load_equal_chunks();
+        DatasetGroup::joint_load(X, y);
         BaseClassifier::fit(X, y);        
         
-        const af::array& X_ = X.data();
         const af::array& y_ = y.data();
         
         const dim_t n_classes = this->class_normalizer_.n_classes();
@@ -45,12 +60,34 @@ namespace juml {
         
         af::array transformed_labels = this->class_normalizer_.transform(y_);
         for (int label = 0; label < n_classes; ++label) {
-            af::array class_index = (transformed_labels == label);
-            this->class_counts_(label) = af::sum<int>(class_index);
-            if (!af::anyTrue<bool>(this->class_counts_(label)))
-                continue;
-            af::array accumulated = af::sum(X_(af::span, class_index), 1);
-            this->theta_.col(label) = accumulated;
+            this->class_counts_(label) = af::sum<int>(transformed_labels == label);
+        }
+
+        // sparse samples (rows of a CSR array), the per class sums are sparse matrix products with the class indicators
+        const bool sparse = X.data().issparse();
+        af::array indicators;
+        af::array local_sums;
+        af::array local_counts;
+        if (sparse) {
+            af::array classes = af::range(af::dim4(1, n_classes), 1);
+            indicators = (af::tile(transformed_labels.T(), 1, n_classes) == af::tile(classes, X.n_samples(), 1));
+            indicators = indicators.as(X.data().type());
+            this->theta_ = af::matmul(X.data(), indicators, AF_MAT_TRANS).as(f32);
+            local_sums = this->theta_.copy();
+            local_counts = this->class_counts_.copy();
+        }
+
+        // accumulate the feature sums per class block by block
+        ChunkIterator blocks(X);
+        while (!sparse && blocks.has_next()) {
+            const af::array& X_ = blocks.next();
+            af::array labels = transformed_labels(af::seq(blocks.offset(), blocks.offset() + X_.dims(1) - 1));
+            for (int label = 0; label < n_classes; ++label) {
+                af::array class_index = (labels == label);
+                if (!af::anyTrue<bool>(class_index))
+                    continue;
+                this->theta_.col(label) += af::sum(X_(af::span, class_index), 1);
+            }
         }
         this->prior_ = this->class_counts_;
         
@@ -81,16 +118,29 @@ namespace juml {
             this->theta_(row, af::span) /= this->class_counts_;
         }
         
-        // calculate standard deviation for each feature
-        for (int label = 0; label < n_classes; ++label) {
-            af::array class_index = (transformed_labels == label);
-            if (!af::anyTrue<bool>(class_index))
-                continue;
-            af::array samples = X_(af::span, class_index);
-            af::gforSet(true);
-                af::array deviations = af::pow(samples - this->theta_(af::span, label), 2);
-            af::gforSet(false);
-            this->stddev_(af::span, label) = af::sum(deviations, 1);
+        // calculate standard deviation for each feature, sum (x - m)^2 = sum x^2 - 2 m sum x + n m^2 for sparse samples
+        if (sparse) {
+            af::array values = af::sparseGetValues(X.data());
+            af::array squares = af::sparse(X.n_samples(), X.n_features(), values * values,
+                                           af::sparseGetRowIdx(X.data()), af::sparseGetColIdx(X.data()),
+                                           AF_STORAGE_CSR);
+            af::array square_sums = af::matmul(squares, indicators, AF_MAT_TRANS).as(f32);
+            af::array counts = af::tile(local_counts, X.n_features(), 1);
+            this->stddev_ = square_sums - 2 * this->theta_ * local_sums + counts * this->theta_ * this->theta_;
+        }
+        for (blocks.reset(); !sparse && blocks.has_next();) {
+            const af::array& X_ = blocks.next();
+            af::array labels = transformed_labels(af::seq(blocks.offset(), blocks.offset() + X_.dims(1) - 1));
+            for (int label = 0; label < n_classes; ++label) {
+                af::array class_index = (labels == label);
+                if (!af::anyTrue<bool>(class_index))
+                    continue;
+                af::array samples = X_(af::span, class_index);
+                af::gforSet(true);
+                    af::array deviations = af::pow(samples - this->theta_(af::span, label), 2);
+                af::gforSet(false);
+                this->stddev_(af::span, label) += af::sum(deviations, 1);
+            }
         }
         
         // exchange the standard deviations values
@@ -100,29 +150,68 @@ namespace juml {
         gfor (af::seq row, X.n_features()) {
             this->stddev_(row, af::span) /= this->class_counts_;
         }
-        this->stddev_ = af::sqrt(this->stddev_);
+        // the expanded sparse sums may cancel to slightly negative values for constant features
+        this->stddev_ = af::sqrt(af::max(this->stddev_, 0.0));
     }
 
     Dataset GaussianNaiveBayes::predict_probability(Dataset& X) const {
         const dim_t n_classes = this->class_normalizer_.n_classes();
         Backend::set(this->backend_.get());
         X.load_equal_chunks();
+        if (X.data().issparse()) {
+            return Dataset(this->sparse_probability(X.data()), X.comm(), 1);
+        }
         af::array probabilities = af::constant(1.0f, n_classes, X.n_samples());
-        
-        const af::array& X_ = X.data();
-        gfor (af::seq sample, X.n_samples()) {
-            probabilities(af::span, sample) *= this->prior_.T();
-            
-            for (int label = 0; label < n_classes; ++label) {
-                af::array mean = this->theta_(af::span, label);
-                af::array stddev = this->stddev_(af::span, label);
-                af::array X_row = X_(af::span, sample);
-                af::array class_probability = gaussian_pdf(X_row, mean, stddev);
-                probabilities(label, sample) = af::product(class_probability, 0);
+
+        // only a single block of samples is expanded or read at a time
+        for (ChunkIterator blocks(X); blocks.has_next();) {
+            const af::array& X_ = blocks.next();
+            af::array block_probabilities = af::constant(1.0f, n_classes, X_.dims(1));
+            gfor (af::seq sample, X_.dims(1)) {
+                block_probabilities(af::span, sample) *= this->prior_.T();
+
+                for (int label = 0; label < n_classes; ++label) {
+                    af::array mean = this->theta_(af::span, label);
+                    af::array stddev = this->stddev_(af::span, label);
+                    af::array X_row = X_(af::span, sample);
+                    af::array class_probability = gaussian_pdf(X_row, mean, stddev);
+                    block_probabilities(label, sample) = af::product(class_probability, 0);
+                }
             }
+            probabilities(af::span, af::seq(blocks.offset(), blocks.offset() + X_.dims(1) - 1)) = block_probabilities;
         }
-        
-        return Dataset(probabilities, this->comm_);
+
+
+        return Dataset(probabilities, X.comm(), 1);
+    }
+
+    af::array GaussianNaiveBayes::sparse_probability(const af::array& X) const {
+        // features that are zero within a class have no variance, the floor keeps their log-likelihood finite
+        af::array variance = (this->stddev_ * this->stddev_).as(f64);
+        const double largest = af::max<double>(variance);
+        variance += VARIANCE_SMOOTHING * (largest > 0.0 ? largest : 1.0);
+
+        // log of the prior times the product of the gaussians, expanded so that only the non-zero features enter
+        // matrix products: sum_f log pdf(x_f) = sum_f -log(sqrt(2 pi) s) - m^2 / 2s^2 + x_f m / s^2 - x_f^2 / 2s^2,
+        // in double precision as the terms of floored variances are large and cancel
+        const af::array row_pointers = af::sparseGetRowIdx(X);
+        const af::array columns = af::sparseGetColIdx(X);
+        const af::array values = af::sparseGetValues(X).as(f64);
+        af::array samples = af::sparse(X.dims(0), X.dims(1), values, row_pointers, columns, AF_STORAGE_CSR);
+        af::array squares = af::sparse(X.dims(0), X.dims(1), values * values, row_pointers, columns, AF_STORAGE_CSR);
+        af::array theta = this->theta_.as(f64);
+        af::array constants = af::sum(-0.5 * af::log(2.0 * af::Pi * variance) - theta * theta / (2.0 * variance), 0)
+                              + af::log(this->prior_.as(f64));
+        af::array log_joint = af::matmul(samples, theta / variance) + af::matmul(squares, -0.5 / variance);
+        log_joint = af::batchFunc(log_joint, constants, add);
+
+        // the exponentials of sums over many features under- or overflow, relative to the most likely class they do
+        // not, normalizing them yields the posterior
+        af::array probabilities = af::exp(af::batchFunc(log_joint, af::max(log_joint, 1), subtract));
+        probabilities = af::batchFunc(probabilities, af::sum(probabilities, 1), divide);
+
+        // classes x samples like the dense probabilities
+        return af::transpose(probabilities).as(f32);
     }
 
     Dataset GaussianNaiveBayes::predict(Dataset& X) const {
@@ -135,7 +224,7 @@ namespace juml {
         af::max(values, locations, probabilities.data(), 0);
         af::array locations_orig = this->class_normalizer_.invert(locations);
                 
-        return Dataset(locations_orig, this->comm_);
+        return Dataset(locations_orig, X.comm(), 1);
     }
 
     float GaussianNaiveBayes::accuracy(Dataset& X, Dataset& y) const {
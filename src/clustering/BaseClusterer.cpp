@@ -19,5 +19,12 @@ namespace juml {
     BaseClusterer::BaseClusterer(int backend, MPI_Comm comm)
       : Algorithm(backend, comm) 
     {};
+
+    void BaseClusterer::predict_to(Dataset& X, DatasetWriter& output, dim_t block_size) const {
+        output.append_blocks(X, [this](const af::array& block) {
+            Dataset samples(block, MPI_COMM_SELF);
+            return this->predict(samples).data();
+        }, block_size);
+    }
 } // namespace juml
 
@@ -14,12 +14,14 @@
 */
 
 #include <random>
+#include <vector>
 #include <set>
 #include <stdexcept>
 #include <core/HDF5.h>
 
 #include "core/MPI.h"
 #include "clustering/KMeans.h"
+#include "data/ChunkIterator.h"
 
 namespace juml {
     KMeans::KMeans(
@@ -60,57 +62,93 @@ namespace juml {
     }
 
     void KMeans::initialize_random_centroids(const Dataset& dataset) {
-        const af::array& data = dataset.data();
-
         // initialize random generator
         std::mt19937 random_state(this->seed_);
         std::uniform_int_distribution<intl> index_selector(0, dataset.global_n_samples() - 1);
 
+        // randomly roll the centroid indices
+        std::vector<intl> indices(this->k_);
+        for (uint i = 0; i < this->k_; ++i) {
+            indices[i] = index_selector(random_state);
+        }
+
         // create a centroid array that holds the locally chosen centroids
-        this->centroids_ = af::constant(0, data.dims(0), static_cast<dim_t>(this->k_), data.type());
+        ChunkIterator blocks(dataset);
+        for (bool first = true; blocks.has_next(); first = false) {
+            const af::array& data = blocks.next();
+            if (first) {
+                this->centroids_ = af::constant(0, dataset.n_features(), static_cast<dim_t>(this->k_), data.type());
+            }
 
-        // randomly roll the centroids
-        for (uint i = 0; i < this->k_; ++i) {
-            intl index = index_selector(random_state);
-            if (dataset.global_offset() <= index && index <= dataset.global_offset() + data.dims(1)) {
-                this->centroids_(af::span, i) = data(af::span, index - dataset.global_offset());
+            const intl begin = blocks.global_offset();
+            const intl end = begin + data.dims(1);
+            for (uint i = 0; i < this->k_; ++i) {
+                if (begin <= indices[i] && indices[i] < end) {
+                    this->centroids_(af::span, i) = data(af::span, indices[i] - begin);
+                }
             }
         }
+        if (this->centroids_.isempty()) {
+            this->centroids_ = af::constant(0, dataset.n_features(), static_cast<dim_t>(this->k_));
+        }
         mpi::allreduce_inplace(this->centroids_, MPI_SUM, this->comm_);
     }
     
     void KMeans::initialize_kpp_centroids(const Dataset& dataset) {
-        const af::array& data = dataset.data();
-
-        dim_t f = data.dims(0);
-        dim_t n = data.dims(1);
+        dim_t f = dataset.n_features();
+        ChunkIterator blocks(dataset);
 
         // initialize random generator
         std::mt19937 random_state(this->seed_);
         std::uniform_int_distribution<intl> index_selector(0, dataset.global_n_samples() - 1);
 
         // choose first centroid randomly and broadcast it
-        af::array centroids = af::constant(0, f, data.type());
+        af::array centroids;
         intl index = index_selector(random_state);
-        if (dataset.global_offset() <= index && index <= dataset.global_offset() + n)
-            centroids += data(af::span, index - dataset.global_offset());
+        while (blocks.has_next()) {
+            const af::array& data = blocks.next();
+            if (centroids.isempty())
+                centroids = af::constant(0, f, data.type());
+            if (blocks.global_offset() <= index && index < blocks.global_offset() + data.dims(1))
+                centroids += data(af::span, index - blocks.global_offset());
+        }
+        if (centroids.isempty())
+            centroids = af::constant(0, f);
         mpi::allreduce_inplace(centroids, MPI_SUM, this->comm_);
+        const af::dtype type = centroids.type();
 
         // calculate the total distance psi and the number of initialization steps
-        af::array total_distance = af::sum(this->distance_(centroids, data), 1 /* along samples */);
+        af::array total_distance = af::constant(0, 1, type);
+        for (blocks.reset(); blocks.has_next();) {
+            total_distance += af::sum(this->distance_(centroids, blocks.next()), 1 /* along samples */);
+        }
         mpi::allreduce_inplace(total_distance, MPI_SUM, this->comm_);
         uintl initialization_steps = af::ceil(af::log(total_distance)).as(u64).scalar<uintl>();
 
         // pick centroid candidates for initilization_steps time (log(psi))
+        std::vector<af::array> block_distances(static_cast<size_t>(blocks.n_blocks()));
         for (uintl i = 0; i < initialization_steps; ++i) {
-            // select closest distance
-            af::array distances = af::min(this->distance_(centroids, data), 0);
-            // calculate probability
-            af::array probabilities = (2.0 * distances) / af::tile(af::sum(distances, 1), 1, n);
-            af::array boundary = af::randu(1, n);
+            // select closest distance for each block and sum them up locally
+            af::array distance_sum = af::constant(0, 1, type);
+            size_t b = 0;
+            for (blocks.reset(); blocks.has_next(); ++b) {
+                block_distances[b] = af::min(this->distance_(centroids, blocks.next()), 0);
+                distance_sum += af::sum(block_distances[b], 1);
+            }
 
-            // pick samples and exchange globally
-            af::array candidates = data(af::span, probabilities > boundary);
+            // calculate probability and pick samples
+            af::array candidates;
+            b = 0;
+            for (blocks.reset(); blocks.has_next(); ++b) {
+                const af::array& data = blocks.next();
+                dim_t n = data.dims(1);
+                af::array probabilities = (2.0 * block_distances[b]) / af::tile(distance_sum, 1, n);
+                af::array boundary = af::randu(1, n);
+                af::array picked = data(af::span, probabilities > boundary);
+                if (picked.dims(1) > 0) {
+                    candidates = candidates.isempty() ? picked : af::join(1, candidates, picked);
+                }
+            }
 
             // obtain global number of candidates and own offset
             intl offset = candidates.dims(1);
@@ -122,7 +160,7 @@ namespace juml {
                 offset = 0;
 
             // prepare local candidates for transmission in offset candidate mask
-            af::array global_candidates = af::constant(0, f, items, candidates.type());
+            af::array global_candidates = af::constant(0, f, items, type);
             if (candidates.dims(1) > 0) {
                 af::seq insert_location = af::seq(af::seq(offset, offset + candidates.dims(1) - 1), true);
                 global_candidates(af::span, insert_location) = candidates;
@@ -132,16 +170,21 @@ namespace juml {
             mpi::allreduce_inplace(global_candidates, MPI_SUM, this->comm_);
             centroids = af::join(1, centroids, global_candidates);
         }
+        block_distances.clear();
 
         // initialize the final centroids to be empty
-        this->centroids_ = af::constant(0, f, this->k_, data.type());
+        this->centroids_ = af::constant(0, f, this->k_, type);
 
         // select k points from the candidates
         dim_t number_of_candidates = centroids.dims(1);
-        af::array locations = this->closest_centroids(centroids, data);
         af::array weights = af::constant(0, number_of_candidates, s64);
-        gfor (af::seq j, number_of_candidates) {
-            weights(j) = af::sum(locations == j);
+        for (blocks.reset(); blocks.has_next();) {
+            af::array locations = this->closest_centroids(centroids, blocks.next());
+            af::array block_weights = af::constant(0, number_of_candidates, s64);
+            gfor (af::seq j, number_of_candidates) {
+                block_weights(j) = af::sum(locations == j);
+            }
+            weights += block_weights;
         }
         mpi::allreduce_inplace(weights, MPI_SUM, this->comm_);
 
@@ -181,33 +224,43 @@ namespace juml {
     }
 
     void KMeans::cluster(const Dataset& dataset) {
-        const af::array& data = dataset.data();
-
         // dimensions
-        dim_t f = data.dims(0); // features
+        dim_t f = dataset.n_features(); // features
         dim_t k = static_cast<dim_t>(this->k_); // centroid count
-        dim_t n = data.dims(1); // number of sample
 
         // calculate the convergence threshold globally
         uintl threshold = static_cast<uintl>(std::floor(this->tolerance_ * dataset.global_n_samples()));
 
-        // remember the cluster assignments in order to break on changes
-        af::array previous_assignments = af::constant(-1, 1, n);
+        // remember the cluster assignments of each block in order to break on changes
+        ChunkIterator blocks(dataset);
+        std::vector<af::array> previous_assignments(static_cast<size_t>(blocks.n_blocks()));
 
         // perform actual clustering
         for (uint i = 0; i < this->max_iter_; ++i) {
-            af::array locations = this->closest_centroids(this->centroids_, data);
-            af::array changes = af::tile(af::sum(previous_assignments != locations), f);
-
-            // update the centroids
-            af::array centroid_update = af::constant(0, f, 2 * k + 1, data.type());
-            gfor (af::seq j, k) {
-                af::array closeness_volume = af::tile((locations == j), f);
-                centroid_update(af::span, j) = af::sum(data * closeness_volume, 1 /* along the samples */);
-                af::seq second_half(af::seq(k, 2 * k - 1), true);
-                centroid_update(af::span, second_half) = af::sum(closeness_volume, 1);
+            af::array centroid_update = af::constant(0, f, 2 * k + 1, this->centroids_.type());
+
+            size_t b = 0;
+            for (blocks.reset(); blocks.has_next(); ++b) {
+                const af::array& data = blocks.next();
+                dim_t n = data.dims(1); // number of samples in the block
+
+                af::array locations = this->closest_centroids(this->centroids_, data);
+                if (previous_assignments[b].isempty())
+                    previous_assignments[b] = af::constant(-1, 1, n);
+                af::array changes = af::tile(af::sum(previous_assignments[b] != locations), f);
+
+                // update the centroids
+                af::array block_update = af::constant(0, f, 2 * k + 1, centroid_update.type());
+                gfor (af::seq j, k) {
+                    af::array closeness_volume = af::tile((locations == j), f);
+                    block_update(af::span, j) = af::sum(data * closeness_volume, 1 /* along the samples */);
+                    af::seq second_half(af::seq(k, 2 * k - 1), true);
+                    block_update(af::span, second_half) = af::sum(closeness_volume, 1);
+                }
+                block_update(af::span, 2 * k) = changes;
+                centroid_update += block_update;
+                previous_assignments[b] = locations;
             }
-            centroid_update(af::span, 2 * k) = changes;
 
             // exchange and average update
             mpi::allreduce_inplace(centroid_update, MPI_SUM, this->comm_);
@@ -218,7 +271,6 @@ namespace juml {
 
             // count the number of cluster assignment changes and leave the loop if below threshold
             if ((centroid_update(0, 2 * k) < threshold).as(u8).scalar<unsigned char>()) break;
-            previous_assignments = locations;
         }
     }
     
@@ -228,8 +280,7 @@ namespace juml {
         X.load_equal_chunks();
 
         // dimensionality checks
-        af::array& data = X.data();
-        if (data.dims(2) > 1 || data.dims(3) > 1) {
+        if (X.sample_dim() > 1) {
             throw std::invalid_argument("K-Means clustering is only defined for two-dimensional input data");
         }
 
@@ -250,8 +301,19 @@ namespace juml {
         Backend::set(this->backend_.get());
         X.load_equal_chunks();
 
-        af::array locations = this->closest_centroids(this->centroids_, X.data());
-        return Dataset(locations, this->comm_);
+        if (!X.is_streamed() && !X.is_compact()) {
+            af::array locations = this->closest_centroids(this->centroids_, X.data());
+            return Dataset(locations, X.comm(), 1);
+        }
+
+        // out-of-core or compact data, assign the closest centroids block by block
+        af::array locations = af::constant(0, 1, X.n_samples(), u32);
+        for (ChunkIterator blocks(X); blocks.has_next();) {
+            const af::array& data = blocks.next();
+            af::seq samples(static_cast<double>(blocks.offset()), static_cast<double>(blocks.offset() + data.dims(1) - 1));
+            locations(0, samples) = this->closest_centroids(this->centroids_, data);
+        }
+        return Dataset(locations, X.comm(), 1);
     }
 
     const af::array& KMeans::centroids() const {
@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
 
 #include "core/HDF5.h"
@@ -41,7 +42,7 @@ namespace hdf5 {
     }
 
     hid_t af_to_h5(af::dtype af_type) {
-        if  (af_type == u8)     return H5T_NATIVE_CHAR;
+        if  (af_type == u8)     return H5T_NATIVE_UCHAR;
         else if (af_type == b8)     return H5T_NATIVE_B8;
         else if (af_type == s16)    return H5T_NATIVE_SHORT;
         else if (af_type == u16)    return H5T_NATIVE_USHORT;
@@ -107,16 +108,14 @@ namespace hdf5 {
         H5Dclose(dset_id);
     }
 
-    hid_t popen_file(const std::string &filename, MPI_Comm comm) {
+    hid_t popen_file(const std::string &filename, MPI_Comm comm, const IOProfile& profile) {
         // create access list for parallel IO
-        hid_t access_plist = H5Pcreate(H5P_FILE_ACCESS);
-        if (access_plist < 0)
-            throw std::runtime_error("Could not create file access property list");
-        H5Pset_fapl_mpio(access_plist, comm, MPI_INFO_NULL);
+        hid_t access_plist = profile.file_access_list(comm);
 
         // create file handle
         const hid_t file_id = H5Fopen(filename.c_str(), H5F_ACC_RDWR, access_plist);
         if (file_id < 0) {
+            H5Pclose(access_plist);
             std::stringstream error;
             error << "Could not open file " << filename;
             throw std::runtime_error(error.str().c_str());
@@ -126,10 +125,11 @@ namespace hdf5 {
         return file_id;
     }
 
-    af::array pread_array(hid_t file_id, const std::string& dataset) {
+    static af::array read_array(hid_t file_id, const std::string& dataset, bool convert, af::dtype type) {
         hid_t dataset_id = H5Dopen(file_id, dataset.c_str(), H5P_DEFAULT);
-        // determine the dataset type
-        hid_t native_type = H5Tget_native_type(H5Dget_type(dataset_id), H5T_DIR_ASCEND);
+        // determine the dataset type, HDF5 converts to the target type during the read if requested
+        hid_t native_type = convert ? H5Tcopy(af_to_h5(type))
+                                    : H5Tget_native_type(H5Dget_type(dataset_id), H5T_DIR_ASCEND);
 
         // create file space
         const hid_t file_space_id = H5Dget_space(dataset_id);
@@ -177,5 +177,12 @@ namespace hdf5 {
         H5Dclose(dataset_id);
         return data;
     }
+    af::array pread_array(hid_t file_id, const std::string& dataset) {
+        return read_array(file_id, dataset, false, f32);
+    }
+
+    af::array pread_array(hid_t file_id, const std::string& dataset, af::dtype type) {
+        return read_array(file_id, dataset, true, type);
+    }
 } // namespace hdf5
 } // namespace juml
\ No newline at end of file
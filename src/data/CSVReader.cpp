@@ -0,0 +1,296 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: CSVReader.cpp
+*
+* Description: Implementation of class CSVReader
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "data/CSVReader.h"
+
+namespace juml {
+    /**
+     * POWERS_OF_TEN
+     *
+     * The powers of ten that are exactly representable as double.
+     */
+    static const double POWERS_OF_TEN[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    static inline bool is_blank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    CSVReader::CSVReader(const std::string& filename, char delimiter, bool header, MPI_Comm comm)
+      : filename_(filename),
+        delimiter_(delimiter),
+        header_(header),
+        comm_(comm) {
+        MPI_Comm_rank(this->comm_, &this->mpi_rank_);
+        MPI_Comm_size(this->comm_, &this->mpi_size_);
+    }
+
+    void CSVReader::read_range(std::vector<char>& buffer) const {
+        const int fd = open(this->filename_.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            if (fd >= 0) close(fd);
+            std::stringstream error;
+            error << "Could not open file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // equal byte ranges, a node owns the lines starting in its range
+        const off_t size = info.st_size;
+        const off_t begin = static_cast<off_t>(static_cast<long double>(size) * this->mpi_rank_ / this->mpi_size_);
+        const off_t end = static_cast<off_t>(static_cast<long double>(size) * (this->mpi_rank_ + 1) / this->mpi_size_);
+        const off_t first = std::max(begin - 1, static_cast<off_t>(0));
+
+        // read the range and extend it until the line containing its last byte is complete
+        const off_t step = 1 << 16;
+        buffer.clear();
+        off_t position = first;
+        off_t target = end;
+        bool complete = begin == end;
+        while (!complete && position < size) {
+            const size_t length = static_cast<size_t>(std::min(target, size) - position);
+            const size_t offset = buffer.size();
+            buffer.resize(offset + length);
+            size_t got = 0;
+            while (got < length) {
+                const ssize_t status = pread(fd, buffer.data() + offset + got, length - got, position + got);
+                if (status < 0 && errno == EINTR) continue;
+                if (status <= 0) {
+                    close(fd);
+                    std::stringstream error;
+                    error << "Could not read file " << this->filename_;
+                    throw std::runtime_error(error.str().c_str());
+                }
+                got += static_cast<size_t>(status);
+            }
+            position += static_cast<off_t>(length);
+            target = position + step;
+
+            const size_t search = static_cast<size_t>(std::max(end - 1 - first, static_cast<off_t>(offset)));
+            complete = search < buffer.size() && std::find(buffer.begin() + search, buffer.end(), '\n') != buffer.end();
+        }
+        close(fd);
+        if (begin == end) return;
+
+        // cut the lines starting before the range and behind the line containing its last byte
+        const size_t last = static_cast<size_t>(end - 1 - first);
+        auto stop = std::find(buffer.begin() + std::min(last, buffer.size()), buffer.end(), '\n');
+        if (stop != buffer.end()) ++stop;
+        buffer.erase(stop, buffer.end());
+        if (begin > 0) {
+            auto start = std::find(buffer.begin(), buffer.end(), '\n');
+            buffer.erase(buffer.begin(), start == buffer.end() ? start : start + 1);
+        }
+    }
+
+    af::array CSVReader::read() const {
+        // agree on I/O errors before the first collective operation, failing nodes keep their own error
+        std::vector<char> buffer;
+        int unreadable = 0;
+        std::string reason;
+        try {
+            this->read_range(buffer);
+        } catch (const std::runtime_error& e) {
+            unreadable = 1;
+            reason = e.what();
+        }
+        int any_unreadable = unreadable;
+        MPI_Allreduce(MPI_IN_PLACE, &any_unreadable, 1, MPI_INT, MPI_MAX, this->comm_);
+        if (any_unreadable) {
+            std::stringstream error;
+            if (unreadable) {
+                error << reason;
+            } else {
+                error << "Could not read file " << this->filename_ << " on another node";
+            }
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // locate the non-empty lines, the header is the first line of the first node
+        std::vector<const char*> begins;
+        std::vector<const char*> ends;
+        const char* cursor = buffer.data();
+        const char* const buffer_end = buffer.data() + buffer.size();
+        bool skip = this->header_ && this->mpi_rank_ == 0;
+        while (cursor < buffer_end) {
+            const char* line_end = static_cast<const char*>(std::memchr(cursor, '\n', buffer_end - cursor));
+            if (line_end == NULL) line_end = buffer_end;
+            const char* content = cursor;
+            while (content < line_end && is_blank(*content)) ++content;
+            if (skip) {
+                skip = false;
+            } else if (content < line_end) {
+                begins.push_back(cursor);
+                ends.push_back(line_end);
+            }
+            cursor = line_end + 1;
+        }
+
+        // all lines have as many values as the first one, nodes without lines adopt the count
+        long long n_values[2] = {-1, LLONG_MIN};
+        if (!begins.empty()) {
+            n_values[0] = 1 + std::count(begins[0], ends[0], this->delimiter_);
+            n_values[1] = -n_values[0];
+        }
+        MPI_Allreduce(MPI_IN_PLACE, n_values, 2, MPI_LONG_LONG, MPI_MAX, this->comm_);
+        const long long n_features = n_values[0];
+        if (n_features >= 0 && -n_values[1] != n_features) {
+            std::stringstream error;
+            error << "The lines of file " << this->filename_ << " have between " << -n_values[1] << " and "
+                  << n_features << " values";
+            throw std::domain_error(error.str().c_str());
+        }
+
+        // parse the lines in parallel, the values of a line are consecutive as in the features x samples layout
+        const long long n_lines = static_cast<long long>(begins.size());
+        std::vector<float> values(static_cast<size_t>(std::max(n_lines * n_features, 0LL)));
+        long long failed = n_lines;
+        #pragma omp parallel for schedule(static) reduction(min:failed)
+        for (long long line = 0; line < n_lines; ++line) {
+            const char* position = begins[line];
+            const char* const end = ends[line];
+            float* destination = values.data() + line * n_features;
+            bool valid = true;
+            for (long long feature = 0; feature < n_features && valid; ++feature) {
+                // an empty value is missing
+                const char* next = position;
+                while (next < end && is_blank(*next)) ++next;
+                if (next == end || *next == this->delimiter_) {
+                    destination[feature] = std::numeric_limits<float>::quiet_NaN();
+                    position = next;
+                } else {
+                    valid = CSVReader::parse_float(position, end, destination[feature]);
+                }
+                if (feature + 1 < n_features) {
+                    valid = valid && position < end && *position == this->delimiter_;
+                    ++position;
+                }
+            }
+            if (!valid || position != end) {
+                failed = std::min(failed, line);
+            }
+        }
+
+        // report the first malformed line on all nodes, so that no node enters a collective write alone
+        int malformed = failed < n_lines ? 1 : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &malformed, 1, MPI_INT, MPI_MAX, this->comm_);
+        if (malformed) {
+            std::stringstream error;
+            error << "Could not parse file " << this->filename_;
+            if (failed < n_lines) {
+                error << " near \"" << std::string(begins[failed], std::min(ends[failed], begins[failed] + 80))
+                      << "\"";
+            }
+            throw std::domain_error(error.str().c_str());
+        }
+
+        if (n_lines == 0 || n_features <= 0) {
+            return af::array();
+        }
+        return af::array(static_cast<dim_t>(n_features), static_cast<dim_t>(n_lines), values.data());
+    }
+
+    bool CSVReader::parse_float(const char*& cursor, const char* end, float& value) {
+        const char* position = cursor;
+        while (position < end && is_blank(*position)) ++position;
+        if (position == end) return false;
+
+        const bool negative = *position == '-';
+        if (*position == '-' || *position == '+') ++position;
+
+        // up to 19 significant digits fit into the mantissa, further digits only shift the exponent
+        unsigned long long mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+        bool any = false;
+        for (; position < end && *position >= '0' && *position <= '9'; ++position, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned long long>(*position - '0');
+                if (mantissa > 0) ++digits;
+            } else {
+                ++exponent;
+            }
+        }
+        if (position < end && *position == '.') {
+            for (++position; position < end && *position >= '0' && *position <= '9'; ++position, any = true) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<unsigned long long>(*position - '0');
+                    if (mantissa > 0) ++digits;
+                    --exponent;
+                }
+            }
+        }
+
+        // special values such as nan and inf are left to the C library
+        if (!any) {
+            char text[32];
+            const size_t length = std::min(static_cast<size_t>(end - cursor), sizeof(text) - 1);
+            std::memcpy(text, cursor, length);
+            text[length] = '\0';
+            char* next;
+            value = std::strtof(text, &next);
+            if (next == text) return false;
+            for (position = cursor + (next - text); position < end && is_blank(*position); ++position);
+            cursor = position;
+            return true;
+        }
+
+        if (position < end && (*position == 'e' || *position == 'E')) {
+            const char* exponent_start = position + 1;
+            bool negative_exponent = false;
+            if (exponent_start < end && (*exponent_start == '-' || *exponent_start == '+')) {
+                negative_exponent = *exponent_start == '-';
+                ++exponent_start;
+            }
+            if (exponent_start < end && *exponent_start >= '0' && *exponent_start <= '9') {
+                int explicit_exponent = 0;
+                for (position = exponent_start; position < end && *position >= '0' && *position <= '9'; ++position) {
+                    explicit_exponent = std::min(explicit_exponent * 10 + (*position - '0'), 100000);
+                }
+                exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+            }
+        }
+
+        double result = static_cast<double>(mantissa);
+        if (mantissa != 0 && exponent != 0) {
+            if (exponent > 0 && exponent <= 22) {
+                result *= POWERS_OF_TEN[exponent];
+            } else if (exponent < 0 && exponent >= -22) {
+                result /= POWERS_OF_TEN[-exponent];
+            } else {
+                result *= std::pow(10.0, exponent);
+            }
+        }
+        value = static_cast<float>(negative ? -result : result);
+        while (position < end && is_blank(*position)) ++position;
+        cursor = position;
+        return true;
+    }
+} // namespace juml
@@ -0,0 +1,246 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: ChunkIterator.cpp
+*
+* Description: Implementation of class ChunkIterator
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <algorithm>
+#include <mpi.h>
+#include <sstream>
+#include <stdexcept>
+
+#include "data/ChunkIterator.h"
+
+namespace juml {
+    /**
+     * COMPACT_BLOCK_SIZE
+     *
+     * The default number of samples per block for in-memory half precision or quantized datasets, bounds the size of
+     * the expanded f32 copy of a block.
+     */
+    static const dim_t COMPACT_BLOCK_SIZE = 1 << 16;
+
+    ChunkIterator::ChunkIterator(const Dataset& dataset, dim_t block_size)
+      : dataset_(dataset),
+        block_size_(block_size < 0 ? dataset.block_size() : block_size),
+        position_(0),
+        offset_(0),
+        file_id_(-1),
+        data_id_(-1),
+        type_(f32),
+        prefetch_(false),
+        block_index_(0),
+        filled_{false, false},
+        failed_{false, false},
+        durations_{0.0, 0.0},
+        stop_(false) {
+        const dim_t n_samples = this->dataset_.n_samples();
+        if (block_size < 0 && this->block_size_ == 0 && this->dataset_.is_compact()) {
+            this->block_size_ = COMPACT_BLOCK_SIZE;
+        }
+        if (this->block_size_ == 0 || this->block_size_ > n_samples) {
+            this->block_size_ = std::max(n_samples, static_cast<dim_t>(1));
+        }
+
+        if (this->dataset_.is_streamed()) {
+            this->file_id_ = this->dataset_.open_file();
+            try {
+                this->data_id_ = this->dataset_.open_dataset(this->file_id_);
+                this->type_ = this->dataset_.sample_type(this->data_id_);
+                this->block_dims_ = this->dataset_.sample_dims(this->data_id_, static_cast<hsize_t>(this->block_size_));
+            } catch (...) {
+                if (this->data_id_ >= 0) H5Dclose(this->data_id_);
+                H5Fclose(this->file_id_);
+                throw;
+            }
+
+            // HDF5 and MPI-IO calls are issued from the I/O thread concurrently to the caller's ones, e.g. the writes
+            // of a DatasetWriter, requires full thread support of MPI and a thread-safe HDF5 build
+            int thread_support;
+            MPI_Query_thread(&thread_support);
+            hbool_t thread_safe = 0;
+            H5is_library_threadsafe(&thread_safe);
+            this->prefetch_ = this->dataset_.prefetch() && thread_support == MPI_THREAD_MULTIPLE && thread_safe;
+            if (this->prefetch_) {
+                hid_t memory_type = this->dataset_.memory_type(this->data_id_);
+                size_t bytes = static_cast<size_t>(this->block_dims_.elements()) * H5Tget_size(memory_type);
+                H5Tclose(memory_type);
+
+                this->buffers_[0].resize(bytes);
+                this->buffers_[1].resize(bytes);
+                this->start_prefetching();
+            }
+        }
+    }
+
+    ChunkIterator::~ChunkIterator() {
+        this->stop_prefetching();
+        if (this->data_id_ >= 0) H5Dclose(this->data_id_);
+        if (this->file_id_ >= 0) H5Fclose(this->file_id_);
+    }
+
+    af::array ChunkIterator::slice(const af::array& data, dim_t begin, dim_t end) const {
+        af::seq samples(static_cast<double>(begin), static_cast<double>(end));
+        switch (this->dataset_.sample_dim()) {
+            case 0:  return data(samples);
+            case 1:  return data(af::span, samples);
+            case 2:  return data(af::span, af::span, samples);
+            default: return data(af::span, af::span, af::span, samples);
+        }
+    }
+
+    dim_t ChunkIterator::block_count(dim_t block) const {
+        return std::min(this->block_size_, this->dataset_.n_samples() - block * this->block_size_);
+    }
+
+    void ChunkIterator::start_prefetching() {
+        this->stop_ = false;
+        this->filled_[0] = this->filled_[1] = false;
+        this->io_thread_ = std::thread(&ChunkIterator::prefetch, this, this->block_index_);
+    }
+
+    void ChunkIterator::stop_prefetching() {
+        if (!this->io_thread_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->stop_ = true;
+        }
+        this->buffer_changed_.notify_all();
+        this->io_thread_.join();
+    }
+
+    void ChunkIterator::prefetch(dim_t first_block) {
+        const dim_t n_blocks = this->n_blocks();
+        for (dim_t block = first_block; block < n_blocks; ++block) {
+            const size_t slot = static_cast<size_t>(block % 2);
+            {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                this->buffer_changed_.wait(lock, [this, slot] { return this->stop_ || !this->filled_[slot]; });
+                if (this->stop_) return;
+            }
+
+            // read outside of the lock, the consumer only touches filled buffers
+            const hsize_t offset = static_cast<hsize_t>(this->dataset_.global_offset() + block * this->block_size_);
+            const double start = MPI_Wtime();
+            herr_t status = this->dataset_.read_samples(
+                this->data_id_, offset, static_cast<hsize_t>(this->block_count(block)), this->buffers_[slot].data());
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->durations_[slot] = MPI_Wtime() - start;
+                this->failed_[slot] = status < 0;
+                this->filled_[slot] = true;
+            }
+            this->buffer_changed_.notify_all();
+        }
+    }
+
+    bool ChunkIterator::has_next() const {
+        return this->position_ < this->dataset_.n_samples();
+    }
+
+    const af::array& ChunkIterator::next() {
+        if (!this->has_next()) {
+            throw std::out_of_range("No further blocks in dataset");
+        }
+        const dim_t count = this->block_count(this->block_index_);
+        const double start = MPI_Wtime();
+
+        if (this->prefetch_) {
+            const size_t slot = static_cast<size_t>(this->block_index_ % 2);
+            {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                this->buffer_changed_.wait(lock, [this, slot] { return this->filled_[slot]; });
+            }
+            this->stall_times_.push_back(MPI_Wtime() - start);
+            this->read_times_.push_back(this->durations_[slot]);
+
+            // copy the block out of the host buffer and hand the buffer back to the I/O thread
+            bool failed = this->failed_[slot];
+            if (!failed) {
+                af::dim4 dims = this->block_dims_;
+                dims[static_cast<unsigned int>(this->dataset_.sample_dim())] = count;
+                this->block_ = af::array(dims, this->type_);
+                af_write_array(this->block_.get(), this->buffers_[slot].data(), this->block_.bytes(), afHost);
+            }
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->filled_[slot] = false;
+            }
+            this->buffer_changed_.notify_all();
+
+            if (failed) {
+                std::stringstream error;
+                error << "Could not read block " << this->block_index_ << " of the dataset";
+                throw std::runtime_error(error.str().c_str());
+            }
+        } else if (this->dataset_.is_streamed()) {
+            const hsize_t offset = static_cast<hsize_t>(this->dataset_.global_offset() + this->position_);
+            this->block_ = this->dataset_.read_samples(this->data_id_, offset, static_cast<hsize_t>(count));
+            const double elapsed = MPI_Wtime() - start;
+            this->stall_times_.push_back(elapsed);
+            this->read_times_.push_back(elapsed);
+        } else if (count == this->dataset_.n_samples()) {
+            this->block_ = this->dataset_.dequantize(this->dataset_.data());
+            this->stall_times_.push_back(0.0);
+        } else {
+            this->block_ = this->dataset_.dequantize(
+                this->slice(this->dataset_.data(), this->position_, this->position_ + count - 1));
+            this->stall_times_.push_back(0.0);
+        }
+
+        this->offset_ = this->position_;
+        this->position_ += count;
+        ++this->block_index_;
+        return this->block_;
+    }
+
+    void ChunkIterator::reset() {
+        this->stop_prefetching();
+        this->position_ = 0;
+        this->offset_ = 0;
+        this->block_index_ = 0;
+        this->block_ = af::array();
+        this->stall_times_.clear();
+        this->read_times_.clear();
+        if (this->prefetch_) {
+            this->start_prefetching();
+        }
+    }
+
+    dim_t ChunkIterator::offset() const {
+        return this->offset_;
+    }
+
+    dim_t ChunkIterator::global_offset() const {
+        return this->dataset_.global_offset() + this->offset_;
+    }
+
+    dim_t ChunkIterator::n_blocks() const {
+        return (this->dataset_.n_samples() + this->block_size_ - 1) / this->block_size_;
+    }
+
+    dim_t ChunkIterator::block_size() const {
+        return this->block_size_;
+    }
+
+    bool ChunkIterator::is_prefetching() const {
+        return this->prefetch_;
+    }
+
+    const std::vector<double>& ChunkIterator::stall_times() const {
+        return this->stall_times_;
+    }
+
+    const std::vector<double>& ChunkIterator::read_times() const {
+        return this->read_times_;
+    }
+} // namespace juml
@@ -0,0 +1,40 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: ChunkLayout.cpp
+*
+* Description: Implementation of structs ChunkLayout and WriteStatistics
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include "data/ChunkLayout.h"
+
+namespace juml {
+    ChunkLayout::ChunkLayout(bool chunked, hsize_t chunk_samples, int deflate, bool shuffle, hsize_t max_chunk_bytes)
+      : chunked(chunked),
+        chunk_samples(chunk_samples),
+        deflate(deflate),
+        shuffle(shuffle),
+        max_chunk_bytes(max_chunk_bytes)
+    {}
+
+    bool ChunkLayout::is_chunked() const {
+        return this->chunked || this->chunk_samples > 0 || this->deflate > 0 || this->shuffle;
+    }
+
+    double WriteStatistics::compression_ratio() const {
+        if (this->stored_bytes == 0) return 1.0;
+        return static_cast<double>(this->raw_bytes) / static_cast<double>(this->stored_bytes);
+    }
+
+    double WriteStatistics::bandwidth() const {
+        if (this->seconds <= 0.0) return 0.0;
+        return static_cast<double>(this->raw_bytes) / this->seconds;
+    }
+}  // juml
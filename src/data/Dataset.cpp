@@ -14,13 +14,134 @@
 */
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
 #include <stdexcept>
 #include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
 #include <core/MPI.h>
 
+#include "data/ChunkIterator.h"
 #include "data/Dataset.h"
 
 namespace juml {
+    /**
+     * RegistryEntry
+     *
+     * A node's loaded partition of an HDF5 dataset as recorded in the process-wide load registry.
+     */
+    struct RegistryEntry {
+        time_t modified_time;
+        af::array data;
+        dim_t global_n_samples;
+        dim_t global_offset;
+        dim_t sample_dim;
+        af::dim4 local_dims;
+    };
+
+    static std::mutex registry_mutex;
+    static std::map<std::string, RegistryEntry> registry;
+
+    /**
+     * sweep_registry
+     *
+     * Drops the partitions no dataset refers to anymore, so that the registry never keeps data alive on its own.
+     * Requires registry_mutex to be held.
+     */
+    static void sweep_registry() {
+        for (auto entry = registry.begin(); entry != registry.end();) {
+            int references = 0;
+            af_get_data_ref_count(&references, entry->second.data.get());
+            if (references > 1) {
+                ++entry;
+            } else {
+                entry = registry.erase(entry);
+            }
+        }
+    }
+
+    /**
+     * CacheHeader
+     *
+     * The header of a node-local partition cache file. It is followed by the partition key and, aligned to
+     * CACHE_ALIGNMENT bytes, the raw partition data in arrayfire (column-major) order.
+     */
+    struct CacheHeader {
+        char magic[8];
+        long long modified_time;
+        long long modified_nanoseconds;
+        long long file_size;
+        long long global_n_samples;
+        long long global_offset;
+        long long sample_dim;
+        long long dims[4];
+        long long type;
+        long long key_length;
+        long long data_offset;
+        long long data_bytes;
+    };
+
+    static const char CACHE_MAGIC[8] = "JUMLPC2";
+    static const long long CACHE_ALIGNMENT = 64;
+
+    /**
+     * MappedRange
+     *
+     * A memory mapped file range and the array wrapping it. The array holds a reference to the mapped buffer, so
+     * that arrayfire copies it before any in-place write to the read-only pages.
+     */
+    struct MappedRange {
+        af::array array;
+        void* address;
+        size_t length;
+    };
+
+    static std::mutex mapping_mutex;
+    static std::vector<MappedRange*> retired_mappings;
+
+    /**
+     * sweep_mappings
+     *
+     * Unmaps the retired ranges whose buffer is no longer shared with any array but their own. Requires
+     * mapping_mutex to be held.
+     */
+    static void sweep_mappings() {
+        for (auto range = retired_mappings.begin(); range != retired_mappings.end();) {
+            int references = 0;
+            af_get_data_ref_count(&references, (*range)->array.get());
+            if (references > 1) {
+                ++range;
+                continue;
+            }
+            (*range)->array = af::array();
+            munmap((*range)->address, (*range)->length);
+            delete *range;
+            range = retired_mappings.erase(range);
+        }
+    }
+
+    /**
+     * retire_mapping
+     *
+     * Releases a mapped range once its dataset and all its views are gone. Arrays copied from data() may still
+     * share the buffer, the range is then unmapped by a later sweep after the last of them has been destroyed.
+     */
+    static void retire_mapping(MappedRange* range) {
+        std::lock_guard<std::mutex> lock(mapping_mutex);
+        retired_mappings.push_back(range);
+        sweep_mappings();
+    }
+
     //! Dataset constructor
     Dataset::Dataset(const std::string& filename, const std::string& dataset, const MPI_Comm comm)
         : filename_(filename), dataset_(dataset), comm_(comm) {
@@ -28,23 +149,58 @@ namespace juml {
         MPI_Comm_size(this->comm_, &this->mpi_size_);
     }
 
-    Dataset::Dataset(const af::array& data, MPI_Comm comm)
+    Dataset::Dataset(const af::array& data, MPI_Comm comm, dim_t sample_dim)
         : data_(data), comm_(comm) {
         MPI_Comm_rank(this->comm_, &this->mpi_rank_);
         MPI_Comm_size(this->comm_, &this->mpi_size_);
 
-        this->sample_dim_ = data.numdims() > 2 ? data.numdims() - 1 : 1;
-        MPI_Allreduce(MPI_IN_PLACE, &this->sample_dim_, 1, MPI_LONG_LONG, MPI_MAX, comm);
+        // the global metadata is exchanged on demand, a guessed sample dimension is only a local proposal
+        this->sample_dim_pending_ = sample_dim < 0;
+        this->sample_dim_ = sample_dim >= 0 ? sample_dim : (data.numdims() > 2 ? data.numdims() - 1 : 1);
+        this->global_n_samples_ = 0;
+        this->global_offset_ = 0;
+        this->metadata_pending_ = true;
+    }
+
+    void Dataset::resolve_metadata() const {
+        if (!this->metadata_pending_) {
+            return;
+        }
+        this->metadata_pending_ = false;
+        this->sample_dim_pending_ = false;
 
-        this->global_n_samples_ = data.dims(static_cast<unsigned int>(this->sample_dim_));
-        this->global_offset_ = this->global_n_samples_;
+        // a single exchange of the local shapes replaces the sample dimension agreement, the sum and the prefix sum
+        const af::dim4 dims = this->data_.dims();
+        long long shape[5] = {this->sample_dim_, dims[0], dims[1], dims[2], dims[3]};
+        if (this->data_.isempty()) {
+            shape[1] = 0;
+        }
+        // views of feature partitioned data only count the nodes holding the same features
+        const MPI_Comm comm = this->sample_comm();
+        int comm_rank, comm_size;
+        MPI_Comm_rank(comm, &comm_rank);
+        MPI_Comm_size(comm, &comm_size);
+        std::vector<long long> shapes(5 * static_cast<size_t>(comm_size));
+        MPI_Allgather(shape, 5, MPI_LONG_LONG, shapes.data(), 5, MPI_LONG_LONG, comm);
 
-        MPI_Allreduce(MPI_IN_PLACE, &this->global_n_samples_, 1, MPI_LONG_LONG, MPI_SUM, comm);
-        MPI_Exscan(MPI_IN_PLACE, &this->global_offset_, 1, MPI_LONG_LONG, MPI_SUM, comm);
-        if (this->mpi_rank_ == 0) this->global_offset_ = 0;
+        dim_t sample_dim = 0;
+        for (int rank = 0; rank < comm_size; ++rank) {
+            sample_dim = std::max(sample_dim, static_cast<dim_t>(shapes[5 * rank]));
+        }
+        this->sample_dim_ = sample_dim;
+        this->global_n_samples_ = 0;
+        this->global_offset_ = 0;
+        for (int rank = 0; rank < comm_size; ++rank) {
+            const long long* local = &shapes[5 * rank + 1];
+            const dim_t count = local[0] == 0 ? 0 : static_cast<dim_t>(local[sample_dim]);
+            if (rank < comm_rank) {
+                this->global_offset_ += count;
+            }
+            this->global_n_samples_ += count;
+        }
     }
     
-    af::dtype Dataset::h5_to_af(hid_t h5_type) {
+    af::dtype Dataset::h5_to_af(hid_t h5_type) const {
              if (H5Tequal(h5_type, H5T_NATIVE_CHAR))    return u8;
         else if (H5Tequal(h5_type, H5T_NATIVE_UCHAR))   return u8;
         else if (H5Tequal(h5_type, H5T_NATIVE_B8))      return b8;
@@ -62,8 +218,8 @@ namespace juml {
         throw std::domain_error("Unsupported HDF5 type");
     }
 
-    hid_t Dataset::af_to_h5(af::dtype af_type) {
-            if  (af_type == u8)     return H5T_NATIVE_CHAR;
+    hid_t Dataset::af_to_h5(af::dtype af_type) const {
+            if  (af_type == u8)     return H5T_NATIVE_UCHAR;
         else if (af_type == b8)     return H5T_NATIVE_B8;
         else if (af_type == s16)    return H5T_NATIVE_SHORT;
         else if (af_type == u16)    return H5T_NATIVE_USHORT;
@@ -76,39 +232,768 @@ namespace juml {
         throw std::domain_error("Unsupported af type");
     }
 
-    void Dataset::load_equal_chunks(bool force) {
-        if (this->filename_.empty()) {
-            return ;
-        }
-        time_t mod_time = this->modified_time();
-        if (!force && mod_time <= this->loading_time_) {
-            return ;
-        }
-        else {
-            this->loading_time_ = mod_time;
-        }
+    hid_t Dataset::open_file() const {
         // create access list for parallel IO
-        hid_t access_plist = H5Pcreate(H5P_FILE_ACCESS);
-        if (access_plist < 0)
-            throw std::runtime_error("Could not create file access property list");
-        H5Pset_fapl_mpio(access_plist, this->comm_, MPI_INFO_NULL);
+        hid_t access_plist = this->io_profile_.file_access_list(this->comm_);
 
-        // create file handle 
+        // create file handle
         const hid_t file_id = H5Fopen(this->filename_.c_str(), H5F_ACC_RDWR, access_plist);
+        H5Pclose(access_plist);
         if (file_id < 0) {
             std::stringstream error;
             error << "Could not open file " << this->filename_;
             throw std::runtime_error(error.str().c_str());
         }
+        return file_id;
+    }
 
-        // create dataset handle
+    hid_t Dataset::open_dataset(hid_t file_id) const {
         const hid_t data_id = H5Dopen(file_id, this->dataset_.c_str(), H5P_DEFAULT);
         if (data_id < 0) {
             std::stringstream error;
             error << "Could not open dataset " << this->dataset_ << " in file " << this->filename_;
             throw std::runtime_error(error.str().c_str());
         }
-        
+        return data_id;
+    }
+
+    af::dtype Dataset::sample_type(hid_t data_id) const {
+        if (this->convert_) return this->target_type_;
+
+        hid_t data_type = H5Dget_type(data_id);
+        hid_t native_type = H5Tget_native_type(data_type, H5T_DIR_ASCEND);
+        H5Tclose(data_type);
+        try {
+            af::dtype array_type = h5_to_af(native_type);
+            H5Tclose(native_type);
+            return array_type;
+        } catch(const std::domain_error& e) {
+            H5Tclose(native_type);
+            throw e;
+        }
+    }
+
+    hid_t Dataset::memory_type(hid_t data_id) const {
+        if (this->convert_) return H5Tcopy(this->af_to_h5(this->target_type_));
+
+        hid_t data_type = H5Dget_type(data_id);
+        hid_t native_type = H5Tget_native_type(data_type, H5T_DIR_ASCEND);
+        H5Tclose(data_type);
+        return native_type;
+    }
+
+    af::dim4 Dataset::sample_dims(hid_t data_id, hsize_t count) const {
+        // create file space
+        const hid_t file_space_id = H5Dget_space(data_id);
+        if (file_space_id < 0) {
+            std::stringstream error;
+            error << "Could not get file space of file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // check dimesionality of the dataset
+        const int n_dims = H5Sget_simple_extent_ndims(file_space_id);
+        if (n_dims < 1 || n_dims > 4) {
+            H5Sclose(file_space_id);
+            std::stringstream error;
+            error << "Got " << n_dims << "dimensions in dataset " << this->dataset_ << " in file " << this->filename_ << ". Expected 1 to 4.";
+            throw std::domain_error(error.str().c_str());
+        }
+        hsize_t dimensions[n_dims];
+        H5Sget_simple_extent_dims(file_space_id, dimensions, NULL);
+        H5Sclose(file_space_id);
+        dimensions[0] = count;
+
+        // a feature projection selects columns of two-dimensional datasets
+        if (!this->features_.empty() || this->feature_parts_ > 1) {
+            if (n_dims != 2) {
+                std::stringstream error;
+                error << "Feature projection requires a two-dimensional dataset, " << this->dataset_ << " has "
+                      << n_dims;
+                throw std::domain_error(error.str().c_str());
+            }
+            if (!this->features_.empty() && this->features_.back() >= dimensions[1]) {
+                std::stringstream error;
+                error << "Feature " << this->features_.back() << " exceeds the " << dimensions[1] << " features of "
+                      << this->dataset_;
+                throw std::domain_error(error.str().c_str());
+            }
+            dimensions[1] = this->local_features(dimensions[1]).size();
+        }
+
+        // swap the row and column dimensions (HDF5 row-major, AF column-major)
+        af::dim4 arrayDim4;
+        if (n_dims > 1) {
+            std::reverse(dimensions, dimensions + n_dims);
+            arrayDim4 = af::dim4(n_dims, reinterpret_cast<dim_t*>(dimensions));
+        } else if (n_dims == 1) {
+            arrayDim4 = af::dim4(1, dimensions[0]);
+        }
+        return arrayDim4;
+    }
+
+    herr_t Dataset::read_samples(hid_t data_id, hsize_t offset, hsize_t count, void* buffer, hid_t transfer) const {
+        // create file space
+        const hid_t file_space_id = H5Dget_space(data_id);
+        if (file_space_id < 0) return -1;
+
+        // calculate offsets into the hyperslab, the selected samples are strided rows of the HDF5 dataset
+        const int n_dims = H5Sget_simple_extent_ndims(file_space_id);
+        hsize_t dimensions[n_dims];
+        H5Sget_simple_extent_dims(file_space_id, dimensions, NULL);
+        hsize_t chunk_dimensions[n_dims];
+        hsize_t start[n_dims], stride[n_dims], blocks[n_dims], block[n_dims];
+        chunk_dimensions[0] = count;
+        start[0] = this->sample_begin_ + offset * this->sample_stride_;
+        stride[0] = this->sample_stride_;
+        blocks[0] = count;
+        block[0] = 1;
+        for (int i = 1; i < n_dims; ++i) {
+            chunk_dimensions[i] = dimensions[i];
+            start[i] = 0;
+            stride[i] = 1;
+            blocks[i] = 1;
+            block[i] = dimensions[i];
+        }
+        const std::vector<hsize_t> features = n_dims == 2 ? this->local_features(dimensions[1]) : this->features_;
+        if (!features.empty()) {
+            chunk_dimensions[n_dims - 1] = features.size();
+        }
+
+        // create memory space and select hyperslab, projected features are the union of consecutive column runs
+        hid_t mem_space = H5Screate_simple(n_dims, chunk_dimensions, NULL);
+        herr_t status = 0;
+        if (count == 0) {
+            status = H5Sselect_none(file_space_id);
+        } else if (features.empty()) {
+            status = H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, start, stride, blocks, block);
+        } else {
+            H5S_seloper_t op = H5S_SELECT_SET;
+            for (size_t i = 0; i < features.size() && status >= 0; op = H5S_SELECT_OR) {
+                size_t run = 1;
+                while (i + run < features.size() && features[i + run] == features[i] + run) ++run;
+                start[n_dims - 1] = features[i];
+                block[n_dims - 1] = run;
+                status = H5Sselect_hyperslab(file_space_id, op, start, stride, blocks, block);
+                i += run;
+            }
+        }
+
+        // read the actual data, HDF5 converts it to the memory type if necessary
+        hid_t type = this->memory_type(data_id);
+        if (mem_space >= 0 && status >= 0) {
+            status = H5Dread(data_id, type, mem_space, file_space_id, transfer, buffer);
+        } else {
+            status = -1;
+        }
+
+        // release resources
+        H5Tclose(type);
+        if (mem_space >= 0) H5Sclose(mem_space);
+        H5Sclose(file_space_id);
+        return status;
+    }
+
+    af::array Dataset::read_samples(hid_t data_id, hsize_t offset, hsize_t count, hid_t transfer) const {
+        // initialize the array
+        af::array data(this->sample_dims(data_id, count), this->sample_type(data_id));
+
+        // read the actual data
+        herr_t status;
+        if (af::getBackendId(af::constant(0, 1)) == AF_BACKEND_CPU) {
+            status = this->read_samples(data_id, offset, count, data.device<uint8_t>(), transfer);
+            data.unlock();
+        } else {
+            size_t size = data.bytes();
+            uint8_t* buffer = new uint8_t[size];
+            status = this->read_samples(data_id, offset, count, buffer, transfer);
+            af_write_array(data.get(), buffer, size, afHost);
+            delete[] buffer;
+        }
+
+        if (status < 0) {
+            std::stringstream error;
+            error << "Could not read hyperslab of dataset " << this->dataset_ << " in file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+        return data;
+    }
+
+    Dataset::~Dataset() {
+        // drop the own references to a mapped buffer first, so that it can be unmapped right away
+        this->data_ = af::array();
+        this->mapped_ = af::array();
+        if (this->shared_metadata_) {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            sweep_registry();
+        }
+    }
+
+    bool Dataset::map_samples(hid_t data_id, hsize_t offset, hsize_t count) {
+        if (count == 0 || af::getBackendId(af::constant(0, 1)) != AF_BACKEND_CPU) return false;
+        // only unprojected consecutive samples form a single byte range
+        if (!this->features_.empty() || this->feature_parts_ > 1 || this->sample_stride_ != 1) return false;
+
+        // only contiguous datasets have a single raw data range in the file, they cannot be filtered
+        hid_t create_plist = H5Dget_create_plist(data_id);
+        if (create_plist < 0) return false;
+        const bool contiguous = H5Pget_layout(create_plist) == H5D_CONTIGUOUS;
+        H5Pclose(create_plist);
+        const haddr_t address = H5Dget_offset(data_id);
+        if (!contiguous || address == HADDR_UNDEF) return false;
+
+        // the raw bytes must already be in the native representation
+        hid_t data_type = H5Dget_type(data_id);
+        hid_t native_type = H5Tget_native_type(data_type, H5T_DIR_ASCEND);
+        const bool native = H5Tequal(data_type, native_type) > 0;
+        const size_t type_size = H5Tget_size(native_type);
+        bool converted = false;
+        if (this->convert_) {
+            hid_t target_type = this->af_to_h5(this->target_type_);
+            converted = H5Tequal(native_type, target_type) <= 0;
+        }
+        H5Tclose(native_type);
+        H5Tclose(data_type);
+        if (!native || converted) return false;
+
+        af::dtype type;
+        af::dim4 dims;
+        try {
+            type = this->sample_type(data_id);
+            dims = this->sample_dims(data_id, count);
+        } catch (...) {
+            return false;
+        }
+
+        // map the byte range of the samples
+        const size_t sample_bytes = type_size * static_cast<size_t>(dims.elements() / count);
+        const off_t begin = static_cast<off_t>(address + (this->sample_begin_ + offset) * sample_bytes);
+        return this->map_file(this->filename_, begin, dims, type, count * sample_bytes);
+    }
+
+    bool Dataset::map_file(const std::string& path, off_t begin, const af::dim4& dims, af::dtype type, size_t bytes) {
+        if (bytes == 0 || af::getBackendId(af::constant(0, 1)) != AF_BACKEND_CPU) return false;
+
+        // mmap requires a page aligned file offset
+        const off_t page_size = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+        const off_t aligned_begin = begin - begin % page_size;
+        const size_t length = static_cast<size_t>(begin - aligned_begin) + bytes;
+
+        {
+            std::lock_guard<std::mutex> lock(mapping_mutex);
+            sweep_mappings();
+        }
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        void* mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, aligned_begin);
+        close(fd);
+        if (mapping == MAP_FAILED) return false;
+
+        // wrap the mapped samples, the user lock prevents arrayfire from ever releasing the memory itself
+        af_array handle;
+        if (af_device_array(&handle, static_cast<uint8_t*>(mapping) + (begin - aligned_begin), dims.ndims(),
+                            dims.get(), type) != AF_SUCCESS) {
+            munmap(mapping, length);
+            return false;
+        }
+        af::array mapped(handle);
+        mapped.lock();
+
+        // the range outlives the dataset as long as arrays copied from data() still share its buffer
+        MappedRange* range = new MappedRange{mapped, mapping, length};
+        this->mapping_ = std::shared_ptr<void>(range, [](void* address) {
+            retire_mapping(static_cast<MappedRange*>(address));
+        });
+        this->mapped_ = mapped;
+        this->data_ = this->mapped_;
+        return true;
+    }
+
+    /**
+     * equal_portion
+     *
+     * Splits n items into equal consecutive portions, the first n % parts portions hold one additional item.
+     *
+     * @param n      - The number of items
+     * @param parts  - The number of portions
+     * @param index  - The index of the portion
+     * @param offset - Output, the index of the first item of the portion
+     * @param count  - Output, the number of items of the portion
+     */
+    static void equal_portion(hsize_t n, hsize_t parts, hsize_t index, hsize_t& offset, hsize_t& count) {
+        hsize_t overlap = n % parts;
+        offset = 0;
+        count = n / parts;
+
+        if (overlap > index)
+            count += 1;
+        else
+            offset = overlap;
+        offset += index * count;
+    }
+
+    void Dataset::partition(hsize_t n_samples, const std::vector<double>& weights, hsize_t& offset,
+                            hsize_t& count) const {
+        // equal portions per sample range of the node grid, the nodes of a grid row share their samples
+        if (weights.empty()) {
+            equal_portion(n_samples, static_cast<hsize_t>(this->sample_parts()),
+                          static_cast<hsize_t>(this->mpi_rank_ / this->feature_parts_), offset, count);
+            return;
+        }
+
+        // portions proportional to the weights, bounds are derived from the weight prefix sums on every node
+        long double total = 0.0;
+        long double before = 0.0;
+        for (int rank = 0; rank < this->mpi_size_; ++rank) {
+            if (rank < this->mpi_rank_) before += weights[rank];
+            total += weights[rank];
+        }
+        const long double including = before + weights[this->mpi_rank_];
+        const hsize_t begin = static_cast<hsize_t>(n_samples * before / total);
+        const hsize_t end = this->mpi_rank_ == this->mpi_size_ - 1 ? n_samples
+                                                                    : static_cast<hsize_t>(n_samples * including / total);
+        offset = begin;
+        count = end - begin;
+    }
+
+    void Dataset::check_weights(const std::vector<double>& weights) const {
+        if (weights.size() != static_cast<size_t>(this->mpi_size_)) {
+            std::stringstream error;
+            error << "Got " << weights.size() << " weights for " << this->mpi_size_ << " nodes";
+            throw std::invalid_argument(error.str().c_str());
+        }
+        double total = 0.0;
+        for (double weight : weights) {
+            if (!(weight >= 0.0)) {
+                throw std::invalid_argument("The partition weights must not be negative");
+            }
+            total += weight;
+        }
+        if (total <= 0.0) {
+            throw std::invalid_argument("At least one partition weight must be positive");
+        }
+    }
+
+    void Dataset::check_sample_partitioning(const std::string& operation) const {
+        if (this->feature_parts_ > 1) {
+            std::stringstream error;
+            error << operation << " requires the sample partitioning, the features are split into "
+                  << this->feature_parts_ << " ranges";
+            throw std::domain_error(error.str().c_str());
+        }
+    }
+
+    std::vector<hsize_t> Dataset::local_features(hsize_t n_columns) const {
+        if (this->feature_parts_ == 1) {
+            return this->features_;
+        }
+
+        // the node's range of the projected or all columns
+        const hsize_t n_features = this->features_.empty() ? n_columns : this->features_.size();
+        if (n_features < static_cast<hsize_t>(this->feature_parts_)) {
+            std::stringstream error;
+            error << "Cannot split " << n_features << " features into " << this->feature_parts_ << " ranges";
+            throw std::domain_error(error.str().c_str());
+        }
+        hsize_t offset, count;
+        equal_portion(n_features, static_cast<hsize_t>(this->feature_parts_),
+                      static_cast<hsize_t>(this->mpi_rank_ % this->feature_parts_), offset, count);
+        std::vector<hsize_t> features(count);
+        for (hsize_t i = 0; i < count; ++i) {
+            features[i] = this->features_.empty() ? offset + i : this->features_[offset + i];
+        }
+        return features;
+    }
+
+    void Dataset::load_equal_chunks(bool force) {
+        this->load_chunks(std::vector<double>(), force);
+    }
+
+    void Dataset::load_weighted_chunks(const std::vector<double>& weights, bool force) {
+        if (this->filename_.empty()) {
+            return ;
+        }
+        if (weights.empty()) {
+            // calibrate only if the data actually has to be (re)loaded, measured weights never compare equal
+            if (!force && !this->weights_.empty() && this->modified_time() <= this->loading_time_) {
+                return ;
+            }
+            this->load_chunks(this->calibrate_weights(), force);
+        } else {
+            this->check_weights(weights);
+            this->load_chunks(weights, force);
+        }
+    }
+
+    void Dataset::load_incremental(bool rebalance) {
+        if (this->filename_.empty()) {
+            return ;
+        }
+        if (this->loading_time_ == 0 || this->is_streamed()) {
+            this->load_equal_chunks();
+            return ;
+        }
+        // appended rows would be read by the last node alone, the grid is loaded anew instead
+        if (this->feature_parts_ > 1) {
+            this->load_chunks(std::vector<double>(), true);
+            return ;
+        }
+
+        // the extent is the authoritative change indicator, modification times only have a resolution of seconds
+        const time_t mod_time = this->modified_time();
+        const hid_t file_id = this->open_file();
+        hid_t data_id;
+        try {
+            data_id = this->open_dataset(file_id);
+        } catch (const std::runtime_error& e) {
+            H5Fclose(file_id);
+            throw e;
+        }
+
+        hsize_t n_samples;
+        const hsize_t previous = static_cast<hsize_t>(this->global_n_samples_);
+        af::array appended;
+        try {
+            n_samples = this->sample_extent(data_id);
+            // only the last node reads the appended rows
+            if (n_samples > previous && this->mpi_rank_ == this->mpi_size_ - 1) {
+                appended = this->read_samples(data_id, previous, n_samples - previous);
+            }
+        } catch (...) {
+            H5Dclose(data_id);
+            H5Fclose(file_id);
+            throw;
+        }
+        H5Dclose(data_id);
+        H5Fclose(file_id);
+
+        if (n_samples < previous) {
+            this->load_chunks(this->weights_, true);
+            return ;
+        }
+        this->loading_time_ = mod_time;
+        if (n_samples == previous) {
+            return ;
+        }
+
+        // extend the local portion, a memory mapping is released as the data is copied anyway
+        if (!appended.isempty()) {
+            appended = this->compact(appended);
+            this->data_ = this->data_.isempty() ? appended : af::join(this->sample_dim_, this->data_, appended);
+            this->mapped_ = af::array();
+            this->mapping_.reset();
+            this->local_dims_[this->sample_dim_] += appended.dims(this->sample_dim_);
+        }
+        this->global_n_samples_ = static_cast<dim_t>(n_samples);
+
+        if (rebalance) {
+            this->redistribute();
+            this->weights_.clear();
+        }
+    }
+
+    std::vector<double> Dataset::calibrate_weights(dim_t size, int repetitions) const {
+        // warm up, e.g. JIT compilation of the kernels, before the timed runs
+        af::array a = af::randu(size, size);
+        af::array b = af::matmul(a, a);
+        b.eval();
+        af::sync();
+
+        double start = MPI_Wtime();
+        for (int i = 0; i < repetitions; ++i) {
+            b = af::matmul(a, b);
+            b.eval();
+        }
+        af::sync();
+        double elapsed = std::max(MPI_Wtime() - start, 1e-9);
+
+        // the throughput of each node is the inverse of its kernel time
+        std::vector<double> weights(this->mpi_size_);
+        double throughput = repetitions / elapsed;
+        MPI_Allgather(&throughput, 1, MPI_DOUBLE, weights.data(), 1, MPI_DOUBLE, this->comm_);
+        return weights;
+    }
+
+    const std::vector<double>& Dataset::weights() const {
+        return this->weights_;
+    }
+
+    void Dataset::load_chunks(const std::vector<double>& weights, bool force) {
+        if (this->filename_.empty()) {
+            return ;
+        }
+        if (!weights.empty()) {
+            this->check_sample_partitioning("Weighted loading");
+        }
+        const FileVersion version = this->file_version();
+        const time_t mod_time = version.modified_time;
+        if (!force && mod_time <= this->loading_time_ && weights == this->weights_) {
+            return ;
+        }
+        else {
+            this->loading_time_ = mod_time;
+        }
+        this->scale_ = af::array();
+        this->offset_ = af::array();
+
+        if (!this->lookup_partition(weights, version, force)) {
+            this->read_partition(weights);
+            this->store_partition(weights, version);
+        }
+    }
+
+    bool Dataset::is_registered() const {
+        return this->shared_metadata_ && !this->is_streamed() && !this->memory_map_ && this->feature_parts_ <= 1;
+    }
+
+    bool Dataset::is_cached() const {
+        return !this->cache_directory_.empty() && !this->is_streamed() && this->feature_parts_ <= 1;
+    }
+
+    bool Dataset::lookup_partition(const std::vector<double>& weights, const FileVersion& version, bool force) {
+        const time_t mod_time = version.modified_time;
+        // look up the partition in the load registry, it is only used if all nodes hold it, as reading is collective
+        if (this->is_registered() && !force) {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            sweep_registry();
+            auto entry = registry.find(this->registry_key(weights));
+            int found = entry != registry.end() && mod_time <= entry->second.modified_time ? 1 : 0;
+            MPI_Allreduce(MPI_IN_PLACE, &found, 1, MPI_INT, MPI_MIN, this->comm_);
+            if (found) {
+                this->mapped_ = af::array();
+                this->mapping_.reset();
+                this->data_ = entry->second.data;
+                this->global_n_samples_ = entry->second.global_n_samples;
+                this->global_offset_ = entry->second.global_offset;
+                this->sample_dim_ = entry->second.sample_dim;
+                this->local_dims_ = entry->second.local_dims;
+                this->weights_ = weights;
+                return true;
+            }
+        }
+
+        // the node-local cache is only used if it is valid on all nodes, as reading the HDF5 file is collective
+        if (!this->is_cached()) {
+            return false;
+        }
+        int hit = !force && this->read_cache(this->partition_key(weights), version) ? 1 : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &hit, 1, MPI_INT, MPI_MIN, this->comm_);
+        if (!hit) {
+            return false;
+        }
+        this->weights_ = weights;
+        this->register_partition(weights, mod_time);
+        return true;
+    }
+
+    void Dataset::store_partition(const std::vector<double>& weights, const FileVersion& version) {
+        if (this->is_cached()) {
+            this->write_cache(this->partition_key(weights), version);
+        }
+        this->register_partition(weights, version.modified_time);
+    }
+
+    void Dataset::register_partition(const std::vector<double>& weights, time_t mod_time) {
+        if (!this->is_registered()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        sweep_registry();
+        registry[this->registry_key(weights)] = RegistryEntry{mod_time, this->data_, this->global_n_samples_,
+                                                              this->global_offset_, this->sample_dim_,
+                                                              this->local_dims_};
+    }
+
+    void Dataset::read_partition(const std::vector<double>& weights) {
+        const hid_t file_id = this->open_file();
+        hid_t data_id;
+        try {
+            data_id = this->open_dataset(file_id);
+        } catch (const std::runtime_error& e) {
+            H5Fclose(file_id);
+            throw e;
+        }
+
+        try {
+            // calculate offsets into the hyperslab
+            const hsize_t n_samples = this->sample_extent(data_id);
+            hsize_t position;
+            hsize_t chunk_size;
+            this->partition(n_samples, weights, position, chunk_size);
+            this->weights_ = weights;
+            this->load_partition(data_id, n_samples, position, chunk_size);
+        } catch (...) {
+            H5Dclose(data_id);
+            H5Fclose(file_id);
+            throw;
+        }
+
+        // release resources
+        H5Dclose(data_id);
+        H5Fclose(file_id);
+    }
+
+    std::string Dataset::partition_key(const std::vector<double>& weights) const {
+        std::stringstream key;
+        key << this->filename_ << '\n' << this->dataset_ << '\n' << this->mpi_size_ << ' ' << this->mpi_rank_ << " w";
+        for (double weight : weights) {
+            key << ' ' << weight;
+        }
+        key << " f";
+        for (hsize_t feature : this->features_) {
+            key << ' ' << feature;
+        }
+        key << " s " << this->sample_begin_ << ' ' << this->sample_end_ << ' ' << this->sample_stride_
+            << " t " << this->convert_ << ' ' << this->target_type_ << " h " << this->half_precision_;
+        return key.str();
+    }
+
+    std::string Dataset::registry_key(const std::vector<double>& weights) const {
+        std::stringstream key;
+        key << this->partition_key(weights) << " b " << af::getActiveBackend() << ' ' << af::getDevice();
+        return key.str();
+    }
+
+    std::string Dataset::cache_path(const std::string& key) const {
+        std::stringstream path;
+        path << this->cache_directory_ << "/juml-" << std::hex << std::hash<std::string>()(key) << ".part";
+        return path.str();
+    }
+
+    bool Dataset::read_cache(const std::string& key, const FileVersion& version) {
+        const std::string path = this->cache_path(key);
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file) return false;
+
+        // the header must match the requested partition and the current version of the HDF5 file
+        CacheHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || std::memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0
+            || header.modified_time != static_cast<long long>(version.modified_time)
+            || header.modified_nanoseconds != version.modified_nanoseconds || header.file_size != version.size
+            || header.key_length != static_cast<long long>(key.size())) {
+            return false;
+        }
+        std::string stored_key(key.size(), '\0');
+        file.read(&stored_key[0], static_cast<std::streamsize>(stored_key.size()));
+        if (!file || stored_key != key) return false;
+
+        // the shape and type are validated before they are trusted
+        if (header.sample_dim < 0 || header.sample_dim > 3 || header.type < static_cast<long long>(f32)
+            || header.type > static_cast<long long>(f16) || header.data_bytes < 0
+            || header.data_offset < static_cast<long long>(sizeof(header) + key.size())) {
+            return false;
+        }
+        long long elements = 1;
+        for (unsigned int i = 0; i < 4; ++i) {
+            if (header.dims[i] < 0 || (header.data_bytes > 0 && header.dims[i] > header.data_bytes)) return false;
+            elements *= header.dims[i];
+        }
+        if (header.data_bytes > 0 && (elements == 0 || elements > header.data_bytes
+                                      || header.data_bytes % elements != 0 || header.data_bytes / elements > 16)) {
+            return false;
+        }
+
+        const af::dim4 dims(header.dims[0], header.dims[1], header.dims[2], header.dims[3]);
+        const af::dtype type = static_cast<af::dtype>(header.type);
+        af::array data;
+        if (header.data_bytes > 0) {
+            data = af::array(dims, type);
+            if (static_cast<long long>(data.bytes()) != header.data_bytes) return false;
+        }
+
+        // release a previous mapping before the data is replaced
+        this->data_ = af::array();
+        this->mapped_ = af::array();
+        this->mapping_.reset();
+
+        if (header.data_bytes > 0) {
+            const size_t bytes = static_cast<size_t>(header.data_bytes);
+            const off_t begin = static_cast<off_t>(header.data_offset);
+            if (!this->memory_map_ || !this->map_file(path, begin, dims, type, bytes)) {
+                std::vector<char> buffer(bytes);
+                file.seekg(header.data_offset);
+                file.read(buffer.data(), static_cast<std::streamsize>(bytes));
+                if (!file) return false;
+                data.write(buffer.data(), bytes, afHost);
+                this->data_ = data;
+            }
+        }
+        this->global_n_samples_ = header.global_n_samples;
+        this->global_offset_ = header.global_offset;
+        this->sample_dim_ = header.sample_dim;
+        this->local_dims_ = dims;
+        return true;
+    }
+
+    void Dataset::write_cache(const std::string& key, const FileVersion& version) const {
+        CacheHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+        header.modified_time = static_cast<long long>(version.modified_time);
+        header.modified_nanoseconds = version.modified_nanoseconds;
+        header.file_size = version.size;
+        header.global_n_samples = this->global_n_samples_;
+        header.global_offset = this->global_offset_;
+        header.sample_dim = this->sample_dim_;
+        for (unsigned int i = 0; i < 4; ++i) {
+            header.dims[i] = this->local_dims_[i];
+        }
+        header.type = static_cast<long long>(this->data_.isempty() ? f32 : this->data_.type());
+        header.key_length = static_cast<long long>(key.size());
+        header.data_offset = (static_cast<long long>(sizeof(header) + key.size()) + CACHE_ALIGNMENT - 1)
+                             / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+        header.data_bytes = this->data_.isempty() ? 0 : static_cast<long long>(this->data_.bytes());
+
+        std::vector<char> buffer(static_cast<size_t>(header.data_offset + header.data_bytes), '\0');
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        std::memcpy(buffer.data() + sizeof(header), key.data(), key.size());
+        if (header.data_bytes > 0) {
+            this->data_.host(buffer.data() + header.data_offset);
+        }
+
+        // write to a unique temporary file and rename it atomically, failures merely leave the cache cold
+        const std::string path = this->cache_path(key);
+        std::stringstream temporary;
+        temporary << path << ".tmp." << getpid() << '.' << this->mpi_rank_;
+        bool written;
+        {
+            std::ofstream file(temporary.str().c_str(), std::ios::binary | std::ios::trunc);
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            file.close();
+            written = !file.fail();
+        }
+        if (!written || std::rename(temporary.str().c_str(), path.c_str()) != 0) {
+            std::remove(temporary.str().c_str());
+        }
+    }
+
+    void Dataset::set_cache_directory(const std::string& directory) {
+        this->cache_directory_ = directory;
+    }
+
+    const std::string& Dataset::cache_directory() const {
+        return this->cache_directory_;
+    }
+
+    void Dataset::set_shared_metadata(bool shared) {
+        this->shared_metadata_ = shared;
+    }
+
+    bool Dataset::shared_metadata() const {
+        return this->shared_metadata_;
+    }
+
+    void Dataset::clear_registry() {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.clear();
+    }
+
+    af::array Dataset::widen(const af::array& data) {
+        return data.type() == f16 ? data.as(f32) : data;
+    }
+
+    hsize_t Dataset::sample_extent(hid_t data_id) {
         // create file space
         const hid_t file_space_id = H5Dget_space(data_id);
         if (file_space_id < 0) {
@@ -116,112 +1001,297 @@ namespace juml {
             error << "Could not get file space of file " << this->filename_;
             throw std::runtime_error(error.str().c_str());
         }
-        
+
         // check dimesionality of the dataset
         const int n_dims = H5Sget_simple_extent_ndims(file_space_id);
         if (n_dims < 1 || n_dims > 4) {
+            H5Sclose(file_space_id);
             std::stringstream error;
             error << "Got " << n_dims << "dimensions in dataset " << this->dataset_ << " in file " << this->filename_ << ". Expected 1 to 4.";
             throw std::domain_error(error.str().c_str());
         }
         this->sample_dim_ = n_dims > 2 ? n_dims -  1 : 1;
 
-        // calculate offsets into the hyperslab
         hsize_t dimensions[n_dims];
         H5Sget_simple_extent_dims(file_space_id, dimensions, NULL);
-        hsize_t overlap = dimensions[0] % this->mpi_size_;
-        hsize_t offset = 0;
-        hsize_t chunk_size = (dimensions[0] / this->mpi_size_);
+        H5Sclose(file_space_id);
+        return this->selected_samples(dimensions[0]);
+    }
+
+    void Dataset::load_partition(hid_t data_id, hsize_t n_samples, hsize_t position, hsize_t chunk_size) {
+        // remember global index and the local partition shape (AF column-major order) of the selected samples
+        this->global_n_samples_ = static_cast<dim_t>(n_samples);
+        this->global_offset_ = static_cast<dim_t>(position);
+        this->local_dims_ = this->sample_dims(data_id, chunk_size);
+        if (this->feature_parts_ > 1) {
+            // sample_dims has ensured a two-dimensional dataset, the grid splits its projected or all columns
+            const hid_t file_space_id = H5Dget_space(data_id);
+            hsize_t dimensions[2] = {0, 0};
+            H5Sget_simple_extent_dims(file_space_id, dimensions, NULL);
+            H5Sclose(file_space_id);
+            const hsize_t n_features = this->features_.empty() ? dimensions[1] : this->features_.size();
+            hsize_t feature_offset, feature_count;
+            equal_portion(n_features, static_cast<hsize_t>(this->feature_parts_),
+                          static_cast<hsize_t>(this->mpi_rank_ % this->feature_parts_), feature_offset, feature_count);
+            this->global_n_features_ = static_cast<dim_t>(n_features);
+            this->feature_offset_ = static_cast<dim_t>(feature_offset);
+        }
+
+        // release a previous mapping before the data is replaced
+        this->data_ = af::array();
+        this->mapped_ = af::array();
+        this->mapping_.reset();
+
+        // out-of-core mode, the samples are read block-wise by a ChunkIterator
+        if (this->is_streamed()) {
+            return;
+        }
+
+        // zero-copy path, map the samples directly from the file
+        if (this->memory_map_ && !this->half_precision_ && this->map_samples(data_id, position, chunk_size)) {
+            return;
+        }
+
+        // read the actual data, collectively if requested by the I/O profile
+        hid_t transfer_plist = this->io_profile_.transfer_list();
+        try {
+            this->data_ = this->read_samples(data_id, position, chunk_size, transfer_plist);
+        } catch (...) {
+            H5Pclose(transfer_plist);
+            throw;
+        }
+        H5Pclose(transfer_plist);
+
+        // narrow to the storage precision, the read buffer is released right away
+        this->data_ = this->compact(this->data_);
+    }
+
+    af::array Dataset::compact(const af::array& samples) const {
+        if (!this->scale_.isempty()) {
+            const unsigned int n = static_cast<unsigned int>(samples.dims(1));
+            af::array scaled = (samples.as(f32) - af::tile(this->offset_, 1, n)) / af::tile(this->scale_, 1, n);
+            return af::clamp(af::round(scaled), 0.0, 255.0).as(u8);
+        }
+        if (this->half_precision_ && samples.type() != f16) {
+            return samples.as(f16);
+        }
+        return samples;
+    }
+
+    void Dataset::set_block_size(dim_t block_size, bool prefetch) {
+        if (block_size < 0) {
+            throw std::invalid_argument("The block size must not be negative");
+        }
+        this->block_size_ = block_size;
+        this->prefetch_ = prefetch;
+        // force a reload on the next load_equal_chunks as the storage mode changed
+        this->loading_time_ = 0;
+    }
+
+    dim_t Dataset::block_size() const {
+        return this->block_size_;
+    }
+
+    bool Dataset::is_streamed() const {
+        return this->block_size_ > 0 && !this->filename_.empty();
+    }
 
-        if (overlap > this->mpi_rank_)
-            chunk_size += 1;
-        else
-            offset = overlap;
+    bool Dataset::prefetch() const {
+        return this->prefetch_;
+    }
 
-        hsize_t position = offset + this->mpi_rank_ * chunk_size;
-        hsize_t chunk_dimensions[n_dims];
-        chunk_dimensions[0] = chunk_size;
-        hsize_t row_col_offset[n_dims];
-        row_col_offset[0] = position;
-        for (int i = 1; i < n_dims; ++i) {
-            chunk_dimensions[i] = dimensions[i];
-            row_col_offset[i] = 0;
+    hsize_t Dataset::selected_samples(hsize_t n_rows) const {
+        const hsize_t end = this->sample_end_ == 0 ? n_rows : std::min(this->sample_end_, n_rows);
+        if (this->sample_begin_ >= end) return 0;
+        return (end - this->sample_begin_ + this->sample_stride_ - 1) / this->sample_stride_;
+    }
+
+    void Dataset::set_features(const std::vector<hsize_t>& features) {
+        for (size_t i = 1; i < features.size(); ++i) {
+            if (features[i] <= features[i - 1]) {
+                throw std::invalid_argument("The feature indices must be strictly ascending");
+            }
         }
+        this->features_ = features;
+        // force a reload on the next load_equal_chunks as the selection changed
+        this->loading_time_ = 0;
+    }
 
-        // remember global index
-        this->global_n_samples_ = static_cast<dim_t>(dimensions[0]);
-        this->global_offset_ = static_cast<dim_t>(position);
+    const std::vector<hsize_t>& Dataset::features() const {
+        return this->features_;
+    }
 
-        // create memory space
-        hid_t mem_space = H5Screate_simple(n_dims, chunk_dimensions, NULL);
-        if (mem_space < 0)
-            throw std::runtime_error("Could not create memory space");
-        
-        // select hyperslab
-        herr_t err = H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, row_col_offset, NULL, chunk_dimensions, NULL);
-        if (err < 0) {
+    /**
+     * split_comm
+     *
+     * @param comm  - The communicator to split
+     * @param color - The subset of the calling node
+     * @param key   - The rank of the calling node within its subset
+     * @returns The subset communicator of the calling node, freed with its last reference
+     */
+    static std::shared_ptr<MPI_Comm> split_comm(MPI_Comm comm, int color, int key) {
+        MPI_Comm* split = new MPI_Comm;
+        MPI_Comm_split(comm, color, key, split);
+        return std::shared_ptr<MPI_Comm>(split, [](MPI_Comm* subset) {
+            int finalized;
+            MPI_Finalized(&finalized);
+            if (!finalized) MPI_Comm_free(subset);
+            delete subset;
+        });
+    }
+
+    void Dataset::set_partitioning(Partitioning mode, int feature_parts) {
+        if (mode == BLOCKS && (feature_parts < 0 || (feature_parts > 0 && this->mpi_size_ % feature_parts != 0))) {
             std::stringstream error;
-            error << "Could not select hyperslabe in file " << this->filename_;
-            throw std::runtime_error(error.str().c_str());
+            error << "Cannot arrange " << this->mpi_size_ << " nodes in " << feature_parts << " feature ranges";
+            throw std::invalid_argument(error.str().c_str());
         }
 
-        size_t total_size = chunk_size;
-        for (int i = 1; i < n_dims; ++i)
-            total_size *= dimensions[i];
-        
-        // determine the dataset type
-        hid_t native_type = H5Tget_native_type(H5Dget_type(data_id), H5T_DIR_ASCEND);
-        af::dtype array_type;
-        try {
-            array_type = h5_to_af(native_type);
-        } catch(const std::domain_error& e) {
-            H5Tclose(native_type);
-            H5Sclose(mem_space);
-            H5Dclose(data_id);
-            H5Fclose(file_id);
-            H5Pclose(access_plist);
-            throw e;        
+        int parts = 1;
+        if (mode == FEATURES) {
+            parts = this->mpi_size_;
+        } else if (mode == BLOCKS && feature_parts > 0) {
+            parts = feature_parts;
+        } else if (mode == BLOCKS) {
+            // the most square grid, the larger side splitting the features
+            int dims[2] = {0, 0};
+            MPI_Dims_create(this->mpi_size_, 2, dims);
+            parts = dims[0];
         }
-        
-        // initialize the array, swap the row and column dimensions before (HDF5 row-major, AF column-major)
-        af::dim4 arrayDim4;
-        if (n_dims > 1) {
-            //std::swap(chunk_dimensions[0], chunk_dimensions[1]);
-            std::reverse(chunk_dimensions, chunk_dimensions + n_dims);
-            arrayDim4 = af::dim4(n_dims, reinterpret_cast<dim_t*>(chunk_dimensions));
-        } else if (n_dims == 1) {
-            arrayDim4 = af::dim4(1, chunk_dimensions[0]);
+
+        this->partitioning_ = mode;
+        this->feature_parts_ = parts;
+        this->feature_comm_.reset();
+        this->sample_comm_.reset();
+        if (parts > 1) {
+            const int feature_part = this->mpi_rank_ % parts;
+            const int sample_part = this->mpi_rank_ / parts;
+            this->feature_comm_ = split_comm(this->comm_, sample_part, feature_part);
+            this->sample_comm_ = split_comm(this->comm_, feature_part, sample_part);
         }
-        this->data_ = af::array(arrayDim4, array_type);
-        
-        // read the actual data
-        if (af::getBackendId(af::constant(0, 1)) == AF_BACKEND_CPU) {
-            H5Dread(data_id, native_type, mem_space, file_space_id, H5P_DEFAULT, this->data_.device<uint8_t>());
-            this->data_.unlock();
-        } else {
-            size_t size = this->data_.bytes();
-            uint8_t* buffer = new uint8_t[size];
-            H5Dread(data_id, native_type, mem_space, file_space_id, H5P_DEFAULT, buffer);
-            af_write_array(this->data_.get(), buffer, size, afHost); 
-            delete[] buffer;
+        // force a reload on the next load_equal_chunks as the partitioning changed
+        this->loading_time_ = 0;
+    }
+
+    Dataset::Partitioning Dataset::partitioning() const {
+        return this->partitioning_;
+    }
+
+    int Dataset::feature_parts() const {
+        return this->feature_parts_;
+    }
+
+    int Dataset::sample_parts() const {
+        return this->mpi_size_ / this->feature_parts_;
+    }
+
+    MPI_Comm Dataset::comm() const {
+        return this->comm_;
+    }
+
+    MPI_Comm Dataset::feature_comm() const {
+        return this->feature_comm_ ? *this->feature_comm_ : MPI_COMM_SELF;
+    }
+
+    MPI_Comm Dataset::sample_comm() const {
+        return this->sample_comm_ ? *this->sample_comm_ : this->comm_;
+    }
+
+    dim_t Dataset::global_n_features() const {
+        return this->feature_parts_ > 1 ? this->global_n_features_ : this->n_features();
+    }
+
+    dim_t Dataset::feature_offset() const {
+        return this->feature_parts_ > 1 ? this->feature_offset_ : 0;
+    }
+
+    void Dataset::set_sample_range(hsize_t begin, hsize_t end, hsize_t stride) {
+        if (stride == 0) {
+            throw std::invalid_argument("The sample stride must be positive");
         }
+        if (end != 0 && end < begin) {
+            throw std::invalid_argument("The end of the sample range must not precede its begin");
+        }
+        this->sample_begin_ = begin;
+        this->sample_end_ = end;
+        this->sample_stride_ = stride;
+        // force a reload on the next load_equal_chunks as the selection changed
+        this->loading_time_ = 0;
+    }
 
-        // release resources
-        H5Tclose(native_type);
-        H5Sclose(mem_space);
-        H5Dclose(data_id);
-        H5Fclose(file_id);
-        H5Pclose(access_plist);
+    void Dataset::set_target_type(af::dtype type) {
+        this->af_to_h5(type);
+        this->convert_ = true;
+        this->target_type_ = type;
+        // force a reload on the next load_equal_chunks as the storage type changed
+        this->loading_time_ = 0;
+    }
+
+    void Dataset::clear_target_type() {
+        this->convert_ = false;
+        this->loading_time_ = 0;
+    }
+
+    bool Dataset::has_target_type() const {
+        return this->convert_;
+    }
+
+    af::dtype Dataset::target_type() const {
+        return this->target_type_;
+    }
+
+    void Dataset::set_memory_map(bool memory_map) {
+        this->memory_map_ = memory_map;
+        // force a reload on the next load_equal_chunks as the storage mode changed
+        this->loading_time_ = 0;
+    }
+
+    bool Dataset::memory_map() const {
+        return this->memory_map_;
+    }
+
+    void Dataset::set_half_precision(bool half_precision) {
+        this->half_precision_ = half_precision;
+        // force a reload on the next load_equal_chunks as the storage mode changed
+        this->loading_time_ = 0;
+    }
+
+    bool Dataset::half_precision() const {
+        return this->half_precision_;
+    }
+
+    bool Dataset::is_memory_mapped() const {
+        return static_cast<bool>(this->mapping_);
+    }
+
+    void Dataset::set_io_profile(const IOProfile& profile) {
+        this->io_profile_ = profile;
+    }
+
+    const IOProfile& Dataset::io_profile() const {
+        return this->io_profile_;
     }
 
-    void Dataset::dump_equal_chunks(const std::string& filename, const std::string& dataset) {
-        unsigned int dimensions = this->data_.numdims();
-        intl total_rows = this->global_n_samples_;
+    WriteStatistics Dataset::dump_equal_chunks(const std::string& filename, const std::string& dataset,
+                                               const ChunkLayout& layout) {
+        this->check_sample_partitioning("Dumping");
+
+        // quantized levels are written as their values, HDF5 has no native half precision type
+        const bool convert = this->is_quantized() || this->data_.type() == f16;
+        af::array converted;
+        if (convert) {
+            converted = this->data_.isempty() ? this->data_.as(f32) : this->dequantize(this->data_);
+        }
+        af::array& samples = convert ? converted : this->data_;
+        const hid_t type = af_to_h5(samples.type());
+
+        MPI_Barrier(this->comm_);
+        const double start = MPI_Wtime();
+        unsigned int dimensions = samples.numdims();
+        intl total_rows = this->global_n_samples();
 
         // create parallel access list
-        MPI_Info info = MPI_INFO_NULL;
-        hid_t plist_id = H5Pcreate(H5P_FILE_ACCESS);
-        H5Pset_fapl_mpio(plist_id, this->comm_, info);
+        hid_t plist_id = this->io_profile_.file_access_list(this->comm_);
 
         // create a file and close property list identifier
         hid_t file_id = H5Fcreate(filename.c_str(), H5F_ACC_EXCL, H5P_DEFAULT, plist_id);
@@ -229,59 +1299,400 @@ namespace juml {
             file_id = H5Fopen(filename.c_str(), H5F_ACC_RDWR, plist_id);
         }
         H5Pclose(plist_id);
+        if (file_id < 0) {
+            std::stringstream error;
+            error << "Could not open file " << filename << " for writing";
+            throw std::runtime_error(error.str().c_str());
+        }
 
         // create dataspace for dataset
         hsize_t dims[dimensions];
 
 
         for (unsigned int i = 0; i < dimensions; ++i) {
-            dims[i] = static_cast<hsize_t>(this->data_.dims(i));
+            dims[i] = static_cast<hsize_t>(samples.dims(i));
         }
         dims[dimensions-1] = static_cast<hsize_t>(total_rows);
         std::reverse(dims, dims+dimensions);
 
         hid_t filespace = H5Screate_simple(dimensions, dims, NULL);
 
+        // size of a single sample, nodes without samples do not know it
+        const dim_t local_samples = samples.elements() > 0 ? samples.dims(dimensions - 1) : 0;
+        long long sample_bytes = local_samples > 0 ? static_cast<long long>(samples.bytes() / local_samples) : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &sample_bytes, 1, MPI_LONG_LONG, MPI_MAX, this->comm_);
+
+        // create the dataset creation property list with chunking and filters
+        hid_t create_plist = H5Pcreate(H5P_DATASET_CREATE);
+        const bool filtered = layout.is_chunked() && total_rows > 0 && (layout.shuffle || layout.deflate > 0);
+        if (layout.is_chunked() && total_rows > 0) {
+            hsize_t chunk_samples = layout.chunk_samples;
+            if (chunk_samples == 0) {
+                // align the chunks to the node partitions, bounded by the maximum chunk size
+                long long smallest = local_samples > 0 ? local_samples : total_rows;
+                MPI_Allreduce(MPI_IN_PLACE, &smallest, 1, MPI_LONG_LONG, MPI_MIN, this->comm_);
+                hsize_t bounded = layout.max_chunk_bytes / std::max(sample_bytes, 1LL);
+                chunk_samples = std::max(std::min(static_cast<hsize_t>(smallest), bounded), static_cast<hsize_t>(1));
+            }
+            hsize_t chunk_dims[dimensions];
+            std::copy(dims, dims + dimensions, chunk_dims);
+            chunk_dims[0] = std::min(chunk_samples, static_cast<hsize_t>(total_rows));
+            H5Pset_chunk(create_plist, dimensions, chunk_dims);
+
+            if (layout.shuffle) {
+                H5Pset_shuffle(create_plist);
+            }
+            if (layout.deflate > 0) {
+                if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) <= 0) {
+                    H5Pclose(create_plist);
+                    H5Sclose(filespace);
+                    H5Fclose(file_id);
+                    throw std::runtime_error("The HDF5 deflate filter is not available");
+                }
+                H5Pset_deflate(create_plist, static_cast<unsigned int>(std::min(layout.deflate, 9)));
+            }
+        }
+
         // create dataset and close filespace
-        hid_t type = af_to_h5(this->data_.type());
-        hid_t dset_id = H5Dcreate(file_id, dataset.c_str(), type, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+        hid_t dset_id = H5Dcreate(file_id, dataset.c_str(), type, filespace, H5P_DEFAULT, create_plist, H5P_DEFAULT);
         H5Sclose(filespace);
+        H5Pclose(create_plist);
+        if (dset_id < 0) {
+            H5Fclose(file_id);
+            std::stringstream error;
+            error << "Could not create dataset " << dataset << " in file " << filename;
+            throw std::runtime_error(error.str().c_str());
+        }
 
         // define dataset in memory
         hsize_t local_dims[dimensions];
         for (unsigned int i = 0; i < dimensions; ++i) {
-            local_dims[i] = static_cast<hsize_t>(this->data_.dims(i));
+            local_dims[i] = static_cast<hsize_t>(samples.dims(i));
         }
         std::reverse(local_dims, local_dims + dimensions);
         hid_t memspace = H5Screate_simple(dimensions, local_dims, NULL);
 
         // select hyperslab
         hsize_t offset[dimensions]{0};
-        offset[0] = (this->mpi_rank_ == 0 ? 0 : static_cast<hsize_t>(this->global_offset_));
+        offset[0] = (this->mpi_rank_ == 0 ? 0 : static_cast<hsize_t>(this->global_offset()));
         filespace = H5Dget_space(dset_id);
         H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, NULL, local_dims, NULL);
 
-        // create property list for collective dataset write
-        plist_id = H5Pcreate(H5P_DATASET_XFER);
-        H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_COLLECTIVE);
+        // the transfer follows the I/O profile, parallel writes through filters have to be collective
+        plist_id = this->io_profile_.transfer_list();
+        if (filtered) {
+            H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_COLLECTIVE);
+        }
 
-        this->data_.eval();
-        if (af::getBackendId(this->data_) == AF_BACKEND_CPU) {
-            unsigned char* dump_data = this->data_.device<unsigned char>();
-            herr_t status = H5Dwrite(dset_id, type, memspace, filespace, plist_id, dump_data);
+        herr_t status;
+        samples.eval();
+        if (af::getBackendId(samples) == AF_BACKEND_CPU) {
+            unsigned char* dump_data = samples.device<unsigned char>();
+            status = H5Dwrite(dset_id, type, memspace, filespace, plist_id, dump_data);
+            samples.unlock();
         } else {
-            unsigned char* dump_data = new unsigned char[this->data_.bytes()];
-            this->data_.host(dump_data);
-            herr_t status = H5Dwrite(dset_id, type, memspace, filespace, plist_id, dump_data);
+            unsigned char* dump_data = new unsigned char[samples.bytes()];
+            samples.host(dump_data);
+            status = H5Dwrite(dset_id, type, memspace, filespace, plist_id, dump_data);
             delete[] dump_data;
         }
-        this->data_.unlock();
+
+        // a failed write on any node fails the dump on all of them, as closing the file is collective
+        int written = status >= 0 ? 1 : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &written, 1, MPI_INT, MPI_MIN, this->comm_);
+        if (!written) {
+            H5Dclose(dset_id);
+            H5Sclose(filespace);
+            H5Sclose(memspace);
+            H5Pclose(plist_id);
+            H5Fclose(file_id);
+            std::stringstream error;
+            error << "Could not write dataset " << dataset << " to file " << filename;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // the storage size query is collective, the timing is reported for the slowest node
+        WriteStatistics statistics;
+        statistics.raw_bytes = static_cast<hsize_t>(total_rows) * static_cast<hsize_t>(sample_bytes);
+        statistics.stored_bytes = H5Dget_storage_size(dset_id);
 
         H5Dclose(dset_id);
         H5Sclose(filespace);
         H5Sclose(memspace);
         H5Pclose(plist_id);
         H5Fclose(file_id);
+
+        statistics.seconds = MPI_Wtime() - start;
+        MPI_Allreduce(MPI_IN_PLACE, &statistics.seconds, 1, MPI_DOUBLE, MPI_MAX, this->comm_);
+        return statistics;
+    }
+
+    bool Dataset::sample_layout(std::vector<dim_t>& counts, af::dim4& dimensions, af::dtype& type,
+                                size_t& sample_bytes) const {
+        if (this->is_streamed()) {
+            throw std::runtime_error("Cannot exchange the samples of an out-of-core dataset");
+        }
+        const unsigned int sample_dim = static_cast<unsigned int>(this->sample_dim());
+
+        // exchange the local shapes, types and element sizes
+        const int n_values = 6;
+        long long local[n_values];
+        for (unsigned int i = 0; i < 4; ++i) {
+            local[i] = this->data_.dims(i);
+        }
+        local[sample_dim] = this->data_.isempty() ? 0 : this->data_.dims(sample_dim);
+        local[4] = static_cast<long long>(this->data_.type());
+        local[5] = this->data_.isempty() ? 0 : static_cast<long long>(this->data_.bytes() / this->data_.elements());
+        std::vector<long long> shapes(n_values * this->mpi_size_);
+        MPI_Allgather(local, n_values, MPI_LONG_LONG, shapes.data(), n_values, MPI_LONG_LONG, this->comm_);
+
+        // all non-empty portions have to agree in their sample shape and type
+        counts.assign(this->mpi_size_, 0);
+        int reference = -1;
+        for (int rank = 0; rank < this->mpi_size_; ++rank) {
+            const long long* shape = &shapes[rank * n_values];
+            counts[rank] = shape[sample_dim];
+            if (counts[rank] == 0) continue;
+            if (reference < 0) {
+                reference = rank;
+                continue;
+            }
+            const long long* reference_shape = &shapes[reference * n_values];
+            for (unsigned int i = 0; i < n_values; ++i) {
+                if (i != sample_dim && shape[i] != reference_shape[i]) {
+                    std::stringstream error;
+                    error << "Sample shape or type of rank " << rank << " does not match rank " << reference;
+                    throw std::invalid_argument(error.str().c_str());
+                }
+            }
+        }
+        if (reference < 0) return false;
+
+        // samples are contiguous in memory as the sample dimension is the highest one
+        const long long* reference_shape = &shapes[reference * n_values];
+        dimensions = af::dim4(reference_shape[0], reference_shape[1], reference_shape[2], reference_shape[3]);
+        type = static_cast<af::dtype>(reference_shape[4]);
+        sample_bytes = static_cast<size_t>(reference_shape[5]);
+        for (unsigned int i = 0; i < 4; ++i) {
+            if (i != sample_dim) sample_bytes *= static_cast<size_t>(reference_shape[i]);
+        }
+        return true;
+    }
+
+    void Dataset::exchange(const std::vector<int>& send_counts, af::dim4 dimensions, af::dtype type,
+                           size_t sample_bytes) {
+        const unsigned int sample_dim = static_cast<unsigned int>(this->sample_dim());
+
+        // exchange the sample counts, portions are sent and received in rank order
+        std::vector<int> receive_counts(this->mpi_size_);
+        MPI_Alltoall(send_counts.data(), 1, MPI_INT, receive_counts.data(), 1, MPI_INT, this->comm_);
+        std::vector<int> send_displacements(this->mpi_size_, 0), receive_displacements(this->mpi_size_, 0);
+        for (int rank = 1; rank < this->mpi_size_; ++rank) {
+            send_displacements[rank] = send_displacements[rank - 1] + send_counts[rank - 1];
+            receive_displacements[rank] = receive_displacements[rank - 1] + receive_counts[rank - 1];
+        }
+        const dim_t n_sent = send_displacements.back() + send_counts.back();
+        const dim_t n_received = receive_displacements.back() + receive_counts.back();
+
+        MPI_Datatype sample_type;
+        MPI_Type_contiguous(static_cast<int>(sample_bytes), MPI_BYTE, &sample_type);
+        MPI_Type_commit(&sample_type);
+
+        // prepare the source and target buffers
+        dimensions[sample_dim] = n_received;
+        af::array exchanged(dimensions, type);
+        this->data_.eval();
+        exchanged.eval();
+        af::sync(); //Finish evaluating, so we can use CUDA-Aware MPI safely.
+
+        const bool use_device_pointer = mpi::can_use_device_pointer(this->data_);
+        uint8_t* send_buffer = nullptr;
+        uint8_t* receive_buffer = nullptr;
+        if (n_sent > 0) {
+            if (use_device_pointer) {
+                send_buffer = this->data_.device<uint8_t>();
+            } else {
+                send_buffer = new uint8_t[this->data_.bytes()];
+                this->data_.host(send_buffer);
+            }
+        }
+        if (n_received > 0) {
+            receive_buffer = use_device_pointer ? exchanged.device<uint8_t>() : new uint8_t[exchanged.bytes()];
+        }
+
+        int error = MPI_Alltoallv(send_buffer, send_counts.data(), send_displacements.data(), sample_type,
+                                  receive_buffer, receive_counts.data(), receive_displacements.data(), sample_type,
+                                  this->comm_);
+        MPI_Type_free(&sample_type);
+
+        // release the buffers
+        if (n_sent > 0) {
+            if (use_device_pointer) this->data_.unlock();
+            else delete[] send_buffer;
+        }
+        if (n_received > 0) {
+            if (use_device_pointer) {
+                exchanged.unlock();
+            } else {
+                af_write_array(exchanged.get(), receive_buffer, exchanged.bytes(), afHost);
+                delete[] receive_buffer;
+            }
+        }
+        if (error != MPI_SUCCESS) {
+            throw std::runtime_error("Could not exchange the samples");
+        }
+
+        // the local portion is now held in memory and no longer backed by a mapping
+        this->data_ = exchanged;
+        this->mapped_ = af::array();
+        this->mapping_.reset();
+    }
+
+    void Dataset::permute(const std::vector<unsigned int>& order) {
+        if (order.empty()) return;
+        af::array indices(static_cast<dim_t>(order.size()), order.data());
+        this->data_ = af::lookup(this->data_, indices, static_cast<int>(this->sample_dim()));
+    }
+
+    void Dataset::redistribute(const std::vector<dim_t>& counts) {
+        this->check_sample_partitioning("Redistribution");
+        std::vector<dim_t> current;
+        af::dim4 dimensions;
+        af::dtype type;
+        size_t sample_bytes;
+        const bool has_samples = this->sample_layout(current, dimensions, type, sample_bytes);
+        dim_t total = 0;
+        for (dim_t count : current) {
+            total += count;
+        }
+
+        // determine the target distribution, equal portions if no counts are passed
+        std::vector<dim_t> target(this->mpi_size_);
+        if (counts.empty()) {
+            for (int rank = 0; rank < this->mpi_size_; ++rank) {
+                target[rank] = total / this->mpi_size_ + (rank < total % this->mpi_size_ ? 1 : 0);
+            }
+        } else {
+            if (counts.size() != static_cast<size_t>(this->mpi_size_)) {
+                std::stringstream error;
+                error << "Got " << counts.size() << " sample counts for " << this->mpi_size_ << " nodes";
+                throw std::invalid_argument(error.str().c_str());
+            }
+            dim_t sum = 0;
+            for (dim_t count : counts) {
+                if (count < 0) throw std::invalid_argument("The sample counts must not be negative");
+                sum += count;
+            }
+            if (sum != total) {
+                std::stringstream error;
+                error << "The sample counts sum up to " << sum << ", but there are " << total << " samples";
+                throw std::invalid_argument(error.str().c_str());
+            }
+            target = counts;
+        }
+        this->metadata_pending_ = false;
+        if (!has_samples) {
+            this->global_n_samples_ = 0;
+            this->global_offset_ = 0;
+            return;
+        }
+
+        // the global order is kept, send the overlap of the current with each target range
+        std::vector<dim_t> current_offsets(this->mpi_size_, 0);
+        std::vector<dim_t> target_offsets(this->mpi_size_, 0);
+        for (int rank = 1; rank < this->mpi_size_; ++rank) {
+            current_offsets[rank] = current_offsets[rank - 1] + current[rank - 1];
+            target_offsets[rank] = target_offsets[rank - 1] + target[rank - 1];
+        }
+        const dim_t begin = current_offsets[this->mpi_rank_];
+        const dim_t end = begin + current[this->mpi_rank_];
+
+        std::vector<int> send_counts(this->mpi_size_);
+        for (int rank = 0; rank < this->mpi_size_; ++rank) {
+            const dim_t first = std::max(begin, target_offsets[rank]);
+            const dim_t last = std::min(end, target_offsets[rank] + target[rank]);
+            send_counts[rank] = static_cast<int>(std::max(last - first, static_cast<dim_t>(0)));
+        }
+        this->exchange(send_counts, dimensions, type, sample_bytes);
+
+        this->global_n_samples_ = total;
+        this->global_offset_ = target_offsets[this->mpi_rank_];
+    }
+
+    void Dataset::shuffle(unsigned long long seed) {
+        this->check_sample_partitioning("Shuffling");
+        std::vector<dim_t> counts;
+        af::dim4 dimensions;
+        af::dtype type;
+        size_t sample_bytes;
+        if (!this->sample_layout(counts, dimensions, type, sample_bytes)) return;
+
+        // draw a random destination for each local sample and group the samples by destination
+        std::seed_seq sequence{seed, static_cast<unsigned long long>(this->mpi_rank_)};
+        std::mt19937_64 generator(sequence);
+        std::uniform_int_distribution<int> destination(0, this->mpi_size_ - 1);
+
+        const dim_t n_local = counts[this->mpi_rank_];
+        std::vector<int> destinations(n_local);
+        std::vector<int> send_counts(this->mpi_size_, 0);
+        for (dim_t i = 0; i < n_local; ++i) {
+            destinations[i] = destination(generator);
+            ++send_counts[destinations[i]];
+        }
+        std::vector<unsigned int> order(n_local);
+        std::vector<dim_t> positions(this->mpi_size_, 0);
+        for (int rank = 1; rank < this->mpi_size_; ++rank) {
+            positions[rank] = positions[rank - 1] + send_counts[rank - 1];
+        }
+        for (dim_t i = 0; i < n_local; ++i) {
+            order[positions[destinations[i]]++] = static_cast<unsigned int>(i);
+        }
+        this->permute(order);
+        this->exchange(send_counts, dimensions, type, sample_bytes);
+
+        // randomize the order of the received samples and restore the previous portion sizes
+        order.resize(static_cast<size_t>(this->data_.dims(static_cast<unsigned int>(this->sample_dim()))));
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), generator);
+        this->permute(order);
+        this->redistribute(counts);
+    }
+
+    void Dataset::partial_shuffle(float fraction, unsigned long long seed) {
+        if (fraction < 0.0f || fraction > 1.0f) {
+            throw std::invalid_argument("The exchanged fraction of samples must be in [0, 1]");
+        }
+        this->check_sample_partitioning("Shuffling");
+        std::vector<dim_t> counts;
+        af::dim4 dimensions;
+        af::dtype type;
+        size_t sample_bytes;
+        if (!this->sample_layout(counts, dimensions, type, sample_bytes) || this->mpi_size_ < 2) return;
+
+        // all nodes agree on the shift to the peer they send to
+        std::seed_seq shared_sequence{seed};
+        std::mt19937_64 shared_generator(shared_sequence);
+        std::uniform_int_distribution<int> shift_distribution(1, this->mpi_size_ - 1);
+        const int peer = (this->mpi_rank_ + shift_distribution(shared_generator)) % this->mpi_size_;
+
+        // randomly select the samples to send, they are grouped in rank order with the kept ones
+        std::seed_seq sequence{seed, static_cast<unsigned long long>(this->mpi_rank_)};
+        std::mt19937_64 generator(sequence);
+        const dim_t n_local = counts[this->mpi_rank_];
+        const dim_t n_sent = static_cast<dim_t>(fraction * n_local + 0.5f);
+        std::vector<unsigned int> order(n_local);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), generator);
+        if (peer < this->mpi_rank_) {
+            std::rotate(order.begin(), order.begin() + (n_local - n_sent), order.end());
+        }
+
+        std::vector<int> send_counts(this->mpi_size_, 0);
+        send_counts[peer] = static_cast<int>(n_sent);
+        send_counts[this->mpi_rank_] = static_cast<int>(n_local - n_sent);
+        this->permute(order);
+        this->exchange(send_counts, dimensions, type, sample_bytes);
+        this->redistribute(counts);
     }
 
     time_t Dataset::loading_time() const {
@@ -289,49 +1700,267 @@ namespace juml {
     }
 
     time_t Dataset::modified_time() const {
-        struct stat info;
-        int status;
+        return this->file_version().modified_time;
+    }
 
-        status = stat(this->filename_.c_str(), &info);
-        if (status != 0) {
+    FileVersion Dataset::file_version() const {
+        // only rank zero touches the metadata server if shared, status and version are broadcast together
+        long long metadata[4] = {0, 0, 0, 0};
+        if (!this->shared_metadata_ || this->mpi_rank_ == 0) {
+            struct stat info;
+            metadata[0] = stat(this->filename_.c_str(), &info);
+            if (metadata[0] == 0) {
+                metadata[1] = static_cast<long long>(info.st_mtim.tv_sec);
+                metadata[2] = static_cast<long long>(info.st_mtim.tv_nsec);
+                metadata[3] = static_cast<long long>(info.st_size);
+            }
+        }
+        if (this->shared_metadata_) {
+            MPI_Bcast(metadata, 4, MPI_LONG_LONG, 0, this->comm_);
+        }
+        if (metadata[0] != 0) {
             std::stringstream error;
             error << "Could not open file " << this->filename_;
             throw std::runtime_error(error.str().c_str());
         }
-        return info.st_mtim.tv_sec;
+        return FileVersion{static_cast<time_t>(metadata[1]), metadata[2], metadata[3]};
     }
 
-    af::array Dataset::mean(bool total) const {
-        af::array mean;
-        if (total) {
-            mean = af::mean(af::array(this->data_, this->data_.elements()));
+    af::array Moments::variance() const {
+        return this->m2 / this->count;
+    }
+
+    af::array Moments::stddev() const {
+        return af::sqrt(this->variance());
+    }
+
+    /**
+     * MomentState
+     *
+     * The running moments of a single feature, merged in double precision.
+     */
+    struct MomentState {
+        double count;
+        double mean;
+        double m2;
+        double minimum;
+        double maximum;
+    };
+
+    static void merge_moments(MomentState& into, const MomentState& other) {
+        if (other.count == 0) return;
+        if (into.count == 0) {
+            into = other;
+            return;
+        }
+        const double count = into.count + other.count;
+        const double delta = other.mean - into.mean;
+        into.mean += delta * other.count / count;
+        into.m2 += other.m2 + delta * delta * into.count * other.count / count;
+        into.count = count;
+        into.minimum = std::min(into.minimum, other.minimum);
+        into.maximum = std::max(into.maximum, other.maximum);
+    }
+
+    static void reduce_moments(void* in, void* inout, int* length, MPI_Datatype*) {
+        const MomentState* source = static_cast<const MomentState*>(in);
+        MomentState* destination = static_cast<MomentState*>(inout);
+        for (int i = 0; i < *length; ++i) {
+            merge_moments(destination[i], source[i]);
+        }
+    }
+
+    static af::array subtract(const af::array& lhs, const af::array& rhs) {
+        return lhs - rhs;
+    }
+
+    static af::array multiply(const af::array& lhs, const af::array& rhs) {
+        return lhs * rhs;
+    }
+
+    static af::array add(const af::array& lhs, const af::array& rhs) {
+        return lhs + rhs;
+    }
+
+    /**
+     * scale_in_place
+     *
+     * Applies per-feature factors and summands to features x samples data on the CPU, without any temporaries. The
+     * parameters stay in the cache while the samples are streamed once.
+     */
+    template <typename T>
+    static void scale_in_place(af::array& data, const af::array& scale, const af::array& offset, dim_t n_features,
+                               dim_t n_samples) {
+        const af::dtype type = data.type();
+        std::vector<T> factors(static_cast<size_t>(n_features));
+        std::vector<T> summands(static_cast<size_t>(n_features));
+        scale.as(type).host(factors.data());
+        offset.as(type).host(summands.data());
+
+        T* values = data.device<T>();
+        #pragma omp parallel for schedule(static)
+        for (dim_t sample = 0; sample < n_samples; ++sample) {
+            T* column = values + sample * n_features;
+            for (dim_t feature = 0; feature < n_features; ++feature) {
+                column[feature] = column[feature] * factors[feature] + summands[feature];
+            }
+        }
+        data.unlock();
+    }
+
+    static void download(const af::array& data, std::vector<double>& values) {
+        values.resize(static_cast<size_t>(data.elements()));
+        if (data.type() == f64) {
+            data.host(values.data());
         } else {
-            mean = af::mean(this->data_, this->sample_dim());
+            std::vector<float> buffer(values.size());
+            data.as(f32).host(buffer.data());
+            std::copy(buffer.begin(), buffer.end(), values.begin());
         }
-        mean *= (float)this->n_samples();
-        mpi::allreduce_inplace(mean, MPI_SUM, this->comm_);
-        mean /= (float)this->global_n_samples_;
-        return mean;
     }
 
-    af::array Dataset::stddev(bool total) const {
-        af:: array mean = this->mean(total);
-        af::array stddev;
+    Moments Dataset::moments(bool total) const {
+        if (this->data_.issparse()) {
+            throw std::domain_error("Moments are not available for sparse datasets");
+        }
+
+        // a single sample determines the shape of the per-feature moments, nodes without samples adopt the one of the
+        // others, as all nodes have to reduce the same number of moments
+        const unsigned int sample_dim = static_cast<unsigned int>(this->sample_dim());
+        const MPI_Comm comm = total ? this->comm_ : this->sample_comm();
+        af::dim4 shape = this->is_streamed() ? this->local_dims_ : this->data_.dims();
+        shape[sample_dim] = 1;
+        if (!total) {
+            long long extents[4] = {shape[0], shape[1], shape[2], shape[3]};
+            if (this->is_streamed() ? this->local_dims_[sample_dim] == 0 : this->data_.isempty()) {
+                std::fill(extents, extents + 4, 0LL);
+            }
+            MPI_Allreduce(MPI_IN_PLACE, extents, 4, MPI_LONG_LONG, MPI_MAX, comm);
+            shape = af::dim4(extents[0], extents[1], extents[2], extents[3]);
+        }
+        const dim_t n_features = total ? 1 : shape.elements();
+        if (n_features > std::numeric_limits<int>::max()) {
+            throw std::domain_error("Message too large");
+        }
+
+        const double infinity = std::numeric_limits<double>::infinity();
+        std::vector<MomentState> states(static_cast<size_t>(n_features), MomentState{0, 0, 0, infinity, -infinity});
+        std::vector<double> sums, squares, minima, maxima;
+        af::dtype type = f32;
+        for (ChunkIterator blocks(*this); blocks.has_next();) {
+            const af::array& block = blocks.next();
+            if (block.isempty()) continue;
+            const dim_t n = block.dims(sample_dim);
+            if (block.type() == f64) type = f64;
+
+            // arrange the values of the block as features x samples, each block is centered on its own mean
+            af::array values = block.type() == f64 ? block : block.as(f32);
+            if (total) {
+                values = af::moddims(values, 1, values.elements());
+            } else if (sample_dim == 0) {
+                values = af::moddims(values, n, n_features).T();
+            } else {
+                values = af::moddims(values, n_features, n);
+            }
+            const dim_t count = values.dims(1);
+            af::array mean = af::sum(values, 1) / static_cast<double>(count);
+            af::array centered = af::batchFunc(values, mean, subtract);
+            download(mean, sums);
+            download(af::sum(centered * centered, 1), squares);
+            download(af::min(values, 1), minima);
+            download(af::max(values, 1), maxima);
+
+            for (size_t i = 0; i < states.size(); ++i) {
+                merge_moments(states[i], MomentState{static_cast<double>(count), sums[i], squares[i], minima[i],
+                                                     maxima[i]});
+            }
+        }
+
+        // merge the partials of all nodes in a single reduction, the blocks of a feature grid only share features
+        // along their grid column, while all of them together tile the data
+        MPI_Datatype state_type;
+        MPI_Op merge;
+        MPI_Type_contiguous(5, MPI_DOUBLE, &state_type);
+        MPI_Type_commit(&state_type);
+        MPI_Op_create(&reduce_moments, 1, &merge);
+        MPI_Allreduce(MPI_IN_PLACE, states.data(), static_cast<int>(n_features), state_type, merge, comm);
+        MPI_Op_free(&merge);
+        MPI_Type_free(&state_type);
+
+        // nodes without samples have not seen their type
+        int is_double = type == f64 ? 1 : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &is_double, 1, MPI_INT, MPI_MAX, comm);
+        type = is_double ? f64 : f32;
 
-        if (total) {
-            stddev = this->data_ - af::tile(mean, this->data_.dims());
+        std::vector<double> fields[5];
+        for (const MomentState& state : states) {
+            fields[0].push_back(state.count);
+            fields[1].push_back(state.mean);
+            fields[2].push_back(state.m2);
+            fields[3].push_back(state.minimum);
+            fields[4].push_back(state.maximum);
+        }
+        const af::dim4 dims = total ? af::dim4(1) : shape;
+        return Moments{af::array(dims, fields[0].data()), af::array(dims, fields[1].data()),
+                       af::array(dims, fields[2].data()), af::array(dims, fields[3].data()),
+                       af::array(dims, fields[4].data()), type};
+    }
+
+    Dataset Dataset::view(dim_t begin, dim_t end) const {
+        if (this->is_streamed()) {
+            throw std::domain_error("Out-of-core datasets cannot be viewed");
+        }
+        if (this->data_.issparse()) {
+            throw std::domain_error("Sparse datasets cannot be viewed");
+        }
+        if (begin < 0 || end < begin || end > this->n_samples()) {
+            std::stringstream error;
+            error << "The range [" << begin << ", " << end << ") exceeds the " << this->n_samples() << " local samples";
+            throw std::invalid_argument(error.str().c_str());
+        }
+
+        // indexing a range of the sample dimension references the buffer instead of copying it
+        const unsigned int sample_dim = static_cast<unsigned int>(this->sample_dim());
+        af::array samples;
+        if (begin == end) {
+            af::dim4 dims = this->data_.dims();
+            dims[sample_dim] = 0;
+            samples = af::array(dims, this->data_.type());
         } else {
-            af::dim4 broadcast(1,1,1,1);
-            broadcast[this->sample_dim()] = n_samples();
-            stddev = this->data_ - af::tile(mean, broadcast);
+            af::seq range(static_cast<double>(begin), static_cast<double>(end - 1));
+            switch (sample_dim) {
+                case 0:  samples = this->data_(range); break;
+                case 1:  samples = this->data_(af::span, range); break;
+                case 2:  samples = this->data_(af::span, af::span, range); break;
+                default: samples = this->data_(af::span, af::span, af::span, range); break;
+            }
         }
-        stddev *= stddev;
-        stddev = af::sum(stddev, static_cast<unsigned int>(this->sample_dim()));
-        mpi::allreduce_inplace(stddev, MPI_SUM, this->comm_);
-        stddev /= (float) this->global_n_samples_;
-        stddev = af::sqrt(stddev);
 
-        return stddev;
+        Dataset view(samples, this->comm_, static_cast<dim_t>(sample_dim));
+        view.half_precision_ = this->half_precision_;
+        view.scale_ = this->scale_;
+        view.offset_ = this->offset_;
+        // a memory mapping has to outlive the view
+        view.mapping_ = this->mapping_;
+        view.mapped_ = this->mapped_;
+        // the global metadata of the view is resolved among the nodes holding the same features
+        view.partitioning_ = this->partitioning_;
+        view.feature_parts_ = this->feature_parts_;
+        view.global_n_features_ = this->global_n_features_;
+        view.feature_offset_ = this->feature_offset_;
+        view.feature_comm_ = this->feature_comm_;
+        view.sample_comm_ = this->sample_comm_;
+        return view;
+    }
+
+    af::array Dataset::mean(bool total) const {
+        const Moments moments = this->moments(total);
+        return moments.mean.as(moments.type);
+    }
+
+    af::array Dataset::stddev(bool total) const {
+        const Moments moments = this->moments(total);
+        return moments.stddev().as(moments.type);
     }
 
     void Dataset::normalize(float min, float max, bool independent_features, const af::array& selected_features) {
@@ -354,18 +1983,20 @@ namespace juml {
         }
         int num_features = af::sum<int>(mask);
 
-        // Compute local minimum
-        af::array minimum = af::min(data(mask,af::span), 1);
-        af::array maximum = af::max(data(mask,af::span), 1);
+        // Compute the global feature range in a single pass
+        const Moments moments = this->moments();
+        const af::dtype type = this->is_quantized() ? f32 : moments.type;
+        af::array minimum = moments.minimum(mask).as(type);
+        af::array maximum = moments.maximum(mask).as(type);
         if (!independent_features) {
             minimum = af::min(minimum);
             maximum = af::max(maximum);
+            if (this->feature_parts_ > 1) {
+                mpi::allreduce_inplace(minimum, MPI_MIN, this->feature_comm());
+                mpi::allreduce_inplace(maximum, MPI_MAX, this->feature_comm());
+            }
         }
 
-        // Reduce minimum
-        mpi::allreduce_inplace(minimum, MPI_MIN, this->comm_);
-        mpi::allreduce_inplace(maximum, MPI_MAX, this->comm_);
-
         // Update data
         af::array norm_range = af::constant(max - min, minimum.elements()) / (maximum - minimum);
         if (!independent_features) {
@@ -373,6 +2004,12 @@ namespace juml {
             norm_range = af::tile(norm_range, static_cast<unsigned int>(num_features));
         }
 
+        // quantized samples keep their levels, the transformation is folded into the affine parameters
+        if (this->is_quantized()) {
+            this->offset_(mask) = (this->offset_(mask) - minimum) * norm_range + min;
+            this->scale_(mask) = this->scale_(mask) * norm_range;
+            return;
+        }
         data(mask, af::span) -= af::tile(minimum, 1, static_cast<unsigned int>(this->n_samples()));
         data(mask, af::span) *= af::tile(norm_range, 1, static_cast<unsigned int>(this->n_samples()));
         data(mask, af::span) += af::constant(min, num_features, this->n_samples());
@@ -396,12 +2033,23 @@ namespace juml {
 
         // Compute mean and std
         int num_features = af::sum<int>(mask);
-        af::array mean = this->mean(!independent_features)(mask);
-        af::array std = this->stddev(!independent_features)(mask) / x_std;
-
+        const Moments moments = this->moments(!independent_features);
+        const af::dtype type = this->is_quantized() ? f32 : moments.type;
+        af::array mean;
+        af::array std;
         if (!independent_features) {
-            mean = af::tile(mean(0), static_cast<unsigned int>(num_features));
-            std = af::tile(std(0), static_cast<unsigned int>(num_features));
+            mean = af::tile(moments.mean.as(type), static_cast<unsigned int>(num_features));
+            std = af::tile((moments.stddev() / x_std).as(type), static_cast<unsigned int>(num_features));
+        } else {
+            mean = moments.mean(mask).as(type);
+            std = (moments.stddev()(mask) / x_std).as(type);
+        }
+
+        // quantized samples keep their levels, the transformation is folded into the affine parameters
+        if (this->is_quantized()) {
+            this->offset_(mask) = (this->offset_(mask) - mean) / std;
+            this->scale_(mask) = this->scale_(mask) / std;
+            return;
         }
 
         // Normalize data
@@ -410,6 +2058,133 @@ namespace juml {
         data(mask, af::span) /= af::tile(std, 1, static_cast<unsigned int>(this->n_samples()));
     }
 
+    void Dataset::scale_features(const af::array& scale, const af::array& offset) {
+        if (this->is_streamed()) {
+            throw std::domain_error("Out-of-core datasets have to be transformed block by block");
+        }
+        if (this->sample_dim() != 1 || this->data_.numdims() > 2) {
+            throw std::invalid_argument("Feature scaling is only defined for two-dimensional input data");
+        }
+        if (this->data_.issparse()) {
+            throw std::domain_error("Sparse datasets cannot be scaled");
+        }
+        if (this->is_quantized()) {
+            if (scale.elements() != this->n_features() || offset.elements() != this->n_features()) {
+                throw std::invalid_argument("The scaling parameters do not match the number of features");
+            }
+            this->offset_ = this->offset_ * af::moddims(scale, scale.elements()).as(f32)
+                          + af::moddims(offset, offset.elements()).as(f32);
+            this->scale_ = this->scale_ * af::moddims(scale, scale.elements()).as(f32);
+            return;
+        }
+        Dataset::scale_features(this->data_, scale, offset);
+    }
+
+    void Dataset::scale_features(af::array& data, const af::array& scale, const af::array& offset) {
+        const dim_t n_features = data.dims(0);
+        if (scale.elements() != n_features || offset.elements() != n_features) {
+            throw std::invalid_argument("The scaling parameters do not match the number of features");
+        }
+        if (data.isempty()) {
+            return;
+        }
+        const dim_t n_samples = data.elements() / n_features;
+        const af::dtype type = data.type();
+
+        // on the CPU the samples are transformed where they are, half precision ones in a widened copy
+        if (af::getBackendId(data) == AF_BACKEND_CPU && (type == f32 || type == f64 || type == f16)) {
+            if (type == f64) {
+                scale_in_place<double>(data, scale, offset, n_features, n_samples);
+            } else if (type == f32) {
+                scale_in_place<float>(data, scale, offset, n_features, n_samples);
+            } else {
+                af::array widened = data.as(f32);
+                scale_in_place<float>(widened, scale, offset, n_features, n_samples);
+                data = widened.as(f16);
+            }
+            return;
+        }
+
+        // other backends broadcast the parameters, so that the expression is a single kernel without tiled copies
+        const af::dtype compute_type = type == f64 ? f64 : f32;
+        const af::array samples = af::moddims(data, n_features, n_samples).as(compute_type);
+        const af::array factors = af::moddims(scale, n_features).as(compute_type);
+        const af::array summands = af::moddims(offset, n_features).as(compute_type);
+        data = af::moddims(af::batchFunc(af::batchFunc(samples, factors, multiply), summands, add),
+                           data.dims()).as(type);
+    }
+
+    void Dataset::quantize() {
+        if (this->is_streamed()) {
+            throw std::domain_error("Out-of-core datasets cannot be quantized");
+        }
+        if (this->sample_dim() != 1 || this->data_.numdims() > 2) {
+            throw std::invalid_argument("Quantization is only defined for two-dimensional input data");
+        }
+        if (this->data_.issparse()) {
+            throw std::domain_error("Sparse datasets cannot be quantized");
+        }
+        if (this->is_quantized()) {
+            return;
+        }
+
+        // global feature range, nodes without samples contribute the neutral elements
+        const dim_t n_features = this->n_features();
+        af::array minimum = af::constant(std::numeric_limits<float>::infinity(), n_features);
+        af::array maximum = af::constant(-std::numeric_limits<float>::infinity(), n_features);
+        for (ChunkIterator blocks(*this); blocks.has_next();) {
+            const af::array& block = blocks.next();
+            minimum = af::min(minimum, af::min(block, 1).as(f32));
+            maximum = af::max(maximum, af::max(block, 1).as(f32));
+        }
+        mpi::allreduce_inplace(minimum, MPI_MIN, this->sample_comm());
+        mpi::allreduce_inplace(maximum, MPI_MAX, this->sample_comm());
+
+        // constant features are represented by the offset alone
+        af::array range = maximum - minimum;
+        af::array scale = range / 255.0f;
+        scale(range <= 0 || af::isNaN(range)) = 1.0f;
+
+        // encode block by block, so that at most one block is held in f32
+        af::array levels = af::constant(0, this->data_.dims(), u8);
+        for (ChunkIterator blocks(*this); blocks.has_next();) {
+            const af::array& block = blocks.next();
+            const unsigned int n = static_cast<unsigned int>(block.dims(1));
+            af::seq samples(static_cast<double>(blocks.offset()), static_cast<double>(blocks.offset() + n - 1));
+            af::array scaled = (block - af::tile(minimum, 1, n)) / af::tile(scale, 1, n);
+            levels(af::span, samples) = af::clamp(af::round(scaled), 0.0, 255.0).as(u8);
+        }
+        this->data_ = levels;
+        this->mapped_ = af::array();
+        this->mapping_.reset();
+        this->scale_ = scale;
+        this->offset_ = minimum;
+    }
+
+    bool Dataset::is_quantized() const {
+        return !this->scale_.isempty();
+    }
+
+    bool Dataset::is_compact() const {
+        return !this->is_streamed() && (this->is_quantized() || this->data_.type() == f16);
+    }
+
+    const af::array& Dataset::scale() const {
+        return this->scale_;
+    }
+
+    const af::array& Dataset::offset() const {
+        return this->offset_;
+    }
+
+    af::array Dataset::dequantize(const af::array& block) const {
+        if (this->scale_.isempty()) {
+            return Dataset::widen(block);
+        }
+        const unsigned int n = static_cast<unsigned int>(block.dims(1));
+        return block.as(f32) * af::tile(this->scale_, 1, n) + af::tile(this->offset_, 1, n);
+    }
+
     af::array& Dataset::data() {
         return this->data_;
     }
@@ -419,22 +2194,34 @@ namespace juml {
     }
     
     dim_t Dataset::n_samples() const {
+        if (this->sample_dim_pending_) {
+            this->resolve_metadata();
+        }
+        if (this->is_streamed())
+            return this->local_dims_[static_cast<unsigned int>(this->sample_dim_)];
         return this->data_.dims(static_cast<unsigned int>(this->sample_dim_));
     }
     
     dim_t Dataset::n_features() const {
+        if (this->is_streamed())
+            return this->local_dims_[0];
         return this->data_.dims(0);
     }
 
     dim_t Dataset::global_n_samples() const {
+        this->resolve_metadata();
         return this->global_n_samples_;
     }
 
     dim_t Dataset::global_offset() const {
+        this->resolve_metadata();
         return this->global_offset_;
     }
 
     dim_t Dataset::sample_dim() const {
+        if (this->sample_dim_pending_) {
+            this->resolve_metadata();
+        }
         return this->sample_dim_;
     }
 } // namespace juml
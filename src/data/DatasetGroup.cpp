@@ -0,0 +1,140 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: DatasetGroup.cpp
+*
+* Description: Implementation of class DatasetGroup
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <sstream>
+#include <stdexcept>
+
+#include "data/DatasetGroup.h"
+
+namespace juml {
+    DatasetGroup& DatasetGroup::add(Dataset& dataset) {
+        if (!this->datasets_.empty()) {
+            const Dataset& first = *this->datasets_.front();
+            if (dataset.filename_ != first.filename_) {
+                std::stringstream error;
+                error << "Dataset " << dataset.dataset_ << " is not located in file " << first.filename_;
+                throw std::invalid_argument(error.str().c_str());
+            }
+            if (dataset.comm_ != first.comm_) {
+                std::stringstream error;
+                error << "Dataset " << dataset.dataset_ << " is distributed over a different communicator";
+                throw std::invalid_argument(error.str().c_str());
+            }
+        }
+        this->datasets_.push_back(&dataset);
+        return *this;
+    }
+
+    size_t DatasetGroup::size() const {
+        return this->datasets_.size();
+    }
+
+    void DatasetGroup::load_equal_chunks(bool force) {
+        if (this->datasets_.empty() || this->datasets_.front()->filename_.empty()) {
+            return ;
+        }
+
+        // a single stat for the whole group
+        Dataset& first = *this->datasets_.front();
+        const FileVersion version = first.file_version();
+        const time_t mod_time = version.modified_time;
+        bool loaded = true;
+        for (const Dataset* dataset : this->datasets_) {
+            loaded = loaded && mod_time <= dataset->loading_time_ && dataset->weights_.empty();
+        }
+        if (!force && loaded) {
+            return ;
+        }
+
+        // members held by the load registry or the node-local cache do not need to be read
+        const std::vector<double> weights;
+        std::vector<Dataset*> pending;
+        const Dataset* reference = nullptr;
+        for (Dataset* dataset : this->datasets_) {
+            dataset->loading_time_ = mod_time;
+            // reloaded samples are not quantized with the parameters of the previous ones
+            dataset->scale_ = af::array();
+            dataset->offset_ = af::array();
+            if (!dataset->lookup_partition(weights, version, force)) {
+                pending.push_back(dataset);
+            } else if (reference == nullptr) {
+                reference = dataset;
+            } else {
+                this->check_samples(*dataset, static_cast<hsize_t>(dataset->global_n_samples_), *reference);
+            }
+        }
+        if (pending.empty()) {
+            return ;
+        }
+
+        // a single collective open for the remaining members
+        const hid_t file_id = first.open_file();
+        try {
+            hsize_t position = 0;
+            hsize_t chunk_size = 0;
+            for (Dataset* dataset : pending) {
+                const hid_t data_id = dataset->open_dataset(file_id);
+                try {
+                    // all nodes see the same extents, the check therefore does not need to be communicated
+                    const hsize_t n_samples = dataset->sample_extent(data_id);
+                    if (reference == nullptr) {
+                        reference = dataset;
+                        dataset->partition(n_samples, weights, position, chunk_size);
+                    } else {
+                        this->check_samples(*dataset, n_samples, *reference);
+                        if (dataset == pending.front()) {
+                            dataset->partition(n_samples, weights, position, chunk_size);
+                        }
+                    }
+                    dataset->weights_.clear();
+                    dataset->load_partition(data_id, n_samples, position, chunk_size);
+                } catch (...) {
+                    H5Dclose(data_id);
+                    throw;
+                }
+                H5Dclose(data_id);
+            }
+        } catch (...) {
+            H5Fclose(file_id);
+            throw;
+        }
+        H5Fclose(file_id);
+
+        for (Dataset* dataset : pending) {
+            dataset->store_partition(weights, version);
+        }
+    }
+
+    void DatasetGroup::check_samples(const Dataset& dataset, hsize_t n_samples, const Dataset& reference) const {
+        if (n_samples != static_cast<hsize_t>(reference.global_n_samples_)) {
+            std::stringstream error;
+            error << "Got " << n_samples << " samples in dataset " << dataset.dataset_ << ", but "
+                  << reference.global_n_samples_ << " in dataset " << reference.dataset_;
+            throw std::domain_error(error.str().c_str());
+        }
+    }
+
+    void DatasetGroup::joint_load(Dataset& X, Dataset& y, bool force) {
+        if (X.filename_.empty() || X.filename_ != y.filename_ || X.comm_ != y.comm_) {
+            X.load_equal_chunks(force);
+            y.load_equal_chunks(force);
+            return;
+        }
+
+        DatasetGroup group;
+        group.add(X).add(y);
+        group.load_equal_chunks(force);
+    }
+}  // juml
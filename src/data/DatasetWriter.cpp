@@ -0,0 +1,270 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: DatasetWriter.cpp
+*
+* Description: Implementation of class DatasetWriter
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <algorithm>
+#include <climits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "core/HDF5.h"
+#include "data/ChunkIterator.h"
+#include "data/DatasetWriter.h"
+
+namespace juml {
+    DatasetWriter::DatasetWriter(const std::string& filename, const std::string& dataset, MPI_Comm comm,
+                                 const ChunkLayout& layout, const IOProfile& profile)
+      : filename_(filename),
+        dataset_(dataset),
+        comm_(comm),
+        layout_(layout),
+        io_profile_(profile),
+        file_id_(-1),
+        data_id_(-1),
+        type_(f32),
+        n_dims_(0),
+        written_(0) {
+        MPI_Comm_rank(this->comm_, &this->mpi_rank_);
+        MPI_Comm_size(this->comm_, &this->mpi_size_);
+    }
+
+    DatasetWriter::~DatasetWriter() {
+        this->close();
+    }
+
+    void DatasetWriter::create(const af::array& block) {
+        // agree on the sample shape and type, nodes without samples do not contribute
+        long long metadata[6] = {-1, -1, -1, -1, -1, -1};
+        if (!block.isempty()) {
+            metadata[0] = std::max(2u, block.numdims());
+            metadata[1] = static_cast<long long>(block.type());
+            for (unsigned int i = 0; i < 3; ++i) {
+                metadata[2 + i] = block.dims(i);
+            }
+            metadata[5] = static_cast<long long>(block.bytes() / block.elements());
+        }
+        MPI_Allreduce(MPI_IN_PLACE, metadata, 6, MPI_LONG_LONG, MPI_MAX, this->comm_);
+        if (metadata[0] < 0) {
+            return;
+        }
+        this->n_dims_ = static_cast<int>(metadata[0]);
+        this->type_ = static_cast<af::dtype>(metadata[1]);
+        this->sample_dims_ = af::dim4(1, 1, 1, 1);
+        for (int i = 0; i < this->n_dims_ - 1; ++i) {
+            this->sample_dims_[i] = metadata[2 + i];
+        }
+        const hid_t type = hdf5::af_to_h5(this->type_);
+
+        // open or create the file
+        hid_t access_plist = this->io_profile_.file_access_list(this->comm_);
+        this->file_id_ = H5Fcreate(this->filename_.c_str(), H5F_ACC_EXCL, H5P_DEFAULT, access_plist);
+        if (this->file_id_ < 0) {
+            this->file_id_ = H5Fopen(this->filename_.c_str(), H5F_ACC_RDWR, access_plist);
+        }
+        H5Pclose(access_plist);
+        if (this->file_id_ < 0) {
+            std::stringstream error;
+            error << "Could not open file " << this->filename_ << " for writing";
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // extendible along the samples, the remaining dimensions are fixed (HDF5 row-major order)
+        const int n_dims = this->n_dims_;
+        hsize_t dims[n_dims];
+        hsize_t max_dims[n_dims];
+        hsize_t chunk_dims[n_dims];
+        for (int i = 1; i < n_dims; ++i) {
+            dims[i] = max_dims[i] = chunk_dims[i] = static_cast<hsize_t>(this->sample_dims_[n_dims - 1 - i]);
+        }
+        dims[0] = 0;
+        max_dims[0] = H5S_UNLIMITED;
+
+        // chunks default to the smallest block of the first append, bounded by the maximum chunk size
+        hsize_t chunk_samples = this->layout_.chunk_samples;
+        if (chunk_samples == 0) {
+            const size_t sample_bytes = this->sample_dims_.elements() * static_cast<size_t>(metadata[5]);
+            long long smallest = block.isempty() ? LLONG_MAX : block.dims(n_dims - 1);
+            MPI_Allreduce(MPI_IN_PLACE, &smallest, 1, MPI_LONG_LONG, MPI_MIN, this->comm_);
+            const hsize_t bounded = this->layout_.max_chunk_bytes / std::max(sample_bytes, static_cast<size_t>(1));
+            chunk_samples = std::max(std::min(static_cast<hsize_t>(smallest), bounded), static_cast<hsize_t>(1));
+        }
+        chunk_dims[0] = chunk_samples;
+
+        hid_t create_plist = H5Pcreate(H5P_DATASET_CREATE);
+        H5Pset_chunk(create_plist, n_dims, chunk_dims);
+        if (this->layout_.shuffle) {
+            H5Pset_shuffle(create_plist);
+        }
+        if (this->layout_.deflate > 0) {
+            if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) <= 0) {
+                H5Pclose(create_plist);
+                this->close();
+                throw std::runtime_error("The HDF5 deflate filter is not available");
+            }
+            H5Pset_deflate(create_plist, static_cast<unsigned int>(std::min(this->layout_.deflate, 9)));
+        }
+
+        hid_t file_space = H5Screate_simple(n_dims, dims, max_dims);
+        this->data_id_ = H5Dcreate(this->file_id_, this->dataset_.c_str(), type, file_space,
+                                   H5P_DEFAULT, create_plist, H5P_DEFAULT);
+        H5Sclose(file_space);
+        H5Pclose(create_plist);
+        if (this->data_id_ < 0) {
+            this->close();
+            std::stringstream error;
+            error << "Could not create dataset " << this->dataset_ << " in file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+    }
+
+    void DatasetWriter::append(const af::array& block) {
+        // HDF5 has no native half precision type
+        if (block.type() == f16) {
+            this->append(block.as(f32));
+            return;
+        }
+        if (this->data_id_ < 0) {
+            this->create(block);
+            if (this->data_id_ < 0) return;
+        }
+
+        // the samples must match the previously written ones, all nodes agree before the collective calls
+        const int n_dims = this->n_dims_;
+        int matches = 1;
+        if (!block.isempty()) {
+            matches = block.type() == this->type_ && block.numdims() <= static_cast<unsigned int>(n_dims);
+            for (int i = 0; i < n_dims - 1; ++i) {
+                matches = matches && block.dims(i) == this->sample_dims_[i];
+            }
+        }
+        int all_match = matches;
+        MPI_Allreduce(MPI_IN_PLACE, &all_match, 1, MPI_INT, MPI_MIN, this->comm_);
+        if (!all_match) {
+            std::stringstream error;
+            if (matches) {
+                error << "Got samples on another node that do not match the previously written ones";
+            } else {
+                error << "Got samples of shape (" << block.dims(0) << ", " << block.dims(1) << ", " << block.dims(2)
+                      << ") and type " << block.type() << ", but expected (" << this->sample_dims_[0] << ", "
+                      << this->sample_dims_[1] << ", " << this->sample_dims_[2] << ") and type " << this->type_;
+            }
+            throw std::invalid_argument(error.str().c_str());
+        }
+
+        // the blocks are stored in rank order
+        long long count = block.isempty() ? 0 : block.dims(n_dims - 1);
+        std::vector<long long> counts(this->mpi_size_);
+        MPI_Allgather(&count, 1, MPI_LONG_LONG, counts.data(), 1, MPI_LONG_LONG, this->comm_);
+        hsize_t offset = this->written_;
+        hsize_t total = 0;
+        for (int rank = 0; rank < this->mpi_size_; ++rank) {
+            if (rank < this->mpi_rank_) offset += counts[rank];
+            total += counts[rank];
+        }
+        if (total == 0) return;
+
+        // grow the extent collectively
+        hsize_t dims[n_dims];
+        hsize_t local_dims[n_dims];
+        hsize_t start[n_dims];
+        for (int i = 1; i < n_dims; ++i) {
+            dims[i] = local_dims[i] = static_cast<hsize_t>(this->sample_dims_[n_dims - 1 - i]);
+            start[i] = 0;
+        }
+        dims[0] = this->written_ + total;
+        local_dims[0] = static_cast<hsize_t>(count);
+        start[0] = offset;
+        if (H5Dset_extent(this->data_id_, dims) < 0) {
+            std::stringstream error;
+            error << "Could not extend dataset " << this->dataset_ << " in file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        hid_t file_space = H5Dget_space(this->data_id_);
+        hid_t mem_space = H5Screate_simple(n_dims, local_dims, NULL);
+        if (count > 0) {
+            H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, local_dims, NULL);
+        } else {
+            H5Sselect_none(file_space);
+            H5Sselect_none(mem_space);
+        }
+        hid_t transfer_plist = H5Pcreate(H5P_DATASET_XFER);
+        H5Pset_dxpl_mpio(transfer_plist, H5FD_MPIO_COLLECTIVE);
+
+        // nodes without samples still take part in the collective write
+        const hid_t type = hdf5::af_to_h5(this->type_);
+        herr_t status;
+        unsigned char dummy = 0;
+        if (count == 0) {
+            status = H5Dwrite(this->data_id_, type, mem_space, file_space, transfer_plist, &dummy);
+        } else if (af::getBackendId(block) == AF_BACKEND_CPU) {
+            block.eval();
+            unsigned char* data = block.device<unsigned char>();
+            status = H5Dwrite(this->data_id_, type, mem_space, file_space, transfer_plist, data);
+            block.unlock();
+        } else {
+            std::vector<unsigned char> buffer(block.bytes());
+            block.host(buffer.data());
+            status = H5Dwrite(this->data_id_, type, mem_space, file_space, transfer_plist, buffer.data());
+        }
+        H5Pclose(transfer_plist);
+        H5Sclose(mem_space);
+        H5Sclose(file_space);
+
+        if (status < 0) {
+            std::stringstream error;
+            error << "Could not write to dataset " << this->dataset_ << " in file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+        this->written_ += total;
+    }
+
+    void DatasetWriter::append_blocks(Dataset& X, const std::function<af::array(const af::array&)>& transform,
+                                      dim_t block_size) {
+        X.load_equal_chunks();
+        if (block_size < 0) {
+            block_size = X.block_size();
+        }
+
+        // all nodes have to append equally often
+        const dim_t n_samples = X.n_samples();
+        long long n_blocks = n_samples == 0 ? 0 : (block_size > 0 ? (n_samples + block_size - 1) / block_size : 1);
+        MPI_Allreduce(MPI_IN_PLACE, &n_blocks, 1, MPI_LONG_LONG, MPI_MAX, this->comm_);
+
+        ChunkIterator blocks(X, block_size);
+        for (long long block = 0; block < n_blocks; ++block) {
+            if (blocks.has_next()) {
+                this->append(transform(blocks.next()));
+            } else {
+                this->append(af::array());
+            }
+        }
+    }
+
+    void DatasetWriter::close() {
+        if (this->data_id_ >= 0) {
+            H5Dclose(this->data_id_);
+            this->data_id_ = -1;
+        }
+        if (this->file_id_ >= 0) {
+            H5Fclose(this->file_id_);
+            this->file_id_ = -1;
+        }
+    }
+
+    hsize_t DatasetWriter::written() const {
+        return this->written_;
+    }
+} // namespace juml
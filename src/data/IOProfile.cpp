@@ -0,0 +1,78 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: IOProfile.cpp
+*
+* Description: Implementation of struct IOProfile
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <stdexcept>
+#include <string>
+
+#include "data/IOProfile.h"
+
+namespace juml {
+    IOProfile::IOProfile(bool collective, int cb_nodes, int striping_factor, int striping_unit, hsize_t alignment,
+                         hsize_t alignment_threshold)
+      : collective(collective),
+        cb_nodes(cb_nodes),
+        striping_factor(striping_factor),
+        striping_unit(striping_unit),
+        alignment(alignment),
+        alignment_threshold(alignment_threshold)
+    {}
+
+    MPI_Info IOProfile::info() const {
+        if (this->cb_nodes <= 0 && this->striping_factor <= 0 && this->striping_unit <= 0 && !this->collective) {
+            return MPI_INFO_NULL;
+        }
+
+        MPI_Info info;
+        MPI_Info_create(&info);
+        if (this->collective) {
+            MPI_Info_set(info, "romio_cb_read", "enable");
+            MPI_Info_set(info, "romio_cb_write", "enable");
+        }
+        if (this->cb_nodes > 0) {
+            MPI_Info_set(info, "cb_nodes", std::to_string(this->cb_nodes).c_str());
+        }
+        if (this->striping_factor > 0) {
+            MPI_Info_set(info, "striping_factor", std::to_string(this->striping_factor).c_str());
+        }
+        if (this->striping_unit > 0) {
+            MPI_Info_set(info, "striping_unit", std::to_string(this->striping_unit).c_str());
+        }
+        return info;
+    }
+
+    hid_t IOProfile::file_access_list(MPI_Comm comm) const {
+        hid_t access_plist = H5Pcreate(H5P_FILE_ACCESS);
+        if (access_plist < 0)
+            throw std::runtime_error("Could not create file access property list");
+
+        // hints are duplicated by HDF5 and can be released right away
+        MPI_Info info = this->info();
+        H5Pset_fapl_mpio(access_plist, comm, info);
+        if (info != MPI_INFO_NULL)
+            MPI_Info_free(&info);
+
+        if (this->alignment > 1)
+            H5Pset_alignment(access_plist, this->alignment_threshold, this->alignment);
+        return access_plist;
+    }
+
+    hid_t IOProfile::transfer_list() const {
+        hid_t transfer_plist = H5Pcreate(H5P_DATASET_XFER);
+        if (transfer_plist < 0)
+            throw std::runtime_error("Could not create dataset transfer property list");
+        H5Pset_dxpl_mpio(transfer_plist, this->collective ? H5FD_MPIO_COLLECTIVE : H5FD_MPIO_INDEPENDENT);
+        return transfer_plist;
+    }
+}  // juml
@@ -0,0 +1,399 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: NumpyDataset.cpp
+*
+* Description: Implementation of class NumpyDataset
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+#include "data/NumpyDataset.h"
+
+namespace juml {
+    /**
+     * read_fully
+     *
+     * Positioned read that retries on partial reads and interrupts.
+     */
+    static bool read_fully(int fd, uint8_t* buffer, size_t bytes, off_t offset) {
+        while (bytes > 0) {
+            const ssize_t got = pread(fd, buffer, bytes, offset);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            buffer += got;
+            bytes -= static_cast<size_t>(got);
+            offset += static_cast<off_t>(got);
+        }
+        return true;
+    }
+
+    /**
+     * read_strided
+     *
+     * Reads count elements of element_bytes each that are stride elements apart in the file. Short gaps are read
+     * along in a single request and compacted afterwards, wide ones element by element.
+     */
+    static bool read_strided(int fd, uint8_t* buffer, size_t element_bytes, hsize_t count, hsize_t stride,
+                             off_t offset) {
+        if (count == 0) return true;
+        if (stride == 1) return read_fully(fd, buffer, count * element_bytes, offset);
+
+        const size_t gap = static_cast<size_t>(stride) * element_bytes;
+        if (gap > (1 << 16)) {
+            for (hsize_t i = 0; i < count; ++i) {
+                if (!read_fully(fd, buffer + i * element_bytes, element_bytes, offset + i * gap)) return false;
+            }
+            return true;
+        }
+        std::vector<uint8_t> span((count - 1) * gap + element_bytes);
+        if (!read_fully(fd, span.data(), span.size(), offset)) return false;
+        for (hsize_t i = 0; i < count; ++i) {
+            std::memcpy(buffer + i * element_bytes, span.data() + i * gap, element_bytes);
+        }
+        return true;
+    }
+
+    /**
+     * dictionary_value
+     *
+     * @returns The position of the value of a key in the Python dictionary literal of a .npy header
+     */
+    static size_t dictionary_value(const std::string& header, const std::string& key) {
+        size_t position = header.find("'" + key + "'");
+        if (position == std::string::npos) position = header.find("\"" + key + "\"");
+        if (position == std::string::npos) return std::string::npos;
+        position = header.find(':', position + key.size() + 2);
+        if (position == std::string::npos) return std::string::npos;
+        return header.find_first_not_of(" \t", position + 1);
+    }
+
+    NumpyDataset::NumpyDataset(const std::string& filename, const MPI_Comm comm)
+        : Dataset(filename, std::string(), comm) {}
+
+    NumpyDataset::NumpyDataset(const std::string& filename, const std::vector<hsize_t>& shape, af::dtype type,
+                               bool fortran_order, size_t offset, const MPI_Comm comm)
+        : Dataset(filename, std::string(), comm),
+          shape_(shape),
+          type_(type),
+          type_size_(NumpyDataset::type_size(type)),
+          fortran_order_(fortran_order),
+          data_offset_(offset),
+          raw_(true) {
+        if (shape.empty() || shape.size() > 4) {
+            std::stringstream error;
+            error << "Got " << shape.size() << " axes for raw file " << filename << ". Expected 1 to 4.";
+            throw std::domain_error(error.str().c_str());
+        }
+    }
+
+    void NumpyDataset::read_header() {
+        const int fd = open(this->filename_.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::stringstream error;
+            error << "Could not open file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // magic string, version and the little-endian header length, two bytes for 1.0 and four bytes otherwise
+        uint8_t prefix[12];
+        std::string header;
+        bool valid = read_fully(fd, prefix, sizeof(prefix), 0) && std::memcmp(prefix, "\x93NUMPY", 6) == 0;
+        const unsigned int major = prefix[6];
+        if (valid && major >= 1 && major <= 3) {
+            size_t length = prefix[8] | prefix[9] << 8;
+            size_t begin = 10;
+            if (major > 1) {
+                length |= static_cast<size_t>(prefix[10]) << 16 | static_cast<size_t>(prefix[11]) << 24;
+                begin = 12;
+            }
+            header.resize(length);
+            valid = read_fully(fd, reinterpret_cast<uint8_t*>(&header[0]), length, static_cast<off_t>(begin));
+            this->data_offset_ = begin + length;
+        }
+        close(fd);
+        if (!valid) {
+            std::stringstream error;
+            error << "File " << this->filename_ << " is not a NumPy .npy file";
+            throw std::runtime_error(error.str().c_str());
+        }
+        if (major < 1 || major > 3) {
+            std::stringstream error;
+            error << "Unsupported .npy format version " << major << " of file " << this->filename_;
+            throw std::domain_error(error.str().c_str());
+        }
+
+        // element type, e.g. '<f4', structured types are not supported
+        size_t position = dictionary_value(header, "descr");
+        const char quote = position == std::string::npos ? '\0' : header[position];
+        const size_t end = quote == '\'' || quote == '"' ? header.find(quote, position + 1) : std::string::npos;
+        std::string descr;
+        if (end != std::string::npos) {
+            descr = header.substr(position + 1, end - position - 1);
+        }
+        const uint16_t probe = 1;
+        const bool little_endian = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+        const std::string kind = descr.size() > 1 ? descr.substr(1) : std::string();
+        const char order = descr.empty() ? '\0' : descr[0];
+        bool native = order == '|' || order == '=' || (order == '<' && little_endian)
+                      || (order == '>' && !little_endian);
+
+        if      (kind == "b1")  this->type_ = b8;
+        else if (kind == "u1")  this->type_ = u8;
+        else if (kind == "i2")  this->type_ = s16;
+        else if (kind == "u2")  this->type_ = u16;
+        else if (kind == "i4")  this->type_ = s32;
+        else if (kind == "u4")  this->type_ = u32;
+        else if (kind == "i8")  this->type_ = s64;
+        else if (kind == "u8")  this->type_ = u64;
+        else if (kind == "f2")  this->type_ = f16;
+        else if (kind == "f4")  this->type_ = f32;
+        else if (kind == "f8")  this->type_ = f64;
+        else if (kind == "c8")  this->type_ = c32;
+        else if (kind == "c16") this->type_ = c64;
+        else native = false;
+        if (!native) {
+            std::stringstream error;
+            error << "Unsupported element type '" << descr << "' in file " << this->filename_;
+            throw std::domain_error(error.str().c_str());
+        }
+        this->type_size_ = NumpyDataset::type_size(this->type_);
+
+        // storage order
+        position = dictionary_value(header, "fortran_order");
+        this->fortran_order_ = position != std::string::npos && header.compare(position, 4, "True") == 0;
+
+        // shape tuple, e.g. (100, 3) or (100,)
+        position = dictionary_value(header, "shape");
+        const size_t close_position = position == std::string::npos ? position : header.find(')', position);
+        if (close_position == std::string::npos || header[position] != '(') {
+            std::stringstream error;
+            error << "Missing shape in the header of file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+        this->shape_.clear();
+        const char* cursor = header.c_str() + position + 1;
+        const char* last = header.c_str() + close_position;
+        while (cursor < last) {
+            char* next;
+            const unsigned long long extent = std::strtoull(cursor, &next, 10);
+            if (next == cursor) {
+                ++cursor;
+                continue;
+            }
+            this->shape_.push_back(static_cast<hsize_t>(extent));
+            cursor = next;
+        }
+        if (this->shape_.empty() || this->shape_.size() > 4) {
+            std::stringstream error;
+            error << "Got " << this->shape_.size() << " axes in file " << this->filename_ << ". Expected 1 to 4.";
+            throw std::domain_error(error.str().c_str());
+        }
+    }
+
+    af::dim4 NumpyDataset::array_dims(hsize_t count) const {
+        // swap the row and column dimensions (NumPy row-major, AF column-major)
+        const size_t n_dims = this->shape_.size();
+        if (n_dims == 1) {
+            return af::dim4(1, static_cast<dim_t>(count));
+        }
+        af::dim4 dims(1, 1, 1, 1);
+        for (size_t i = 1; i < n_dims; ++i) {
+            dims[n_dims - 1 - i] = static_cast<dim_t>(this->shape_[i]);
+        }
+        if (!this->features_.empty()) {
+            dims[0] = static_cast<dim_t>(this->features_.size());
+        }
+        dims[n_dims - 1] = static_cast<dim_t>(count);
+        return dims;
+    }
+
+    bool NumpyDataset::read_rows(int fd, hsize_t position, hsize_t count, uint8_t* buffer) const {
+        hsize_t columns = 1;
+        for (size_t i = 1; i < this->shape_.size(); ++i) {
+            columns *= this->shape_[i];
+        }
+        const hsize_t first = this->sample_begin_ + position * this->sample_stride_;
+
+        // C order, each sample is a consecutive row
+        if (!this->fortran_order_ || this->shape_.size() == 1) {
+            const size_t row_bytes = columns * this->type_size_;
+            const off_t offset = static_cast<off_t>(this->data_offset_ + first * row_bytes);
+            return read_strided(fd, buffer, row_bytes, count, this->sample_stride_, offset);
+        }
+
+        // Fortran order, the local rows of each column are consecutive
+        for (hsize_t column = 0; column < columns; ++column) {
+            const off_t offset = static_cast<off_t>(this->data_offset_
+                                                    + (column * this->shape_[0] + first) * this->type_size_);
+            uint8_t* destination = buffer + column * count * this->type_size_;
+            if (!read_strided(fd, destination, this->type_size_, count, this->sample_stride_, offset)) return false;
+        }
+        return true;
+    }
+
+    bool NumpyDataset::map_rows(hsize_t position, hsize_t count) {
+        if (count == 0 || (this->fortran_order_ && this->shape_.size() > 1)) return false;
+        if (!this->features_.empty() || this->sample_stride_ != 1) return false;
+        if (this->convert_ && this->target_type_ != this->type_) return false;
+        if (this->half_precision_ && this->type_ != f16) return false;
+
+        size_t row_bytes = this->type_size_;
+        for (size_t i = 1; i < this->shape_.size(); ++i) {
+            row_bytes *= this->shape_[i];
+        }
+        const off_t begin = static_cast<off_t>(this->data_offset_ + (this->sample_begin_ + position) * row_bytes);
+        return this->map_file(this->filename_, begin, this->array_dims(count), this->type_, count * row_bytes);
+    }
+
+    void NumpyDataset::load_chunks(const std::vector<double>& weights, bool force) {
+        if (this->filename_.empty()) {
+            return ;
+        }
+        this->check_sample_partitioning("Loading a NumPy file");
+        time_t mod_time = this->modified_time();
+        if (!force && mod_time <= this->loading_time_ && weights == this->weights_) {
+            return ;
+        }
+        if (this->is_streamed()) {
+            throw std::domain_error("Out-of-core processing requires an HDF5 dataset");
+        }
+        this->loading_time_ = mod_time;
+        this->scale_ = af::array();
+        this->offset_ = af::array();
+        if (!this->raw_) {
+            this->read_header();
+        }
+
+        // a feature projection selects columns of two-dimensional arrays
+        const size_t n_dims = this->shape_.size();
+        if (!this->features_.empty()) {
+            if (n_dims != 2) {
+                std::stringstream error;
+                error << "Feature projection requires a two-dimensional array, " << this->filename_ << " has "
+                      << n_dims;
+                throw std::domain_error(error.str().c_str());
+            }
+            if (this->features_.back() >= this->shape_[1]) {
+                std::stringstream error;
+                error << "Feature " << this->features_.back() << " exceeds the " << this->shape_[1]
+                      << " features of " << this->filename_;
+                throw std::domain_error(error.str().c_str());
+            }
+        }
+
+        // partition the selected samples exactly like the HDF5 datasets
+        const hsize_t n_samples = this->selected_samples(this->shape_[0]);
+        hsize_t position;
+        hsize_t count;
+        this->partition(n_samples, weights, position, count);
+        this->weights_ = weights;
+        this->global_n_samples_ = static_cast<dim_t>(n_samples);
+        this->global_offset_ = static_cast<dim_t>(position);
+        this->sample_dim_ = n_dims > 2 ? static_cast<dim_t>(n_dims) - 1 : 1;
+        this->local_dims_ = this->array_dims(count);
+
+        // release a previous mapping before the data is replaced
+        this->data_ = af::array();
+        this->mapped_ = af::array();
+        this->mapping_.reset();
+        if (count == 0) {
+            return;
+        }
+
+        // zero-copy path, map the samples directly from the file
+        if (this->memory_map_ && this->map_rows(position, count)) {
+            return;
+        }
+
+        // the samples in file order, Fortran-ordered arrays hold the sample index first
+        af::dim4 file_dims(1, 1, 1, 1);
+        if (n_dims == 1) {
+            file_dims = af::dim4(1, static_cast<dim_t>(count));
+        } else {
+            for (size_t i = 0; i < n_dims; ++i) {
+                const dim_t extent = i == 0 ? static_cast<dim_t>(count) : static_cast<dim_t>(this->shape_[i]);
+                file_dims[this->fortran_order_ ? i : n_dims - 1 - i] = extent;
+            }
+        }
+        af::array data(file_dims, this->type_);
+
+        const int fd = open(this->filename_.c_str(), O_RDONLY);
+        bool status = fd >= 0;
+        if (status && af::getBackendId(af::constant(0, 1)) == AF_BACKEND_CPU) {
+            status = this->read_rows(fd, position, count, data.device<uint8_t>());
+            data.unlock();
+        } else if (status) {
+            std::vector<uint8_t> buffer(data.bytes());
+            status = this->read_rows(fd, position, count, buffer.data());
+            if (status) data.write(buffer.data(), data.bytes(), afHost);
+        }
+        if (fd >= 0) close(fd);
+        if (!status) {
+            std::stringstream error;
+            error << "Could not read samples " << position << " to " << position + count << " of file "
+                  << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // a single reorder brings Fortran-ordered samples into the features x samples layout
+        if (this->fortran_order_ && n_dims > 1) {
+            if (n_dims == 2)      data = af::reorder(data, 1, 0);
+            else if (n_dims == 3) data = af::reorder(data, 2, 1, 0);
+            else                  data = af::reorder(data, 3, 2, 1, 0);
+        }
+        if (!this->features_.empty()) {
+            std::vector<int> features(this->features_.begin(), this->features_.end());
+            data = data(af::array(static_cast<dim_t>(features.size()), features.data()), af::span);
+        }
+        if (this->convert_ && this->target_type_ != this->type_) {
+            data = data.as(this->target_type_);
+        }
+        this->data_ = this->compact(data);
+    }
+
+    const std::vector<hsize_t>& NumpyDataset::shape() const {
+        return this->shape_;
+    }
+
+    bool NumpyDataset::fortran_order() const {
+        return this->fortran_order_;
+    }
+
+    size_t NumpyDataset::type_size(af::dtype type) {
+        switch (type) {
+            case b8:
+            case u8:  return 1;
+            case s16:
+            case u16:
+            case f16: return 2;
+            case f32:
+            case s32:
+            case u32: return 4;
+            case f64:
+            case s64:
+            case u64:
+            case c32: return 8;
+            case c64: return 16;
+            default: {
+                std::stringstream error;
+                error << "Unsupported arrayfire type " << type;
+                throw std::domain_error(error.str().c_str());
+            }
+        }
+    }
+} // namespace juml
@@ -0,0 +1,435 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: ShardedDataset.cpp
+*
+* Description: Implementation of class ShardedDataset
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <glob.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+#include "data/ShardedDataset.h"
+
+namespace juml {
+    /**
+     * VirtualName
+     *
+     * The signature of the HDF5 functions querying the source file and dataset names of a virtual dataset mapping.
+     */
+    typedef ssize_t (*VirtualName)(hid_t, size_t, char*, size_t);
+
+    /**
+     * virtual_name
+     *
+     * @param getter - H5Pget_virtual_filename or H5Pget_virtual_dsetname
+     * @param plist  - The dataset creation property list of the virtual dataset
+     * @param index  - The index of the mapping
+     * @returns The queried name, empty if it is not available
+     */
+    static std::string virtual_name(VirtualName getter, hid_t plist, size_t index) {
+        const ssize_t length = getter(plist, index, NULL, 0);
+        if (length <= 0) return std::string();
+        std::vector<char> name(static_cast<size_t>(length) + 1);
+        getter(plist, index, name.data(), name.size());
+        return std::string(name.data(), static_cast<size_t>(length));
+    }
+
+    ShardedDataset::ShardedDataset(const std::vector<std::string>& patterns, const std::string& dataset,
+                                   const MPI_Comm comm)
+        : Dataset(patterns.empty() ? std::string() : patterns.front(), dataset, comm), patterns_(patterns) {
+        if (patterns.empty()) {
+            throw std::invalid_argument("At least one shard file name or pattern is required");
+        }
+    }
+
+    hid_t ShardedDataset::open_shard(const Shard& shard, hid_t& file_id) const {
+        // the default access list opens the file with the process-local POSIX driver, i.e. without MPI-IO
+        file_id = H5Fopen(shard.filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        if (file_id < 0) {
+            std::stringstream error;
+            error << "Could not open file " << shard.filename;
+            throw std::runtime_error(error.str().c_str());
+        }
+        const hid_t data_id = H5Dopen(file_id, shard.dataset.c_str(), H5P_DEFAULT);
+        if (data_id < 0) {
+            H5Fclose(file_id);
+            std::stringstream error;
+            error << "Could not open dataset " << shard.dataset << " in file " << shard.filename;
+            throw std::runtime_error(error.str().c_str());
+        }
+        return data_id;
+    }
+
+    void ShardedDataset::add_shards(const std::string& filename, std::vector<Shard>& shards) const {
+        const Shard file_shard{filename, this->dataset_, 0, 0};
+        hid_t file_id;
+        const hid_t data_id = this->open_shard(file_shard, file_id);
+        const hid_t create_plist = H5Dget_create_plist(data_id);
+        const hid_t space_id = H5Dget_space(data_id);
+        const int n_dims = space_id >= 0 ? H5Sget_simple_extent_ndims(space_id) : -1;
+        std::vector<hsize_t> dimensions(static_cast<size_t>(std::max(n_dims, 1)), 0);
+        if (n_dims > 0) H5Sget_simple_extent_dims(space_id, dimensions.data(), NULL);
+        if (space_id >= 0) H5Sclose(space_id);
+
+        // the sources of a virtual dataset are read directly if they are whole datasets stacked into row bands
+        std::vector<std::pair<hsize_t, Shard> > sources;
+        size_t n_mappings = 0;
+        bool direct = create_plist >= 0 && n_dims > 0 && H5Pget_layout(create_plist) == H5D_VIRTUAL
+                   && H5Pget_virtual_count(create_plist, &n_mappings) >= 0 && n_mappings > 0;
+        for (size_t i = 0; i < n_mappings && direct; ++i) {
+            const hid_t source_space = H5Pget_virtual_srcspace(create_plist, i);
+            const hid_t virtual_space = H5Pget_virtual_vspace(create_plist, i);
+            std::vector<hsize_t> start(dimensions.size()), end(dimensions.size());
+            direct = source_space >= 0 && virtual_space >= 0 && H5Sget_select_type(source_space) == H5S_SEL_ALL
+                  && H5Sget_select_bounds(virtual_space, start.data(), end.data()) >= 0;
+            hsize_t n_points = 1;
+            for (int d = 0; d < n_dims && direct; ++d) {
+                n_points *= end[d] - start[d] + 1;
+                direct = d == 0 || (start[d] == 0 && end[d] + 1 == dimensions[d]);
+            }
+            direct = direct && H5Sget_select_npoints(virtual_space) == static_cast<hssize_t>(n_points);
+            if (source_space >= 0) H5Sclose(source_space);
+            if (virtual_space >= 0) H5Sclose(virtual_space);
+            if (!direct) break;
+
+            // "." denotes the virtual dataset's own file, relative names are looked up next to it first
+            std::string source_file = virtual_name(H5Pget_virtual_filename, create_plist, i);
+            const std::string source_dataset = virtual_name(H5Pget_virtual_dsetname, create_plist, i);
+            const size_t separator = filename.rfind('/');
+            struct stat info;
+            if (source_file == ".") {
+                source_file = filename;
+            } else if (!source_file.empty() && source_file[0] != '/' && separator != std::string::npos) {
+                const std::string sibling = filename.substr(0, separator + 1) + source_file;
+                if (stat(sibling.c_str(), &info) == 0) source_file = sibling;
+            }
+            const Shard source{source_file, source_dataset, 0, end[0] - start[0] + 1};
+
+            // the extent of a source is only stored once it is opened, it has to fill its band exactly
+            std::vector<hsize_t> source_dimensions(dimensions.size(), 0);
+            try {
+                hid_t source_file_id;
+                const hid_t source_id = this->open_shard(source, source_file_id);
+                const hid_t source_space_id = H5Dget_space(source_id);
+                direct = H5Sget_simple_extent_ndims(source_space_id) == n_dims
+                      && H5Sget_simple_extent_dims(source_space_id, source_dimensions.data(), NULL) >= 0;
+                if (source_space_id >= 0) H5Sclose(source_space_id);
+                H5Dclose(source_id);
+                H5Fclose(source_file_id);
+            } catch (const std::runtime_error&) {
+                direct = false;
+            }
+            for (int d = 0; d < n_dims && direct; ++d) {
+                direct = source_dimensions[d] == (d == 0 ? source.n_samples : dimensions[d]);
+            }
+            sources.push_back(std::make_pair(start[0], source));
+        }
+        if (create_plist >= 0) H5Pclose(create_plist);
+        H5Dclose(data_id);
+        H5Fclose(file_id);
+
+        // the row bands have to tile the virtual dataset without gaps, which would be filled with the fill value
+        std::sort(sources.begin(), sources.end(),
+                  [](const std::pair<hsize_t, Shard>& a, const std::pair<hsize_t, Shard>& b) {
+                      return a.first < b.first;
+                  });
+        hsize_t next = 0;
+        for (size_t i = 0; i < sources.size() && direct; ++i) {
+            direct = sources[i].first == next;
+            next += sources[i].second.n_samples;
+        }
+        if (!direct || next != dimensions[0]) {
+            shards.push_back(file_shard);
+            return;
+        }
+        for (const std::pair<hsize_t, Shard>& source : sources) {
+            shards.push_back(source.second);
+        }
+    }
+
+    std::vector<ShardedDataset::Shard> ShardedDataset::expand_shards() const {
+        // rank zero lists the shards as null-separated file name, dataset name and timestamp triples
+        std::string listing;
+        long long status = 0;
+        if (this->mpi_rank_ == 0) {
+            try {
+                std::vector<Shard> shards;
+                for (const std::string& pattern : this->patterns_) {
+                    glob_t matches;
+                    const int result = glob(pattern.c_str(), 0, NULL, &matches);
+                    if (result != 0) {
+                        globfree(&matches);
+                        std::stringstream error;
+                        error << (result == GLOB_NOMATCH ? "No file matches " : "Could not expand ") << pattern;
+                        throw std::runtime_error(error.str().c_str());
+                    }
+                    const std::vector<std::string> paths(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+                    globfree(&matches);
+                    for (const std::string& path : paths) {
+                        this->add_shards(path, shards);
+                    }
+                }
+
+                std::stringstream stream;
+                for (const Shard& shard : shards) {
+                    struct stat info;
+                    if (stat(shard.filename.c_str(), &info) != 0) {
+                        std::stringstream error;
+                        error << "Could not open file " << shard.filename;
+                        throw std::runtime_error(error.str().c_str());
+                    }
+                    stream << shard.filename << '\0' << shard.dataset << '\0' << info.st_mtim.tv_sec << '\0';
+                }
+                listing = stream.str();
+            } catch (const std::exception& e) {
+                status = 1;
+                listing = e.what();
+            }
+        }
+
+        // a failure on rank zero is raised on all nodes
+        long long header[2] = {status, static_cast<long long>(listing.size())};
+        MPI_Bcast(header, 2, MPI_LONG_LONG, 0, this->comm_);
+        listing.resize(static_cast<size_t>(header[1]));
+        MPI_Bcast(&listing[0], static_cast<int>(header[1]), MPI_CHAR, 0, this->comm_);
+        if (header[0] != 0) {
+            throw std::runtime_error(listing.c_str());
+        }
+
+        std::vector<Shard> shards;
+        size_t position = 0;
+        while (position < listing.size()) {
+            std::string fields[3];
+            for (int i = 0; i < 3; ++i) {
+                const size_t end = listing.find('\0', position);
+                fields[i] = listing.substr(position, end - position);
+                position = end + 1;
+            }
+            shards.push_back(Shard{fields[0], fields[1], static_cast<time_t>(std::atoll(fields[2].c_str())), 0});
+        }
+        return shards;
+    }
+
+    void ShardedDataset::count_samples(std::vector<Shard>& shards) const {
+        // per shard the row count, the number of dimensions, the further extents and the sample type, the values of
+        // every shard are set by a single node and combined by taking the maximum, the last entry flags failures
+        const size_t n_values = 6;
+        std::vector<long long> info(n_values * shards.size() + 1, -1);
+        std::string message;
+        try {
+            for (size_t i = static_cast<size_t>(this->mpi_rank_); i < shards.size(); i += this->mpi_size_) {
+                hid_t file_id;
+                const hid_t data_id = this->open_shard(shards[i], file_id);
+                const hid_t space_id = H5Dget_space(data_id);
+                const int n_dims = space_id >= 0 ? H5Sget_simple_extent_ndims(space_id) : -1;
+                hsize_t dimensions[4] = {0, 0, 0, 0};
+                if (n_dims >= 1 && n_dims <= 4) H5Sget_simple_extent_dims(space_id, dimensions, NULL);
+                if (space_id >= 0) H5Sclose(space_id);
+
+                long long* values = &info[n_values * i];
+                try {
+                    if (n_dims < 1 || n_dims > 4) {
+                        std::stringstream error;
+                        error << "Got " << n_dims << " dimensions in dataset " << shards[i].dataset << " in file "
+                              << shards[i].filename << ". Expected 1 to 4.";
+                        throw std::domain_error(error.str().c_str());
+                    }
+                    values[5] = static_cast<long long>(this->sample_type(data_id));
+                } catch (...) {
+                    H5Dclose(data_id);
+                    H5Fclose(file_id);
+                    throw;
+                }
+                H5Dclose(data_id);
+                H5Fclose(file_id);
+
+                values[0] = static_cast<long long>(dimensions[0]);
+                values[1] = n_dims;
+                for (int d = 1; d < 4; ++d) {
+                    values[1 + d] = static_cast<long long>(dimensions[d]);
+                }
+            }
+        } catch (const std::exception& e) {
+            message = e.what();
+            info.back() = 1;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, info.data(), static_cast<int>(info.size()), MPI_LONG_LONG, MPI_MAX, this->comm_);
+        if (info.back() > 0) {
+            throw std::runtime_error(message.empty() ? "Could not query the shards on another node" : message.c_str());
+        }
+
+        // the shards differ in their number of samples only
+        for (size_t i = 0; i < shards.size(); ++i) {
+            for (size_t v = 1; v < n_values; ++v) {
+                if (info[n_values * i + v] != info[v]) {
+                    std::stringstream error;
+                    error << "The samples of dataset " << shards[i].dataset << " in file " << shards[i].filename
+                          << " differ in shape or type from those of dataset " << shards[0].dataset << " in file "
+                          << shards[0].filename;
+                    throw std::domain_error(error.str().c_str());
+                }
+            }
+            shards[i].n_samples = static_cast<hsize_t>(info[n_values * i]);
+        }
+    }
+
+    void ShardedDataset::load_chunks(const std::vector<double>& weights, bool force) {
+        this->check_sample_partitioning("Loading a sharded dataset");
+        if (this->is_streamed()) {
+            throw std::domain_error("Out-of-core processing requires a single HDF5 dataset");
+        }
+        if (this->sample_begin_ != 0 || this->sample_end_ != 0 || this->sample_stride_ != 1) {
+            throw std::domain_error("Sample ranges are not supported across shards");
+        }
+
+        // the shards are expanded anew, so that added, removed and modified shards trigger a reload
+        std::vector<Shard> shards = this->expand_shards();
+        time_t mod_time = 0;
+        bool unchanged = shards.size() == this->shards_.size();
+        for (size_t i = 0; i < shards.size(); ++i) {
+            mod_time = std::max(mod_time, shards[i].modified_time);
+            unchanged = unchanged && shards[i].filename == this->shards_[i].filename
+                                  && shards[i].dataset == this->shards_[i].dataset;
+        }
+        if (!force && unchanged && mod_time <= this->loading_time_ && weights == this->weights_) {
+            return ;
+        }
+        this->loading_time_ = mod_time;
+        this->scale_ = af::array();
+        this->offset_ = af::array();
+        this->count_samples(shards);
+
+        // the global index of the first sample of each shard
+        std::vector<hsize_t> starts(shards.size() + 1, 0);
+        for (size_t i = 0; i < shards.size(); ++i) {
+            starts[i + 1] = starts[i] + shards[i].n_samples;
+        }
+        const hsize_t n_samples = starts.back();
+
+        // whole shards are assigned to the node whose portion holds their middle sample, if there are enough
+        hsize_t position;
+        hsize_t count;
+        this->partition(n_samples, weights, position, count);
+        if (shards.size() >= static_cast<size_t>(this->mpi_size_)) {
+            hsize_t begin = 0;
+            hsize_t end = 0;
+            for (size_t i = 0; i < shards.size(); ++i) {
+                const hsize_t middle = starts[i] + shards[i].n_samples / 2;
+                if (middle < position) begin = starts[i + 1];
+                if (middle < position + count) end = starts[i + 1];
+            }
+            position = begin;
+            count = end - begin;
+        }
+        this->weights_ = weights;
+        this->shards_ = shards;
+        this->global_n_samples_ = static_cast<dim_t>(n_samples);
+        this->global_offset_ = static_cast<dim_t>(position);
+
+        // release a previous mapping before the data is replaced
+        this->data_ = af::array();
+        this->mapped_ = af::array();
+        this->mapping_.reset();
+
+        // the local shape and type are taken from the first local shard, idle nodes use the last one
+        size_t first = 0;
+        while (first + 1 < shards.size() && starts[first + 1] <= position) ++first;
+        hid_t file_id;
+        hid_t data_id = this->open_shard(shards[first], file_id);
+        af::dtype type;
+        try {
+            this->sample_extent(data_id);
+            this->local_dims_ = this->sample_dims(data_id, count);
+            type = this->sample_type(data_id);
+        } catch (...) {
+            H5Dclose(data_id);
+            H5Fclose(file_id);
+            throw;
+        }
+        H5Dclose(data_id);
+        H5Fclose(file_id);
+        if (count == 0) {
+            return;
+        }
+
+        // the samples of each overlapping shard are read into their place, every node reading its own files
+        af::array data(this->local_dims_, type);
+        const size_t sample_bytes = data.bytes() / count;
+        const bool on_cpu = af::getBackendId(af::constant(0, 1)) == AF_BACKEND_CPU;
+        std::vector<uint8_t> host;
+        uint8_t* buffer;
+        if (on_cpu) {
+            buffer = data.device<uint8_t>();
+        } else {
+            host.resize(data.bytes());
+            buffer = host.data();
+        }
+
+        herr_t status = 0;
+        size_t failed = first;
+        for (size_t i = first; i < shards.size() && starts[i] < position + count && status >= 0; ++i) {
+            const hsize_t begin = std::max(starts[i], position);
+            const hsize_t end = std::min(starts[i + 1], position + count);
+            if (begin >= end) continue;
+            try {
+                data_id = this->open_shard(shards[i], file_id);
+            } catch (...) {
+                if (on_cpu) data.unlock();
+                throw;
+            }
+            status = this->read_samples(data_id, begin - starts[i], end - begin,
+                                        buffer + (begin - position) * sample_bytes);
+            H5Dclose(data_id);
+            H5Fclose(file_id);
+            failed = i;
+        }
+        if (on_cpu) {
+            data.unlock();
+        } else if (status >= 0) {
+            af_write_array(data.get(), host.data(), data.bytes(), afHost);
+        }
+        if (status < 0) {
+            std::stringstream error;
+            error << "Could not read hyperslab of dataset " << shards[failed].dataset << " in file "
+                  << shards[failed].filename;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // narrow to the storage precision, the read buffer is released right away
+        this->data_ = this->compact(data);
+    }
+
+    void ShardedDataset::load_incremental(bool) {
+        this->load_chunks(this->weights_, false);
+    }
+
+    time_t ShardedDataset::modified_time() const {
+        time_t mod_time = 0;
+        for (const Shard& shard : this->expand_shards()) {
+            mod_time = std::max(mod_time, shard.modified_time);
+        }
+        return mod_time;
+    }
+
+    const std::vector<std::string>& ShardedDataset::patterns() const {
+        return this->patterns_;
+    }
+
+    const std::vector<ShardedDataset::Shard>& ShardedDataset::shards() const {
+        return this->shards_;
+    }
+} // namespace juml
@@ -0,0 +1,224 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: SparseDataset.cpp
+*
+* Description: Implementation of class SparseDataset
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "data/SparseDataset.h"
+
+namespace juml {
+    SparseDataset::SparseDataset(const std::string& filename, const std::string& group, const MPI_Comm comm)
+        : Dataset(filename, group, comm) {
+        this->sample_dim_ = 0;
+    }
+
+    SparseDataset::SparseDataset(const af::array& data, MPI_Comm comm)
+        : Dataset(std::string(), std::string(), comm) {
+        if (!data.isempty() && (!data.issparse() || af::sparseGetStorage(data) != AF_STORAGE_CSR)) {
+            throw std::invalid_argument("The data of a sparse dataset must be a CSR sparse array");
+        }
+        this->data_ = data;
+        this->sample_dim_ = 0;
+
+        this->n_features_ = data.isempty() ? 0 : data.dims(1);
+        MPI_Allreduce(MPI_IN_PLACE, &this->n_features_, 1, MPI_LONG_LONG, MPI_MAX, comm);
+
+        // the global sample count and offset are exchanged on demand
+        this->global_n_samples_ = 0;
+        this->global_offset_ = 0;
+        this->metadata_pending_ = true;
+    }
+
+    af::array SparseDataset::read_range(hid_t group_id, const std::string& name, hsize_t offset, hsize_t count,
+                                        af::dtype type) const {
+        const hid_t data_id = H5Dopen(group_id, name.c_str(), H5P_DEFAULT);
+        if (data_id < 0) {
+            std::stringstream error;
+            error << "Could not open dataset " << name << " of group " << this->dataset_ << " in file "
+                  << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        // all nodes take part in the read, as the transfer may be collective
+        const hid_t file_space = H5Dget_space(data_id);
+        const hid_t mem_space = H5Screate_simple(1, &count, NULL);
+        if (count > 0) {
+            H5Sselect_hyperslab(file_space, H5S_SELECT_SET, &offset, NULL, &count, NULL);
+        } else {
+            H5Sselect_none(file_space);
+            H5Sselect_none(mem_space);
+        }
+        const hid_t transfer_plist = this->io_profile_.transfer_list();
+        af::array elements(static_cast<dim_t>(count), type);
+        std::vector<uint8_t> buffer(elements.bytes() + 1);
+        const herr_t status = H5Dread(data_id, this->af_to_h5(type), mem_space, file_space, transfer_plist,
+                                      buffer.data());
+
+        H5Pclose(transfer_plist);
+        H5Sclose(mem_space);
+        H5Sclose(file_space);
+        H5Dclose(data_id);
+        if (status < 0) {
+            std::stringstream error;
+            error << "Could not read dataset " << name << " of group " << this->dataset_ << " in file "
+                  << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        if (count == 0) return af::array();
+        elements.write(buffer.data(), elements.bytes(), afHost);
+        return elements;
+    }
+
+    af::dtype SparseDataset::value_type(hid_t group_id) const {
+        if (this->convert_ && (this->target_type_ == f32 || this->target_type_ == f64)) return this->target_type_;
+
+        const hid_t data_id = H5Dopen(group_id, "values", H5P_DEFAULT);
+        if (data_id < 0) return f32;
+        const hid_t data_type = H5Dget_type(data_id);
+        const bool is_double = H5Tget_class(data_type) == H5T_FLOAT && H5Tget_size(data_type) > 4;
+        H5Tclose(data_type);
+        H5Dclose(data_id);
+        return is_double ? f64 : f32;
+    }
+
+    void SparseDataset::load_equal_chunks(bool force) {
+        if (this->filename_.empty()) {
+            return ;
+        }
+        this->check_sample_partitioning("Loading a sparse dataset");
+        time_t mod_time = this->modified_time();
+        if (!force && mod_time <= this->loading_time_) {
+            return ;
+        }
+        this->loading_time_ = mod_time;
+
+        const hid_t file_id = this->open_file();
+        const hid_t group_id = H5Gopen(file_id, this->dataset_.c_str(), H5P_DEFAULT);
+        if (group_id < 0) {
+            H5Fclose(file_id);
+            std::stringstream error;
+            error << "Could not open group " << this->dataset_ << " in file " << this->filename_;
+            throw std::runtime_error(error.str().c_str());
+        }
+
+        try {
+            // the number of rows is determined by the row pointers, the columns by the optional shape attribute
+            const hid_t indptr_id = H5Dopen(group_id, "indptr", H5P_DEFAULT);
+            if (indptr_id < 0) {
+                std::stringstream error;
+                error << "Could not open dataset indptr of group " << this->dataset_ << " in file " << this->filename_;
+                throw std::runtime_error(error.str().c_str());
+            }
+            const hid_t indptr_space = H5Dget_space(indptr_id);
+            const hssize_t n_pointers = H5Sget_simple_extent_npoints(indptr_space);
+            H5Sclose(indptr_space);
+            H5Dclose(indptr_id);
+            if (n_pointers < 1) {
+                std::stringstream error;
+                error << "The row pointers of group " << this->dataset_ << " are empty";
+                throw std::domain_error(error.str().c_str());
+            }
+            const hsize_t n_rows = static_cast<hsize_t>(n_pointers - 1);
+
+            long long n_columns = -1;
+            if (H5Aexists(group_id, "shape") > 0) {
+                long long shape[2] = {0, 0};
+                const hid_t attribute_id = H5Aopen(group_id, "shape", H5P_DEFAULT);
+                const herr_t status = H5Aread(attribute_id, H5T_NATIVE_LLONG, shape);
+                H5Aclose(attribute_id);
+                if (status < 0 || static_cast<hsize_t>(shape[0]) != n_rows) {
+                    std::stringstream error;
+                    error << "The shape of group " << this->dataset_ << " does not match its " << n_rows << " rows";
+                    throw std::domain_error(error.str().c_str());
+                }
+                n_columns = shape[1];
+            }
+
+            // read the local row pointers and the non-zero entries they span
+            hsize_t position;
+            hsize_t count;
+            this->partition(n_rows, std::vector<double>(), position, count);
+            af::array pointers = this->read_range(group_id, "indptr", position, count + 1, s64);
+            const long long first = pointers(0).scalar<long long>();
+            const long long last = pointers(static_cast<int>(count)).scalar<long long>();
+
+            // agree on the consistency before the collective reads, so that all nodes throw together
+            int ascending = last >= first ? 1 : 0;
+            MPI_Allreduce(MPI_IN_PLACE, &ascending, 1, MPI_INT, MPI_MIN, this->comm_);
+            if (!ascending) {
+                std::stringstream error;
+                error << "The row pointers of group " << this->dataset_ << " are not ascending";
+                throw std::domain_error(error.str().c_str());
+            }
+            const hsize_t n_nonzero = static_cast<hsize_t>(last - first);
+            af::array indices = this->read_range(group_id, "indices", first, n_nonzero, s32);
+            af::array values = this->read_range(group_id, "values", first, n_nonzero, this->value_type(group_id));
+
+            if (n_columns < 0) {
+                n_columns = n_nonzero > 0 ? af::max<int>(indices) + 1 : 0;
+                MPI_Allreduce(MPI_IN_PLACE, &n_columns, 1, MPI_LONG_LONG, MPI_MAX, this->comm_);
+            }
+
+            this->n_features_ = static_cast<dim_t>(n_columns);
+            this->global_n_samples_ = static_cast<dim_t>(n_rows);
+            this->global_offset_ = static_cast<dim_t>(position);
+            this->weights_.clear();
+            if (count == 0) {
+                this->data_ = af::array();
+            } else if (n_nonzero == 0) {
+                this->data_ = SparseDataset::empty_rows(static_cast<dim_t>(count), this->n_features_,
+                                                        this->value_type(group_id));
+            } else {
+                af::array row_pointers = (pointers - first).as(s32);
+                this->data_ = af::sparse(count, this->n_features_, values, row_pointers, indices, AF_STORAGE_CSR);
+            }
+        } catch (...) {
+            H5Gclose(group_id);
+            H5Fclose(file_id);
+            throw;
+        }
+
+        H5Gclose(group_id);
+        H5Fclose(file_id);
+    }
+
+    dim_t SparseDataset::n_features() const {
+        return this->n_features_;
+    }
+
+    af::array SparseDataset::rows(const af::array& csr, dim_t begin, dim_t end) {
+        const af::array row_pointers = af::sparseGetRowIdx(csr);
+        const int first = row_pointers(begin).scalar<int>();
+        const int last = row_pointers(end + 1).scalar<int>();
+        const dim_t n_rows = end - begin + 1;
+        if (last == first) {
+            return SparseDataset::empty_rows(n_rows, csr.dims(1), csr.type());
+        }
+
+        const af::seq nonzero(first, last - 1);
+        af::array values = af::sparseGetValues(csr)(nonzero);
+        af::array columns = af::sparseGetColIdx(csr)(nonzero);
+        af::array pointers = row_pointers(af::seq(static_cast<double>(begin), static_cast<double>(end + 1))) - first;
+        return af::sparse(n_rows, csr.dims(1), values, pointers, columns, AF_STORAGE_CSR);
+    }
+
+    af::array SparseDataset::empty_rows(dim_t n_rows, dim_t n_columns, af::dtype type) {
+        // without non-zero entries all row pointers are zero, the values and column indices are empty
+        const af::array row_pointers = af::constant(0, n_rows + 1, s32);
+        return af::sparse(n_rows, n_columns, af::array(0, type), row_pointers, af::array(0, s32), AF_STORAGE_CSR);
+    }
+} // namespace juml
@@ -0,0 +1,76 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: MinMaxScaler.cpp
+*
+* Description: Implementation of class MinMaxScaler
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <stdexcept>
+
+#include "core/HDF5.h"
+#include "preprocessing/MinMaxScaler.h"
+
+namespace juml {
+    MinMaxScaler::MinMaxScaler(float min, float max, int backend, MPI_Comm comm)
+      : Scaler(backend, comm),
+        min_(min),
+        max_(max) {
+        if (max <= min)
+            throw std::invalid_argument("The upper boundary must be larger than the lower boundary");
+    }
+
+    void MinMaxScaler::fit(Dataset& X) {
+        Backend::set(this->backend_.get());
+        X.load_equal_chunks();
+
+        const Moments moments = X.moments();
+        this->data_min_ = af::flat(moments.minimum).as(f32);
+        this->data_max_ = af::flat(moments.maximum).as(f32);
+
+        // constant features keep a unit range, i.e. they are shifted onto the lower boundary
+        af::array range = this->data_max_ - this->data_min_;
+        range(range <= 0) = 1.0f;
+        this->scale_ = (this->max_ - this->min_) / range;
+        this->offset_ = this->min_ - this->data_min_ * this->scale_;
+    }
+
+    const af::array& MinMaxScaler::data_min() const {
+        return this->data_min_;
+    }
+
+    const af::array& MinMaxScaler::data_max() const {
+        return this->data_max_;
+    }
+
+    void MinMaxScaler::save(const std::string& filename, bool override) const {
+        Scaler::save(filename, override);
+        if (this->mpi_rank_ == 0) {
+            const float range[2] = {this->min_, this->max_};
+            hid_t file_id = juml::hdf5::open_file(filename);
+            juml::hdf5::write_array(file_id, "data_min", this->data_min_);
+            juml::hdf5::write_array(file_id, "data_max", this->data_max_);
+            juml::hdf5::write_array(file_id, "range", af::array(2, range));
+            juml::hdf5::close_file(file_id);
+        }
+        MPI_Barrier(this->comm_);
+    }
+
+    void MinMaxScaler::load(const std::string& filename) {
+        Scaler::load(filename);
+        hid_t file_id = juml::hdf5::popen_file(filename, this->comm_);
+        this->data_min_ = juml::hdf5::pread_array(file_id, "data_min", f32);
+        this->data_max_ = juml::hdf5::pread_array(file_id, "data_max", f32);
+        af::array range = juml::hdf5::pread_array(file_id, "range", f32);
+        juml::hdf5::close_file(file_id);
+        this->min_ = range(0).scalar<float>();
+        this->max_ = range(1).scalar<float>();
+    }
+} // namespace juml
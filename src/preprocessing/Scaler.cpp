@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: Scaler.cpp
+*
+* Description: Implementation of class Scaler
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <sstream>
+#include <stdexcept>
+
+#include "core/HDF5.h"
+#include "preprocessing/Scaler.h"
+
+namespace juml {
+    Scaler::Scaler(int backend, MPI_Comm comm)
+      : Algorithm(backend, comm) {}
+
+    void Scaler::check_fitted(dim_t n_features) const {
+        if (this->scale_.isempty()) {
+            throw std::runtime_error("The scaler has not been fitted");
+        }
+        if (n_features != this->scale_.elements()) {
+            std::stringstream error;
+            error << "The data has " << n_features << " features, the scaler has been fitted on "
+                  << this->scale_.elements();
+            throw std::invalid_argument(error.str().c_str());
+        }
+    }
+
+    void Scaler::transform(Dataset& X) const {
+        Backend::set(this->backend_.get());
+        X.load_equal_chunks();
+        this->check_fitted(X.n_features());
+        X.scale_features(this->scale_, this->offset_);
+    }
+
+    void Scaler::transform(af::array& data) const {
+        this->check_fitted(data.dims(0));
+        Dataset::scale_features(data, this->scale_, this->offset_);
+    }
+
+    void Scaler::fit_transform(Dataset& X) {
+        this->fit(X);
+        this->transform(X);
+    }
+
+    void Scaler::inverse_transform(Dataset& X) const {
+        Backend::set(this->backend_.get());
+        X.load_equal_chunks();
+        this->check_fitted(X.n_features());
+        X.scale_features(1.0f / this->scale_, -this->offset_ / this->scale_);
+    }
+
+    const af::array& Scaler::scale() const {
+        return this->scale_;
+    }
+
+    const af::array& Scaler::offset() const {
+        return this->offset_;
+    }
+
+    void Scaler::save(const std::string& filename, bool override) const {
+        Algorithm::save(filename, override);
+        if (this->mpi_rank_ == 0) {
+            hid_t file_id = juml::hdf5::open_file(filename);
+            juml::hdf5::write_array(file_id, "scale", this->scale_);
+            juml::hdf5::write_array(file_id, "offset", this->offset_);
+            juml::hdf5::close_file(file_id);
+        }
+        MPI_Barrier(this->comm_);
+    }
+
+    void Scaler::load(const std::string& filename) {
+        hid_t file_id = juml::hdf5::popen_file(filename, this->comm_);
+        this->scale_ = af::flat(juml::hdf5::pread_array(file_id, "scale", f32));
+        this->offset_ = af::flat(juml::hdf5::pread_array(file_id, "offset", f32));
+        juml::hdf5::close_file(file_id);
+    }
+} // namespace juml
@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2015
+* Forschungszentrum Juelich GmbH, Juelich Supercomputing Center
+*
+* This software may be modified and distributed under the terms of BSD-style license.
+*
+* File name: StandardScaler.cpp
+*
+* Description: Implementation of class StandardScaler
+*
+* Maintainer: m.goetz
+*
+* Email: murxman@gmail.com
+*/
+
+#include <stdexcept>
+
+#include "core/HDF5.h"
+#include "preprocessing/StandardScaler.h"
+
+namespace juml {
+    StandardScaler::StandardScaler(float x_std, int backend, MPI_Comm comm)
+      : Scaler(backend, comm),
+        x_std_(x_std) {
+        if (x_std <= 0)
+            throw std::invalid_argument("multiple of std must be greater than 0");
+    }
+
+    void StandardScaler::fit(Dataset& X) {
+        Backend::set(this->backend_.get());
+        X.load_equal_chunks();
+
+        const Moments moments = X.moments();
+        this->mean_ = af::flat(moments.mean).as(f32);
+        this->stddev_ = af::flat(moments.stddev()).as(f32);
+
+        // constant features are only centered
+        af::array deviation = this->stddev_ / this->x_std_;
+        deviation(deviation <= 0) = 1.0f;
+        this->scale_ = 1.0f / deviation;
+        this->offset_ = -this->mean_ * this->scale_;
+    }
+
+    const af::array& StandardScaler::mean() const {
+        return this->mean_;
+    }
+
+    const af::array& StandardScaler::stddev() const {
+        return this->stddev_;
+    }
+
+    void StandardScaler::save(const std::string& filename, bool override) const {
+        Scaler::save(filename, override);
+        if (this->mpi_rank_ == 0) {
+            hid_t file_id = juml::hdf5::open_file(filename);
+            juml::hdf5::write_array(file_id, "mean", this->mean_);
+            juml::hdf5::write_array(file_id, "stddev", this->stddev_);
+            juml::hdf5::write_array(file_id, "x_std", af::constant(this->x_std_, 1));
+            juml::hdf5::close_file(file_id);
+        }
+        MPI_Barrier(this->comm_);
+    }
+
+    void StandardScaler::load(const std::string& filename) {
+        Scaler::load(filename);
+        hid_t file_id = juml::hdf5::popen_file(filename, this->comm_);
+        this->mean_ = juml::hdf5::pread_array(file_id, "mean", f32);
+        this->stddev_ = juml::hdf5::pread_array(file_id, "stddev", f32);
+        this->x_std_ = juml::hdf5::pread_array(file_id, "x_std", f32).scalar<float>();
+        juml::hdf5::close_file(file_id);
+    }
+} // namespace juml
@@ -15,10 +15,50 @@
 
 #include <stdexcept>
 
+#include "core/MPI.h"
 #include "spatial/Distances.h"
 
 namespace juml {
-    af::array euclidean(const af::array& from, const af::array& to) {
+    /**
+     * check_sparse
+     *
+     * Validates the operands of a distance computation with sparse source points.
+     *
+     * @param from - the sparse source points, a n x f CSR array
+     * @param to   - the destination points, a f x k dense matrix
+     */
+    static void check_sparse(const af::array& from, const af::array& to) {
+        if (to.dims(2) > 1 || to.dims(3) > 1) {
+            throw std::invalid_argument("distances only support two-dimensional input");
+        }
+        if (from.dims(1) != to.dims(0)) {
+            throw std::invalid_argument("from and to must have same number of features");
+        }
+    }
+
+    /**
+     * squared_euclidean
+     *
+     * Calculates the squared euclidean distance matrix, which is additive across partitioned features.
+     *
+     * @param from - the source points, a f x n matrix or a n x f CSR array
+     * @param to   - the destination points, a f x k matrix
+     */
+    static af::array squared_euclidean(const af::array& from, const af::array& to) {
+        if (from.issparse()) {
+            check_sparse(from, to);
+            // |x - c|^2 = |x|^2 - 2 x.c + |c|^2, only the non-zero entries of x contribute to the first two terms
+            af::array values = af::sparseGetValues(from);
+            af::array squares = af::sparse(from.dims(0), from.dims(1), values * values, af::sparseGetRowIdx(from),
+                                           af::sparseGetColIdx(from), AF_STORAGE_CSR);
+            af::array ones = af::constant(1, from.dims(1), 1, values.type());
+            af::array from_norms = af::matmul(squares, ones);
+            af::array to_norms = af::sum(to * to, 0);
+            af::array distances = af::tile(from_norms, 1, to.dims(1)) - 2 * af::matmul(from, to)
+                                + af::tile(to_norms, from.dims(0), 1);
+            return af::max(distances, 0.0);
+        }
+
         if (from.dims(2) > 1 || from.dims(3) > 1 || to.dims(2) > 1 || to.dims(3) > 1) {
             throw std::invalid_argument("euclidean distance only supports two-dimensional input");
         }
@@ -37,10 +77,39 @@ namespace juml {
         af::array centroids_volume = af::tile(af::moddims(to, f, 1, k), 1, n, 1);
 
         // calculate the actual distance
-        return af::moddims(af::sqrt(af::sum(af::pow(centroids_volume - data_volume, 2), 0 /* along features */)), n, k);
+        return af::moddims(af::sum(af::pow(centroids_volume - data_volume, 2), 0 /* along features */), n, k);
+    }
+
+    af::array euclidean(const af::array& from, const af::array& to) {
+        return af::sqrt(squared_euclidean(from, to));
+    }
+
+    af::array euclidean(const af::array& from, const af::array& to, MPI_Comm comm) {
+        af::array distances = squared_euclidean(from, to);
+        mpi::allreduce_inplace(distances, MPI_SUM, comm);
+        return af::sqrt(distances);
     }
 
     af::array manhattan(const af::array& from, const af::array& to) {
+        if (from.issparse()) {
+            check_sparse(from, to);
+            // sum |x_f - c_f| = sum |c_f| + sum over the non-zero x_f of |x_f - c_f| - |c_f|
+            af::array values = af::sparseGetValues(from);
+            af::array rows = af::sparseGetRowIdx(from);
+            af::array columns = af::sparseGetColIdx(from);
+            af::array ones = af::constant(1, from.dims(1), 1, values.type());
+            af::array distances(from.dims(0), to.dims(1), values.type());
+            for (dim_t k = 0; k < to.dims(1); ++k) {
+                af::array destination = to(af::span, k);
+                af::array gathered = destination(columns);
+                af::array corrections = af::abs(values - gathered) - af::abs(gathered);
+                af::array correction_matrix = af::sparse(from.dims(0), from.dims(1), corrections, rows, columns,
+                                                         AF_STORAGE_CSR);
+                distances(af::span, k) = af::matmul(correction_matrix, ones) + af::sum<double>(af::abs(destination));
+            }
+            return distances;
+        }
+
         if (from.dims(2) > 1 || from.dims(3) > 1 || to.dims(2) > 1 || to.dims(3) > 1) {
             throw std::invalid_argument("manhattan distance only supports two-dimensional input");
         }
@@ -61,4 +130,10 @@ namespace juml {
         // calculate the actual distance
         return af::moddims(af::sum(af::abs(centroids_volume - data_volume), 0 /* along features */), n, k);
     }
+
+    af::array manhattan(const af::array& from, const af::array& to, MPI_Comm comm) {
+        af::array distances = manhattan(from, to);
+        mpi::allreduce_inplace(distances, MPI_SUM, comm);
+        return distances;
+    }
 } // namespace juml
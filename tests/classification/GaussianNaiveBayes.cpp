@@ -4,8 +4,11 @@
 #include <iostream>
 #include <mpi.h>
 #include <string>
+#include <vector>
 
 #include "data/Dataset.h"
+#include "data/DatasetWriter.h"
+#include "data/SparseDataset.h"
 #include "core/Test.h"
 #include "classification/GaussianNaiveBayes.h"
 
@@ -13,6 +16,7 @@ static const std::string FILE_PATH = JUML_DATASETS"/iris.h5";
 static const std::string SAMPLES = "samples";
 static const std::string LABELS = "labels";
 static const std::string DUMP_GNB = "gnb_model.h5";
+static const std::string DUMP_PREDICTIONS = "gnb_predictions.h5";
 
 static const float PRIORS[3] = {0.33333333f, 0.33333333f, 0.33333333f};
 static const float THETA[3][4] = {{5.00599957f, 3.41800022f, 1.46399999f, 0.24399997f},
@@ -93,6 +97,95 @@ TEST_ALL (GAUSSIAN_NAIVE_BAYES_TEST, SAVE_LOAD_TEST) {
     }
 }
 
+TEST_ALL (GAUSSIAN_NAIVE_BAYES_TEST, PREDICT_TO_TEST) {
+    int rank_;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank_);
+    juml::GaussianNaiveBayes gnb(BACKEND);
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::Dataset y(FILE_PATH, LABELS);
+    gnb.fit(X, y);
+
+    // predict block by block into an extendible dataset
+    {
+        juml::DatasetWriter output(DUMP_PREDICTIONS, LABELS);
+        gnb.predict_to(X, output, 7);
+        ASSERT_EQ(150u, output.written());
+    }
+    juml::Dataset written(DUMP_PREDICTIONS, LABELS);
+    written.load_equal_chunks();
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(DUMP_PREDICTIONS.c_str());
+    }
+
+    juml::Dataset predictions = gnb.predict(X);
+    ASSERT_EQ(predictions.n_samples(), written.n_samples());
+    ASSERT_TRUE(af::allTrue<bool>(predictions.data() == written.data()));
+}
+
+TEST_ALL (GAUSSIAN_NAIVE_BAYES_TEST, SPARSE_TEST) {
+    juml::GaussianNaiveBayes gnb(BACKEND);
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::Dataset y(FILE_PATH, LABELS);
+    X.load_equal_chunks();
+
+    // the same samples as rows of a CSR array
+    juml::SparseDataset X_sparse(af::sparse(af::transpose(X.data())));
+    gnb.fit(X_sparse, y);
+    for (int row = 0; row < 3; ++row) {
+        ASSERT_FLOAT_EQ(gnb.prior()(row).scalar<float>(), PRIORS[row]);
+        for (int col = 0; col < 4; ++col) {
+            ASSERT_NEAR(gnb.theta()(col, row).scalar<float>(), THETA[row][col], 0.001);
+            ASSERT_NEAR(gnb.stddev()(col, row).scalar<float>(), STDDEV[row][col], 0.001);
+        }
+    }
+    ASSERT_NEAR(gnb.accuracy(X_sparse, y), ACCURACY, 0.01);
+}
+
+TEST_ALL (GAUSSIAN_NAIVE_BAYES_TEST, OUT_OF_CORE_TEST) {
+    juml::GaussianNaiveBayes gnb(BACKEND);
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::Dataset y(FILE_PATH, LABELS);
+    gnb.fit(X, y);
+
+    // streamed samples are classified block by block
+    juml::Dataset X_streamed(FILE_PATH, SAMPLES);
+    X_streamed.set_block_size(7);
+    ASSERT_NEAR(gnb.accuracy(X_streamed, y), ACCURACY, 0.01);
+    const af::array expected = gnb.predict_probability(X).data();
+    const af::array streamed = gnb.predict_probability(X_streamed).data();
+    ASSERT_EQ(expected.dims(1), streamed.dims(1));
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(streamed - expected) <= 1e-5f * af::abs(expected)));
+}
+
+TEST_ALL (GAUSSIAN_NAIVE_BAYES_TEST, SPARSE_CONSTANT_FEATURES_TEST) {
+    // two classes with five disjoint non-zero features each, all other features are zero within both classes
+    const int n_features = 100000;
+    std::vector<int> row_pointers(1, 0);
+    std::vector<int> columns;
+    std::vector<float> values;
+    for (int sample = 0; sample < 4; ++sample) {
+        for (int feature = 0; feature < 5; ++feature) {
+            columns.push_back(10 * (sample / 2) + feature);
+            values.push_back(static_cast<float>(1 + sample % 2));
+        }
+        row_pointers.push_back(static_cast<int>(columns.size()));
+    }
+    af::array csr = af::sparse(4, n_features, af::array(20, values.data()), af::array(5, row_pointers.data()),
+                               af::array(20, columns.data()), AF_STORAGE_CSR);
+    const float labels[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    juml::SparseDataset X(csr);
+    juml::Dataset y(af::array(1, 4, labels));
+
+    juml::GaussianNaiveBayes gnb(BACKEND);
+    gnb.fit(X, y);
+    juml::Dataset probabilities = gnb.predict_probability(X);
+    ASSERT_EQ(2, probabilities.data().dims(0));
+    ASSERT_FALSE(af::anyTrue<bool>(af::isNaN(probabilities.data())));
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(af::sum(probabilities.data(), 0) - 1.0f) < 1e-5f));
+    ASSERT_FLOAT_EQ(1.0f, gnb.accuracy(X, y));
+}
+
 int main(int argc, char** argv) {
     int result = -1;
     int rank;
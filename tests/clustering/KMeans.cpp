@@ -43,6 +43,51 @@ TEST_ALL(KMEANS_TEST, IRIS_EUCLIDEAN) {
     }
 }
 
+TEST_ALL(KMEANS_TEST, IRIS_EUCLIDEAN_STREAMED) {
+    juml::KMeans kmeans(
+            /*k=*/3,
+            /*max_iter=*/100,
+            /*method=*/juml::KMeans::Method::RANDOM,
+            /*distance=*/juml::euclidean,
+            /*tolerance=*/0.02,
+            /*seed=*/42L,
+            /*backend=*/BACKEND);
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    X.set_block_size(16);
+
+    kmeans.fit(X);
+    const af::array& centroids = kmeans.centroids();
+
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            ASSERT_NEAR(centroids(col, row).scalar<float>(), EUCLIDEAN_CENTROIDS[row][col],0.0001);
+        }
+    }
+}
+
+TEST_ALL(KMEANS_TEST, IRIS_EUCLIDEAN_HALF_PRECISION) {
+    juml::KMeans kmeans(
+            /*k=*/3,
+            /*max_iter=*/100,
+            /*method=*/juml::KMeans::Method::RANDOM,
+            /*distance=*/juml::euclidean,
+            /*tolerance=*/0.02,
+            /*seed=*/42L,
+            /*backend=*/BACKEND);
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    X.set_half_precision(true);
+
+    kmeans.fit(X);
+    const af::array& centroids = kmeans.centroids();
+
+    // the samples are rounded to 11 significant bits
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            ASSERT_NEAR(centroids(col, row).scalar<float>(), EUCLIDEAN_CENTROIDS[row][col], 0.01);
+        }
+    }
+}
+
 TEST_ALL(KMEANS_TEST, IRIS_MANHATTAN) {
     juml::KMeans kmeans(
             /*k=*/3,
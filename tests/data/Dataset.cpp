@@ -1,13 +1,31 @@
+#include <algorithm>
 #include <arrayfire.h>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
 #include <exception>
+#include <fstream>
 #include <iostream>
 #include <gtest/gtest.h>
 #include <mpi.h>
+#include <sstream>
 #include <string>
+#include <sys/stat.h>
+#include <vector>
 
+#include "core/MPI.h"
 #include "core/Test.h"
+#include "data/CSVReader.h"
+#include "data/ChunkIterator.h"
 #include "data/Dataset.h"
+#include "data/DatasetGroup.h"
+#include "data/DatasetWriter.h"
+#include "data/NumpyDataset.h"
+#include "data/ShardedDataset.h"
+#include "data/SparseDataset.h"
+#include "spatial/Distances.h"
 
 const std::string FILE_PATH   = JUML_DATASETS"/mpi_ranks.h5";
 const std::string ONE_D_FLOAT = "1D_FLOAT";
@@ -21,6 +39,171 @@ const std::string ROWNUMBER_SETNAME = "testset";
 const std::string DUMP_FILE    = "dumpTest.h5";
 const std::string DUMP_DATASET = "DUMPED";
 const std::string DUMP_DATASET2 = "TEST_DUMPED";
+const std::string APPEND_FILE   = "appendTest.h5";
+const std::string CACHE_DIRECTORY = "partitionCache";
+const std::string NUMPY_FILE      = "numpyTest.npy";
+const std::string CSV_FILE        = "csvTest.csv";
+const size_t      NUMPY_HEADER    = 128;
+const std::string SHARD_PATTERN   = "shardTest*.h5";
+const std::string VIRTUAL_FILE    = "shardVirtual.h5";
+
+/**
+ * Creates or extends an extendible, chunked HDF5 dataset with three columns, each row containing its row index.
+ */
+static void write_rows(hsize_t begin, hsize_t end) {
+    hsize_t dims[2] = {end, 3};
+    hid_t file_id;
+    hid_t data_id;
+    if (begin == 0) {
+        hsize_t max_dims[2] = {H5S_UNLIMITED, 3};
+        hsize_t chunk_dims[2] = {4, 3};
+        file_id = H5Fcreate(APPEND_FILE.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        hid_t space_id = H5Screate_simple(2, dims, max_dims);
+        hid_t plist_id = H5Pcreate(H5P_DATASET_CREATE);
+        H5Pset_chunk(plist_id, 2, chunk_dims);
+        data_id = H5Dcreate(file_id, DUMP_DATASET.c_str(), H5T_NATIVE_INT, space_id,
+                            H5P_DEFAULT, plist_id, H5P_DEFAULT);
+        H5Pclose(plist_id);
+        H5Sclose(space_id);
+    } else {
+        file_id = H5Fopen(APPEND_FILE.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+        data_id = H5Dopen(file_id, DUMP_DATASET.c_str(), H5P_DEFAULT);
+        H5Dset_extent(data_id, dims);
+    }
+
+    std::vector<int> rows;
+    for (hsize_t row = begin; row < end; ++row) {
+        rows.insert(rows.end(), 3, static_cast<int>(row));
+    }
+    hsize_t start[2] = {begin, 0};
+    hsize_t count[2] = {end - begin, 3};
+    hid_t file_space = H5Dget_space(data_id);
+    H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
+    hid_t mem_space = H5Screate_simple(2, count, NULL);
+    H5Dwrite(data_id, H5T_NATIVE_INT, mem_space, file_space, H5P_DEFAULT, rows.data());
+
+    H5Sclose(mem_space);
+    H5Sclose(file_space);
+    H5Dclose(data_id);
+    H5Fclose(file_id);
+}
+
+/**
+ * Writes a rows x 5 sparse matrix in CSR layout into an HDF5 group. Row r holds r + 1 in column r % 4, even rows -1
+ * in the last column.
+ */
+static void write_sparse(hsize_t rows) {
+    std::vector<long long> indptr(1, 0);
+    std::vector<int> indices;
+    std::vector<float> values;
+    for (hsize_t row = 0; row < rows; ++row) {
+        indices.push_back(static_cast<int>(row % 4));
+        values.push_back(static_cast<float>(row + 1));
+        if (row % 2 == 0) {
+            indices.push_back(4);
+            values.push_back(-1.0f);
+        }
+        indptr.push_back(static_cast<long long>(indices.size()));
+    }
+
+    hid_t file_id = H5Fcreate(DUMP_FILE.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    hid_t group_id = H5Gcreate(file_id, DUMP_DATASET.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    hsize_t n_pointers = indptr.size();
+    hsize_t n_nonzero = indices.size();
+    hsize_t n_shape = 2;
+    long long shape[2] = {static_cast<long long>(rows), 5};
+
+    hid_t space_id = H5Screate_simple(1, &n_pointers, NULL);
+    hid_t data_id = H5Dcreate(group_id, "indptr", H5T_NATIVE_LLONG, space_id,
+                              H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Dwrite(data_id, H5T_NATIVE_LLONG, H5S_ALL, H5S_ALL, H5P_DEFAULT, indptr.data());
+    H5Dclose(data_id);
+    H5Sclose(space_id);
+
+    space_id = H5Screate_simple(1, &n_nonzero, NULL);
+    data_id = H5Dcreate(group_id, "indices", H5T_NATIVE_INT, space_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Dwrite(data_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, indices.data());
+    H5Dclose(data_id);
+    data_id = H5Dcreate(group_id, "values", H5T_NATIVE_FLOAT, space_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Dwrite(data_id, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+    H5Dclose(data_id);
+    H5Sclose(space_id);
+
+    space_id = H5Screate_simple(1, &n_shape, NULL);
+    hid_t attribute_id = H5Acreate(group_id, "shape", H5T_NATIVE_LLONG, space_id, H5P_DEFAULT, H5P_DEFAULT);
+    H5Awrite(attribute_id, H5T_NATIVE_LLONG, shape);
+    H5Aclose(attribute_id);
+    H5Sclose(space_id);
+
+    H5Gclose(group_id);
+    H5Fclose(file_id);
+}
+
+/**
+ * Writes a rows x columns float matrix, the element in row r and column c holding r * columns + c.
+ */
+static void write_grid(hsize_t rows, hsize_t columns) {
+    std::vector<float> values(rows * columns);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<float>(i);
+    }
+
+    hsize_t dims[2] = {rows, columns};
+    hid_t file_id = H5Fcreate(DUMP_FILE.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    hid_t space_id = H5Screate_simple(2, dims, NULL);
+    hid_t data_id = H5Dcreate(file_id, DUMP_DATASET.c_str(), H5T_NATIVE_FLOAT, space_id,
+                              H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Dwrite(data_id, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+    H5Dclose(data_id);
+    H5Sclose(space_id);
+    H5Fclose(file_id);
+}
+
+/**
+ * Writes an HDF5 shard with three columns holding the global row indices begin to end.
+ */
+static void write_shard(const std::string& filename, hsize_t begin, hsize_t end) {
+    std::vector<int> rows;
+    for (hsize_t row = begin; row < end; ++row) {
+        rows.insert(rows.end(), 3, static_cast<int>(row));
+    }
+
+    hsize_t dims[2] = {end - begin, 3};
+    hid_t file_id = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    hid_t space_id = H5Screate_simple(2, dims, NULL);
+    hid_t data_id = H5Dcreate(file_id, DUMP_DATASET.c_str(), H5T_NATIVE_INT, space_id,
+                              H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Dwrite(data_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, rows.data());
+    H5Dclose(data_id);
+    H5Sclose(space_id);
+    H5Fclose(file_id);
+}
+
+/**
+ * Writes a virtual dataset stacking the shards, whose rows start at the given boundaries, into a single one.
+ */
+static void write_virtual(const std::vector<std::string>& files, const std::vector<hsize_t>& boundaries) {
+    hsize_t dims[2] = {boundaries.back(), 3};
+    hid_t space_id = H5Screate_simple(2, dims, NULL);
+    hid_t plist_id = H5Pcreate(H5P_DATASET_CREATE);
+    for (size_t i = 0; i < files.size(); ++i) {
+        hsize_t start[2] = {boundaries[i], 0};
+        hsize_t count[2] = {boundaries[i + 1] - boundaries[i], 3};
+        hid_t source_space = H5Screate_simple(2, count, NULL);
+        H5Sselect_hyperslab(space_id, H5S_SELECT_SET, start, NULL, count, NULL);
+        H5Pset_virtual(plist_id, space_id, files[i].c_str(), DUMP_DATASET.c_str(), source_space);
+        H5Sclose(source_space);
+    }
+    H5Sselect_all(space_id);
+
+    hid_t file_id = H5Fcreate(VIRTUAL_FILE.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    hid_t data_id = H5Dcreate(file_id, DUMP_DATASET.c_str(), H5T_NATIVE_INT, space_id,
+                              H5P_DEFAULT, plist_id, H5P_DEFAULT);
+    H5Dclose(data_id);
+    H5Pclose(plist_id);
+    H5Sclose(space_id);
+    H5Fclose(file_id);
+}
 
 class DATASET_TEST : public testing::Test
 {
@@ -80,6 +263,355 @@ TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_2D_INT) {
     }
 }
 
+TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_TARGET_TYPE) {
+    juml::Dataset data_2D(FILE_PATH, TWO_D_INT);
+    data_2D.set_target_type(f64);
+    data_2D.load_equal_chunks();
+    ASSERT_EQ(f64, data_2D.data().type());
+    ASSERT_TRUE(af::allTrue<bool>(data_2D.data() == (double)this->rank_));
+
+    // out-of-core blocks are converted as well
+    data_2D.set_block_size(2);
+    data_2D.load_equal_chunks();
+    juml::ChunkIterator blocks(data_2D);
+    while (blocks.has_next()) {
+        const af::array& block = blocks.next();
+        ASSERT_EQ(f64, block.type());
+        ASSERT_TRUE(af::allTrue<bool>(block == (double)this->rank_));
+    }
+
+    data_2D.clear_target_type();
+    data_2D.set_block_size(0);
+    data_2D.load_equal_chunks();
+    ASSERT_EQ(s32, data_2D.data().type());
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_SELECTION) {
+    juml::Dataset data(FILE_PATH_ROWNUMBER, ROWNUMBER_SETNAME);
+    data.set_features({0, 2});
+    data.set_sample_range(1, 5, 2);
+    data.load_equal_chunks();
+
+    // rows 1 and 3 projected onto the first and last column
+    ASSERT_EQ(2, data.global_n_samples());
+    ASSERT_EQ(2, data.n_features());
+    long long n_samples = data.n_samples();
+    MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(2, n_samples);
+    for (int col = 0; col < data.n_samples(); ++col) {
+        const int row = 1 + 2 * static_cast<int>(data.global_offset() + col);
+        ASSERT_TRUE(af::allTrue<bool>(data.data().col(col) == row));
+    }
+
+    ASSERT_THROW(data.set_features({2, 1}), std::invalid_argument);
+    ASSERT_THROW(data.set_sample_range(0, 5, 0), std::invalid_argument);
+    data.set_features({3});
+    ASSERT_THROW(data.load_equal_chunks(), std::domain_error);
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_COLLECTIVE) {
+    juml::Dataset data_2D(FILE_PATH, TWO_D_FLOAT);
+    data_2D.set_io_profile(juml::IOProfile(true, 1, 0, 0, 4096));
+    data_2D.load_equal_chunks();
+    ASSERT_TRUE(data_2D.io_profile().collective);
+    for (size_t col = 0; col < data_2D.data().dims(1); ++col) {
+        ASSERT_TRUE(af::allTrue<bool>(data_2D.data().col(col) == (float)this->rank_));
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_MEMORY_MAP) {
+    juml::Dataset data_2D(FILE_PATH, TWO_D_FLOAT);
+    data_2D.set_memory_map(true);
+    data_2D.load_equal_chunks();
+    ASSERT_EQ(af::getActiveBackend() == AF_BACKEND_CPU, data_2D.is_memory_mapped());
+    for (size_t col = 0; col < data_2D.data().dims(1); ++col) {
+        ASSERT_TRUE(af::allTrue<bool>(data_2D.data().col(col) == (float)this->rank_));
+    }
+
+    // modifications must neither alter the mapping nor the file
+    data_2D.data() += 1;
+    juml::Dataset reloaded(FILE_PATH, TWO_D_FLOAT);
+    reloaded.set_memory_map(true);
+    reloaded.load_equal_chunks();
+    ASSERT_TRUE(af::allTrue<bool>(reloaded.data() == (float)this->rank_));
+
+    // copies of the mapped samples outlive the dataset
+    af::array copy;
+    {
+        juml::Dataset mapped(FILE_PATH, TWO_D_FLOAT);
+        mapped.set_memory_map(true);
+        mapped.load_equal_chunks();
+        copy = mapped.data();
+    }
+    ASSERT_TRUE(af::allTrue<bool>(copy == (float)this->rank_));
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_HALF_PRECISION) {
+    juml::Dataset full(FILE_PATH, TWO_D_FLOAT);
+    full.load_equal_chunks();
+    juml::Dataset half(FILE_PATH, TWO_D_FLOAT);
+    half.set_half_precision(true);
+    half.set_memory_map(true);
+    half.load_equal_chunks();
+    ASSERT_EQ(f16, half.data().type());
+    ASSERT_FALSE(half.is_memory_mapped());
+    ASSERT_EQ(full.data().bytes() / 2, half.data().bytes());
+
+    // the blocks are widened for computation
+    juml::ChunkIterator blocks(half);
+    while (blocks.has_next()) {
+        const af::array& block = blocks.next();
+        ASSERT_EQ(f32, block.type());
+        ASSERT_TRUE(af::allTrue<bool>(block == (float)this->rank_));
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, QUANTIZE) {
+    juml::Dataset full(FILE_PATH, TWO_D_FLOAT);
+    full.load_equal_chunks();
+    juml::Dataset quantized(FILE_PATH, TWO_D_FLOAT);
+    quantized.load_equal_chunks();
+    quantized.quantize();
+    ASSERT_TRUE(quantized.is_quantized());
+    ASSERT_EQ(u8, quantized.data().type());
+    ASSERT_EQ(full.data().bytes() / 4, quantized.data().bytes());
+
+    // the ranks span the global range of each feature
+    const float step = this->size_ > 1 ? (this->size_ - 1) / 255.0f : 1.0f;
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(quantized.scale() - step) < 1e-6));
+    ASSERT_TRUE(af::allTrue<bool>(quantized.offset() == 0.0f));
+
+    juml::ChunkIterator blocks(quantized);
+    while (blocks.has_next()) {
+        const af::array& block = blocks.next();
+        ASSERT_EQ(f32, block.type());
+        ASSERT_TRUE(af::allTrue<bool>(af::abs(block - (float)this->rank_) <= step / 2));
+    }
+
+    // a reload restores the original samples
+    quantized.load_equal_chunks(true);
+    ASSERT_FALSE(quantized.is_quantized());
+    ASSERT_TRUE(af::allTrue<bool>(quantized.data() == full.data()));
+
+    // as does a reload through a group
+    quantized.quantize();
+    juml::DatasetGroup group;
+    group.add(quantized);
+    group.load_equal_chunks(true);
+    ASSERT_FALSE(quantized.is_quantized());
+    ASSERT_TRUE(af::allTrue<bool>(quantized.data() == full.data()));
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_SHARED_METADATA) {
+    juml::Dataset::clear_registry();
+    juml::Dataset first(FILE_PATH, TWO_D_FLOAT);
+    first.set_shared_metadata(true);
+    ASSERT_TRUE(first.shared_metadata());
+    first.load_equal_chunks();
+
+    // the second instance is served from the registry
+    juml::Dataset second(FILE_PATH, TWO_D_FLOAT);
+    second.set_shared_metadata(true);
+    second.load_equal_chunks();
+    ASSERT_EQ(first.modified_time(), second.modified_time());
+    ASSERT_EQ(first.global_n_samples(), second.global_n_samples());
+    ASSERT_EQ(first.global_offset(), second.global_offset());
+    ASSERT_TRUE(af::allTrue<bool>(second.data() == (float)this->rank_));
+
+    // modifying one instance does not alter the registered partition
+    first.data() += 1;
+    juml::Dataset third(FILE_PATH, TWO_D_FLOAT);
+    third.set_shared_metadata(true);
+    third.load_equal_chunks();
+    ASSERT_TRUE(af::allTrue<bool>(third.data() == (float)this->rank_));
+
+    // a node that has forgotten the partition makes all nodes read it again
+    if (rank_ == 0) juml::Dataset::clear_registry();
+    juml::Dataset fourth(FILE_PATH, TWO_D_FLOAT);
+    fourth.set_shared_metadata(true);
+    fourth.load_equal_chunks();
+    ASSERT_TRUE(af::allTrue<bool>(fourth.data() == (float)this->rank_));
+    juml::Dataset::clear_registry();
+
+    juml::Dataset missing("doesNotExist.h5", TWO_D_FLOAT);
+    missing.set_shared_metadata(true);
+    ASSERT_THROW(missing.load_equal_chunks(), std::runtime_error);
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_CACHED) {
+    mkdir(CACHE_DIRECTORY.c_str(), 0755);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    juml::Dataset first(FILE_PATH, TWO_D_FLOAT);
+    first.set_cache_directory(CACHE_DIRECTORY);
+    ASSERT_EQ(CACHE_DIRECTORY, first.cache_directory());
+    first.load_equal_chunks();
+
+    // the second instance is served from the node-local cache
+    juml::Dataset second(FILE_PATH, TWO_D_FLOAT);
+    second.set_cache_directory(CACHE_DIRECTORY);
+    second.load_equal_chunks();
+    ASSERT_EQ(first.global_n_samples(), second.global_n_samples());
+    ASSERT_EQ(first.global_offset(), second.global_offset());
+    ASSERT_EQ(first.sample_dim(), second.sample_dim());
+    ASSERT_EQ(first.data().dims(), second.data().dims());
+    ASSERT_TRUE(af::allTrue<bool>(second.data() == (float)this->rank_));
+
+    // the cache may be mapped as well
+    juml::Dataset mapped(FILE_PATH, TWO_D_FLOAT);
+    mapped.set_cache_directory(CACHE_DIRECTORY);
+    mapped.set_memory_map(true);
+    mapped.load_equal_chunks();
+    ASSERT_TRUE(af::allTrue<bool>(mapped.data() == (float)this->rank_));
+
+    // a different selection is a different partition
+    juml::Dataset converted(FILE_PATH, TWO_D_FLOAT);
+    converted.set_cache_directory(CACHE_DIRECTORY);
+    converted.set_target_type(f64);
+    converted.load_equal_chunks();
+    ASSERT_EQ(f64, converted.data().type());
+    ASSERT_TRUE(af::allTrue<bool>(converted.data() == (double)this->rank_));
+
+    // a cache file with an invalid header is a miss, the type follows the magic and ten header fields
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (this->rank_ == 0) {
+        DIR* directory = opendir(CACHE_DIRECTORY.c_str());
+        for (struct dirent* entry = readdir(directory); entry != NULL; entry = readdir(directory)) {
+            const std::string name = entry->d_name;
+            if (name.size() < 5 || name.compare(name.size() - 5, 5, ".part") != 0) continue;
+            std::fstream file((CACHE_DIRECTORY + "/" + name).c_str(), std::ios::binary | std::ios::in | std::ios::out);
+            const long long type = 1000;
+            file.seekp(8 + 10 * sizeof(long long));
+            file.write(reinterpret_cast<const char*>(&type), sizeof(type));
+        }
+        closedir(directory);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    juml::Dataset corrupt(FILE_PATH, TWO_D_FLOAT);
+    corrupt.set_cache_directory(CACHE_DIRECTORY);
+    corrupt.load_equal_chunks();
+    ASSERT_EQ(first.data().dims(), corrupt.data().dims());
+    ASSERT_TRUE(af::allTrue<bool>(corrupt.data() == (float)this->rank_));
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (this->rank_ == 0) {
+        std::system(("rm -rf " + CACHE_DIRECTORY).c_str());
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_WEIGHTED_CHUNKS) {
+    std::vector<double> weights(this->size_);
+    for (int rank = 0; rank < this->size_; ++rank) {
+        weights[rank] = rank + 1;
+    }
+    juml::Dataset data(FILE_PATH_ROWNUMBER, ROWNUMBER_SETNAME);
+    data.load_weighted_chunks(weights);
+
+    long long n_samples = data.n_samples();
+    MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(5, n_samples);
+    ASSERT_EQ(5, data.global_n_samples());
+    for (int col = 0; col < data.n_samples(); ++col) {
+        ASSERT_TRUE(af::allTrue<bool>(data.data().col(col) == data.global_offset() + col));
+    }
+
+    // the last node has the highest weight and therefore holds the most samples
+    long long max_samples = data.n_samples();
+    MPI_Allreduce(MPI_IN_PLACE, &max_samples, 1, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+    if (this->rank_ == this->size_ - 1) {
+        ASSERT_EQ(max_samples, data.n_samples());
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_WEIGHTED_CHUNKS_INVALID) {
+    juml::Dataset data(FILE_PATH_ROWNUMBER, ROWNUMBER_SETNAME);
+    ASSERT_THROW(data.load_weighted_chunks(std::vector<double>(this->size_ + 1, 1.0)), std::invalid_argument);
+    ASSERT_THROW(data.load_weighted_chunks(std::vector<double>(this->size_, 0.0)), std::invalid_argument);
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_WEIGHTED_CHUNKS_CALIBRATED) {
+    juml::Dataset data(FILE_PATH_ROWNUMBER, ROWNUMBER_SETNAME);
+    data.load_weighted_chunks();
+    ASSERT_EQ(this->size_, data.weights().size());
+
+    long long n_samples = data.n_samples();
+    MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(5, n_samples);
+}
+
+TEST_ALL_F(DATASET_TEST, DATASET_GROUP) {
+    juml::Dataset data_1D(FILE_PATH, ONE_D_INT);
+    juml::Dataset data_1D_float(FILE_PATH, ONE_D_FLOAT);
+    juml::Dataset single(FILE_PATH, ONE_D_INT);
+    single.load_equal_chunks();
+
+    juml::DatasetGroup group;
+    group.add(data_1D).add(data_1D_float);
+    ASSERT_EQ(2, group.size());
+    group.load_equal_chunks();
+
+    // identical partition as a separate load
+    ASSERT_EQ(single.global_offset(), data_1D.global_offset());
+    ASSERT_EQ(single.global_offset(), data_1D_float.global_offset());
+    ASSERT_EQ(single.n_samples(), data_1D_float.n_samples());
+    ASSERT_TRUE(af::allTrue<bool>(single.data() == data_1D.data()));
+    ASSERT_TRUE(af::allTrue<bool>(data_1D_float.data() == (float)this->rank_));
+
+    // datasets of different sizes or files are rejected
+    juml::Dataset data_2D(FILE_PATH, TWO_D_INT);
+    juml::DatasetGroup mismatch;
+    mismatch.add(data_1D).add(data_2D);
+    ASSERT_THROW(mismatch.load_equal_chunks(true), std::domain_error);
+    juml::Dataset other(FILE_PATH_ROWNUMBER, ROWNUMBER_SETNAME);
+    ASSERT_THROW(group.add(other), std::invalid_argument);
+}
+
+TEST_ALL_F(DATASET_TEST, DATASET_GROUP_SHARED) {
+    juml::Dataset::clear_registry();
+    mkdir(CACHE_DIRECTORY.c_str(), 0755);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    juml::Dataset single(FILE_PATH, ONE_D_INT);
+    single.set_shared_metadata(true);
+    single.load_equal_chunks();
+    juml::Dataset cached(FILE_PATH, ONE_D_FLOAT);
+    cached.set_cache_directory(CACHE_DIRECTORY);
+    cached.load_equal_chunks();
+
+    // the members are taken from the load registry and the node-local cache, the file is not read
+    juml::Dataset registered(FILE_PATH, ONE_D_INT);
+    registered.set_shared_metadata(true);
+    juml::Dataset from_cache(FILE_PATH, ONE_D_FLOAT);
+    from_cache.set_cache_directory(CACHE_DIRECTORY);
+    juml::DatasetGroup group;
+    group.add(registered).add(from_cache);
+    group.load_equal_chunks();
+    // the buffer is shared by both instances and the registry
+    int references = 0;
+    af_get_data_ref_count(&references, registered.data().get());
+    ASSERT_EQ(3, references);
+    ASSERT_EQ(single.global_offset(), from_cache.global_offset());
+    ASSERT_TRUE(af::allTrue<bool>(from_cache.data() == (float)this->rank_));
+
+    // members loaded through a group are registered as well
+    juml::Dataset::clear_registry();
+    juml::Dataset first(FILE_PATH, ONE_D_INT);
+    first.set_shared_metadata(true);
+    juml::Dataset labels(FILE_PATH, ONE_D_FLOAT);
+    juml::DatasetGroup::joint_load(first, labels);
+    juml::Dataset second(FILE_PATH, ONE_D_INT);
+    second.set_shared_metadata(true);
+    second.load_equal_chunks();
+    af_get_data_ref_count(&references, second.data().get());
+    ASSERT_EQ(3, references);
+    juml::Dataset::clear_registry();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (this->rank_ == 0) {
+        std::system(("rm -rf " + CACHE_DIRECTORY).c_str());
+    }
+}
+
 TEST_ALL_F(DATASET_TEST, DUMP_EQUAL_CHUNKS) {
     juml::Backend::set(juml::Backend::CPU);
     af::array data = af::constant(rank_, 2, 10, 4, s32);
@@ -114,6 +646,314 @@ TEST_ALL_F(DATASET_TEST, DUMP_EQUAL_CHUNKS_APPEND) {
     ASSERT_TRUE(af::allTrue<bool>(loaded2.data() == data2));
 }
 
+TEST_ALL_F(DATASET_TEST, DUMP_EQUAL_CHUNKS_COMPRESSED) {
+    juml::Backend::set(juml::Backend::CPU);
+    af::array data = af::constant(rank_, 2, 10, 4, s32);
+    juml::Dataset dataset(data, MPI_COMM_WORLD);
+    juml::WriteStatistics statistics = dataset.dump_equal_chunks(
+        DUMP_FILE, DUMP_DATASET, juml::ChunkLayout(true, 0, 6, true));
+
+    juml::Dataset loaded(DUMP_FILE, DUMP_DATASET);
+    loaded.load_equal_chunks();
+    if (rank_ == 0) {
+        std::remove(DUMP_FILE.c_str());
+    }
+    ASSERT_TRUE(af::allTrue<bool>(loaded.data() == data));
+    ASSERT_EQ(statistics.raw_bytes, static_cast<hsize_t>(2 * 10 * 4 * sizeof(int) * size_));
+    ASSERT_GT(statistics.stored_bytes, 0u);
+    ASSERT_GT(statistics.compression_ratio(), 1.0);
+    ASSERT_GE(statistics.seconds, 0.0);
+}
+
+TEST_ALL_F(DATASET_TEST, DUMP_EQUAL_CHUNKS_COMPACT) {
+    // half precision and quantized samples are dumped as f32 values
+    juml::Dataset half(FILE_PATH, TWO_D_FLOAT);
+    half.set_half_precision(true);
+    half.load_equal_chunks();
+    half.dump_equal_chunks(DUMP_FILE, DUMP_DATASET);
+
+    juml::Dataset quantized(FILE_PATH, TWO_D_FLOAT);
+    quantized.load_equal_chunks();
+    quantized.quantize();
+    quantized.dump_equal_chunks(DUMP_FILE, DUMP_DATASET2);
+
+    juml::Dataset loaded_half(DUMP_FILE, DUMP_DATASET);
+    juml::Dataset loaded_quantized(DUMP_FILE, DUMP_DATASET2);
+    loaded_half.load_equal_chunks();
+    loaded_quantized.load_equal_chunks();
+    if (rank_ == 0) {
+        std::remove(DUMP_FILE.c_str());
+    }
+    ASSERT_EQ(f32, loaded_half.data().type());
+    ASSERT_TRUE(af::allTrue<bool>(loaded_half.data() == (float)this->rank_));
+    ASSERT_EQ(f32, loaded_quantized.data().type());
+    const float tolerance = (this->size_ - 1) / 510.0f + 1e-4f;
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(loaded_quantized.data() - (float)this->rank_) <= tolerance));
+}
+
+TEST_ALL_F(DATASET_TEST, LOAD_INCREMENTAL) {
+    const hsize_t size = static_cast<hsize_t>(this->size_);
+    if (rank_ == 0) write_rows(0, 2 * size);
+    MPI_Barrier(MPI_COMM_WORLD);
+    juml::Dataset data(APPEND_FILE, DUMP_DATASET);
+    data.load_equal_chunks();
+    ASSERT_EQ(2, data.n_samples());
+
+    // appended rows end up on the last node
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) write_rows(2 * size, 3 * size + 1);
+    MPI_Barrier(MPI_COMM_WORLD);
+    data.load_incremental();
+    ASSERT_EQ(3 * this->size_ + 1, data.global_n_samples());
+    ASSERT_EQ(rank_ == this->size_ - 1 ? this->size_ + 3 : 2, data.n_samples());
+    for (int col = 0; col < data.n_samples(); ++col) {
+        ASSERT_TRUE(af::allTrue<bool>(data.data().col(col) == data.global_offset() + col));
+    }
+
+    // rebalanced into equal portions
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) write_rows(3 * size + 1, 4 * size + 2);
+    MPI_Barrier(MPI_COMM_WORLD);
+    data.load_incremental(true);
+    ASSERT_EQ(4 * this->size_ + 2, data.global_n_samples());
+    ASSERT_LE(std::abs(data.n_samples() - data.global_n_samples() / this->size_), 1);
+    for (int col = 0; col < data.n_samples(); ++col) {
+        ASSERT_TRUE(af::allTrue<bool>(data.data().col(col) == data.global_offset() + col));
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(APPEND_FILE.c_str());
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, DATASET_WRITER) {
+    {
+        juml::DatasetWriter writer(DUMP_FILE, DUMP_DATASET, MPI_COMM_WORLD, juml::ChunkLayout(true, 3));
+        writer.append(af::constant(rank_, 2, 2, s32));
+        // the first node has no samples in the second block
+        writer.append(rank_ == 0 ? af::array() : af::constant(rank_ + size_, 2, 1, s32));
+        ASSERT_EQ(static_cast<hsize_t>(3 * size_ - 1), writer.written());
+        ASSERT_THROW(writer.append(af::constant(rank_, 3, 1, s32)), std::invalid_argument);
+        // a mismatch on a single node makes all nodes throw instead of waiting for it
+        const af::array block = rank_ == size_ - 1 ? af::constant(rank_, 2, 1, f32) : af::constant(rank_, 2, 1, s32);
+        ASSERT_THROW(writer.append(block), std::invalid_argument);
+        ASSERT_EQ(static_cast<hsize_t>(3 * size_ - 1), writer.written());
+        writer.close();
+    }
+
+    juml::Dataset loaded(DUMP_FILE, DUMP_DATASET);
+    loaded.load_equal_chunks();
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(DUMP_FILE.c_str());
+    }
+    ASSERT_EQ(3 * size_ - 1, loaded.global_n_samples());
+    for (int col = 0; col < loaded.n_samples(); ++col) {
+        const int sample = static_cast<int>(loaded.global_offset()) + col;
+        const int value = sample < 2 * size_ ? sample / 2 : sample - 2 * size_ + 1 + size_;
+        ASSERT_TRUE(af::allTrue<bool>(loaded.data().col(col) == value));
+    }
+}
+
+/**
+ * Writes a rows x 3 float array as version 1.0 .npy file with a header of NUMPY_HEADER bytes. Element (r, c) holds
+ * 10 * r + c.
+ */
+static void write_numpy(hsize_t rows, bool fortran_order) {
+    std::stringstream dictionary;
+    dictionary << "{'descr': '<f4', 'fortran_order': " << (fortran_order ? "True" : "False")
+               << ", 'shape': (" << rows << ", 3), }";
+    std::string header = dictionary.str();
+    header.resize(NUMPY_HEADER - 11, ' ');
+    header += '\n';
+    const unsigned short length = static_cast<unsigned short>(header.size());
+
+    std::vector<float> elements;
+    for (hsize_t i = 0; i < rows * 3; ++i) {
+        const hsize_t row = fortran_order ? i % rows : i / 3;
+        const hsize_t column = fortran_order ? i / rows : i % 3;
+        elements.push_back(static_cast<float>(10 * row + column));
+    }
+
+    std::ofstream file(NUMPY_FILE.c_str(), std::ios::binary | std::ios::trunc);
+    file.write("\x93NUMPY\x01\x00", 8);
+    file.put(static_cast<char>(length & 0xff));
+    file.put(static_cast<char>(length >> 8));
+    file.write(header.data(), header.size());
+    file.write(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(float));
+}
+
+TEST_ALL_F(DATASET_TEST, SPARSE_DATASET) {
+    const hsize_t rows = 2 * static_cast<hsize_t>(size_) + 1;
+    if (rank_ == 0) write_sparse(rows);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    juml::SparseDataset data(DUMP_FILE, DUMP_DATASET);
+    data.load_equal_chunks();
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(DUMP_FILE.c_str());
+    }
+
+    ASSERT_TRUE(data.data().issparse());
+    ASSERT_EQ(static_cast<dim_t>(rows), data.global_n_samples());
+    ASSERT_EQ(5, data.n_features());
+    ASSERT_EQ(0, data.sample_dim());
+    long long n_samples = data.n_samples();
+    MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(static_cast<long long>(rows), n_samples);
+
+    af::array dense = af::dense(data.data());
+    for (int row = 0; row < data.n_samples(); ++row) {
+        const int sample = static_cast<int>(data.global_offset()) + row;
+        ASSERT_FLOAT_EQ(static_cast<float>(sample + 1), dense(row, sample % 4).scalar<float>());
+        ASSERT_FLOAT_EQ(sample % 2 == 0 ? -1.0f : 0.0f, dense(row, 4).scalar<float>());
+    }
+
+    // row slices stay sparse
+    af::array slice = juml::SparseDataset::rows(data.data(), 1, data.n_samples() - 1);
+    ASSERT_TRUE(slice.issparse());
+    ASSERT_TRUE(af::allTrue<bool>(af::dense(slice) == dense.rows(1, data.n_samples() - 1)));
+
+    // rows without non-zero entries are built without a dense array
+    af::array empty = juml::SparseDataset::empty_rows(3, 5, f32);
+    ASSERT_TRUE(empty.issparse());
+    ASSERT_EQ(3, empty.dims(0));
+    ASSERT_EQ(5, empty.dims(1));
+    ASSERT_EQ(0, af::sparseGetNNZ(empty));
+
+    ASSERT_THROW(juml::SparseDataset(af::constant(0.0f, 2, 2)), std::invalid_argument);
+}
+
+TEST_ALL_F(DATASET_TEST, NUMPY_DATASET) {
+    const hsize_t rows = 2 * static_cast<hsize_t>(size_) + 1;
+    for (bool fortran_order : {false, true}) {
+        if (rank_ == 0) write_numpy(rows, fortran_order);
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        juml::NumpyDataset data(NUMPY_FILE);
+        data.load_equal_chunks();
+        ASSERT_EQ(fortran_order, data.fortran_order());
+        ASSERT_EQ(2u, data.shape().size());
+        ASSERT_EQ(static_cast<dim_t>(rows), data.global_n_samples());
+        ASSERT_EQ(3, data.n_features());
+        ASSERT_EQ(1, data.sample_dim());
+        long long n_samples = data.n_samples();
+        MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        ASSERT_EQ(static_cast<long long>(rows), n_samples);
+
+        // both storage orders yield the features x samples layout
+        const dim_t n_local = data.n_samples();
+        af::array expected = 10 * (af::range(af::dim4(3, n_local), 1) + data.global_offset())
+                             + af::range(af::dim4(3, n_local), 0);
+        ASSERT_TRUE(af::allTrue<bool>(data.data() == expected.as(f32)));
+
+        // the sample range and the feature projection apply as for HDF5 datasets
+        juml::NumpyDataset selected(NUMPY_FILE);
+        selected.set_features({0, 2});
+        selected.set_sample_range(1, rows, 2);
+        selected.set_target_type(f64);
+        selected.load_equal_chunks();
+        ASSERT_EQ(f64, selected.data().type());
+        ASSERT_EQ(static_cast<dim_t>(rows / 2), selected.global_n_samples());
+        for (dim_t i = 0; i < selected.n_samples(); ++i) {
+            const double row = 1 + 2 * (selected.global_offset() + i);
+            ASSERT_DOUBLE_EQ(10 * row, selected.data()(0, i).scalar<double>());
+            ASSERT_DOUBLE_EQ(10 * row + 2, selected.data()(1, i).scalar<double>());
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    // the same elements as headerless raw file, mapped if possible
+    if (rank_ == 0) write_numpy(rows, false);
+    MPI_Barrier(MPI_COMM_WORLD);
+    juml::NumpyDataset raw(NUMPY_FILE, {rows, 3}, f32, false, NUMPY_HEADER);
+    raw.set_memory_map(true);
+    raw.load_equal_chunks();
+    af::array expected = 10 * (af::range(af::dim4(3, raw.n_samples()), 1) + raw.global_offset())
+                         + af::range(af::dim4(3, raw.n_samples()), 0);
+    ASSERT_TRUE(af::allTrue<bool>(raw.data() == expected.as(f32)));
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(NUMPY_FILE.c_str());
+    }
+    ASSERT_THROW(juml::NumpyDataset(NUMPY_FILE, {}, f32), std::domain_error);
+    juml::NumpyDataset missing("doesNotExist.npy");
+    ASSERT_THROW(missing.load_equal_chunks(), std::runtime_error);
+}
+
+TEST_ALL_F(DATASET_TEST, CSV_READER) {
+    const int rows = 4 * size_ + 3;
+    if (rank_ == 0) {
+        std::ofstream file(CSV_FILE.c_str(), std::ios::trunc);
+        file << "index,half,tenth\n";
+        for (int row = 0; row < rows; ++row) {
+            file << row << ", " << row * 0.5 << "," << row << "e-1" << (row % 3 == 0 ? "\r\n" : "\n");
+            if (row % 5 == 0) file << "\n";
+        }
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // the lines are partitioned in file order
+    juml::CSVReader reader(CSV_FILE, ',', true);
+    af::array data = reader.read();
+    long long n_samples = data.isempty() ? 0 : data.dims(1);
+    long long offset = n_samples;
+    MPI_Exscan(MPI_IN_PLACE, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank_ == 0) offset = 0;
+    MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(rows, n_samples);
+    if (!data.isempty()) {
+        ASSERT_EQ(3, data.dims(0));
+        ASSERT_EQ(f32, data.type());
+        af::array index = af::range(af::dim4(1, data.dims(1)), 1) + static_cast<float>(offset);
+        ASSERT_TRUE(af::allTrue<bool>(data.row(0) == index));
+        ASSERT_TRUE(af::allTrue<bool>(af::abs(data.row(1) - index * 0.5f) < 1e-6f));
+        ASSERT_TRUE(af::allTrue<bool>(af::abs(data.row(2) - index * 0.1f) < 1e-5f));
+    }
+
+    // malformed values are reported on all nodes
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::ofstream file(CSV_FILE.c_str(), std::ios::trunc);
+        for (int row = 0; row < rows; ++row) {
+            file << row << (row == rows - 1 ? ",x\n" : ",1\n");
+        }
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    ASSERT_THROW(juml::CSVReader(CSV_FILE).read(), std::domain_error);
+
+    // a file that a single node cannot open fails the read on all nodes
+    const std::string unreadable = rank_ == size_ - 1 ? CSV_FILE + ".missing" : CSV_FILE;
+    ASSERT_THROW(juml::CSVReader(unreadable).read(), std::runtime_error);
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(CSV_FILE.c_str());
+    }
+    ASSERT_THROW(juml::CSVReader(CSV_FILE).read(), std::runtime_error);
+
+    // number formats
+    const char* numbers[] = {"42", " -1.5e3 ", "+.25", "1E-2", "007.50", "inf", "-nan"};
+    const float expected[] = {42.0f, -1500.0f, 0.25f, 0.01f, 7.5f, INFINITY, NAN};
+    for (int i = 0; i < 7; ++i) {
+        const char* cursor = numbers[i];
+        const char* end = cursor + std::strlen(cursor);
+        float value;
+        ASSERT_TRUE(juml::CSVReader::parse_float(cursor, end, value));
+        ASSERT_EQ(end, cursor);
+        if (std::isnan(expected[i])) {
+            ASSERT_TRUE(std::isnan(value));
+        } else {
+            ASSERT_FLOAT_EQ(expected[i], value);
+        }
+    }
+    const char* invalid = "abc";
+    float value;
+    ASSERT_FALSE(juml::CSVReader::parse_float(invalid, invalid + 3, value));
+}
+
 TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_PREVENT_RELOAD) {
     juml::Dataset data_1D(FILE_PATH, ONE_D_INT);
     time_t loading_time = data_1D.loading_time();
@@ -122,6 +962,62 @@ TEST_ALL_F(DATASET_TEST, LOAD_EQUAL_CHUNKS_PREVENT_RELOAD) {
     ASSERT_GT(data_1D.loading_time(), loading_time);
 }
 
+TEST_ALL_F(DATASET_TEST, CHUNK_ITERATOR_STREAMED) {
+    juml::Dataset data_2D(FILE_PATH, TWO_D_FLOAT);
+    data_2D.set_block_size(2);
+    data_2D.load_equal_chunks();
+    ASSERT_TRUE(data_2D.is_streamed());
+    ASSERT_TRUE(data_2D.data().isempty());
+
+    dim_t n_samples = 0;
+    for (juml::ChunkIterator blocks(data_2D); blocks.has_next();) {
+        const af::array& block = blocks.next();
+        ASSERT_EQ(n_samples, blocks.offset());
+        ASSERT_LE(block.dims(1), 2);
+        ASSERT_EQ(data_2D.n_features(), block.dims(0));
+        ASSERT_TRUE(af::allTrue<bool>(block == (float)this->rank_));
+        n_samples += block.dims(1);
+    }
+    ASSERT_EQ(data_2D.n_samples(), n_samples);
+}
+
+TEST_ALL_F(DATASET_TEST, CHUNK_ITERATOR_PREFETCH) {
+    juml::Dataset data_2D(FILE_PATH, TWO_D_FLOAT);
+    data_2D.set_block_size(1, true);
+    data_2D.load_equal_chunks();
+
+    juml::ChunkIterator blocks(data_2D);
+    for (int pass = 0; pass < 2; ++pass) {
+        dim_t n_samples = 0;
+        while (blocks.has_next()) {
+            const af::array& block = blocks.next();
+            ASSERT_EQ(1, block.dims(1));
+            ASSERT_TRUE(af::allTrue<bool>(block == (float)this->rank_));
+            n_samples += block.dims(1);
+        }
+        ASSERT_EQ(data_2D.n_samples(), n_samples);
+        ASSERT_EQ(blocks.n_blocks(), blocks.stall_times().size());
+        ASSERT_EQ(blocks.n_blocks(), blocks.read_times().size());
+        blocks.reset();
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, CHUNK_ITERATOR_IN_MEMORY) {
+    af::array data = af::randu(3, 7);
+    juml::Dataset dataset(data);
+
+    juml::ChunkIterator blocks(dataset, 3);
+    ASSERT_EQ(3, blocks.n_blocks());
+    for (int pass = 0; pass < 2; ++pass) {
+        while (blocks.has_next()) {
+            const af::array& block = blocks.next();
+            af::array expected = data(af::span, af::seq(blocks.offset(), blocks.offset() + block.dims(1) - 1));
+            ASSERT_TRUE(af::allTrue<bool>(block == expected));
+        }
+        blocks.reset();
+    }
+}
+
 TEST_ALL_F(DATASET_TEST, CREATE_FROM_ARRAY) {
     af::array data = af::constant(1, 4, 4);
     juml::Dataset set(data);
@@ -131,6 +1027,131 @@ TEST_ALL_F(DATASET_TEST, CREATE_FROM_ARRAY) {
     set.load_equal_chunks();
 }
 
+TEST_ALL_F(DATASET_TEST, CREATE_FROM_ARRAY_METADATA) {
+    // the nodes hold rank + 1 samples, the metadata is exchanged on the first request
+    af::array data = af::constant(this->rank_, 3, this->rank_ + 1);
+    juml::Dataset set(data);
+    ASSERT_EQ(this->size_ * (this->size_ + 1) / 2, set.global_n_samples());
+    ASSERT_EQ(this->rank_ * (this->rank_ + 1) / 2, set.global_offset());
+    ASSERT_EQ(1, set.sample_dim());
+}
+
+TEST_ALL_F(DATASET_TEST, VIEW) {
+    af::array data = af::randu(3, 10);
+    juml::Dataset set(data);
+    juml::Dataset view = set.view(2, 7);
+    ASSERT_EQ(5, view.n_samples());
+    ASSERT_EQ(3, view.n_features());
+    ASSERT_TRUE(af::allTrue<bool>(view.data() == data(af::span, af::seq(2, 6))));
+    ASSERT_EQ(5 * this->size_, view.global_n_samples());
+    ASSERT_EQ(5 * this->rank_, view.global_offset());
+
+    // modifications of the view do not alter the dataset
+    view.data() += 1;
+    ASSERT_TRUE(af::allTrue<bool>(set.data() == data));
+
+    juml::Dataset empty = set.view(4, 4);
+    ASSERT_EQ(0, empty.n_samples());
+    ASSERT_EQ(0, empty.global_n_samples());
+    ASSERT_THROW(set.view(5, 11), std::invalid_argument);
+}
+
+TEST_ALL_F(DATASET_TEST, ARRAY_SAMPLE_DIM) {
+    // the first node holds a single sample of 3D data, which arrayfire stores as a 2D array
+    const dim_t count = this->size_ > 1 && this->rank_ == 0 ? 1 : 4;
+    juml::Dataset set(af::constant(1.0f, 2, 3, count));
+    ASSERT_EQ(2, set.sample_dim());
+    ASSERT_EQ(count, set.n_samples());
+    long long total = count;
+    MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(total, set.global_n_samples());
+
+    // a passed sample dimension is taken as is
+    juml::Dataset labels(af::constant(0, 1, 5), MPI_COMM_WORLD, 1);
+    ASSERT_EQ(1, labels.sample_dim());
+    ASSERT_EQ(5, labels.n_samples());
+}
+
+TEST_ALL_F(DATASET_TEST, REDISTRIBUTE_EQUAL) {
+    // rank r holds r + 1 samples labeled with their global index
+    const int offset = this->rank_ * (this->rank_ + 1) / 2;
+    af::array data = af::range(af::dim4(2, this->rank_ + 1), 1, f32) + offset;
+    juml::Dataset set(data);
+    set.redistribute();
+
+    const dim_t total = this->size_ * (this->size_ + 1) / 2;
+    ASSERT_EQ(total, set.global_n_samples());
+    ASSERT_EQ(total / this->size_ + (this->rank_ < total % this->size_ ? 1 : 0), set.n_samples());
+    ASSERT_EQ(2, set.n_features());
+    for (int col = 0; col < set.n_samples(); ++col) {
+        ASSERT_TRUE(af::allTrue<bool>(set.data().col(col) == (float)(set.global_offset() + col)));
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, REDISTRIBUTE_TARGET_COUNTS) {
+    juml::Dataset data(FILE_PATH_ROWNUMBER, ROWNUMBER_SETNAME);
+    data.load_equal_chunks();
+
+    // move all samples to the last rank
+    std::vector<dim_t> counts(this->size_, 0);
+    counts[this->size_ - 1] = 5;
+    data.redistribute(counts);
+    ASSERT_EQ(counts[this->rank_], data.n_samples());
+    if (this->rank_ == this->size_ - 1) {
+        ASSERT_EQ(0, data.global_offset());
+        ASSERT_EQ(3, data.n_features());
+        for (int col = 0; col < 5; ++col) {
+            ASSERT_TRUE(af::allTrue<bool>(data.data().col(col) == col));
+        }
+    }
+
+    std::vector<dim_t> invalid(this->size_, 0);
+    ASSERT_THROW(data.redistribute(invalid), std::invalid_argument);
+}
+
+TEST_ALL_F(DATASET_TEST, SHUFFLE) {
+    const int n_local = 10 + this->rank_;
+    const int offset = 10 * this->rank_ + this->rank_ * (this->rank_ - 1) / 2;
+    af::array indices = af::range(af::dim4(1, n_local), 1, s32) + offset;
+    juml::Dataset data(af::tile(indices, 3));
+    juml::Dataset label(indices);
+    data.shuffle(42);
+    label.shuffle(42);
+
+    // portion sizes are kept and data and labels are permuted identically
+    ASSERT_EQ(n_local, data.n_samples());
+    ASSERT_EQ(n_local, label.n_samples());
+    ASSERT_TRUE(af::allTrue<bool>(data.data() == af::tile(label.data(), 3)));
+
+    // the shuffled labels are a permutation of all global indices
+    af::array gathered = label.data();
+    juml::mpi::allgatherv(gathered, MPI_COMM_WORLD);
+    af::array sorted = af::sort(af::flat(gathered));
+    ASSERT_TRUE(af::allTrue<bool>(sorted == af::range(af::dim4(sorted.elements()), 0, s32)));
+    if (this->size_ > 1) {
+        ASSERT_FALSE(af::allTrue<bool>(af::flat(gathered) == sorted));
+    }
+}
+
+TEST_ALL_F(DATASET_TEST, PARTIAL_SHUFFLE) {
+    const int n_local = 10 + this->rank_;
+    const int offset = 10 * this->rank_ + this->rank_ * (this->rank_ - 1) / 2;
+    af::array indices = af::range(af::dim4(1, n_local), 1, s32) + offset;
+    juml::Dataset data(af::tile(indices, 3));
+    juml::Dataset label(indices);
+    data.partial_shuffle(0.5f, 7);
+    label.partial_shuffle(0.5f, 7);
+
+    ASSERT_EQ(n_local, data.n_samples());
+    ASSERT_TRUE(af::allTrue<bool>(data.data() == af::tile(label.data(), 3)));
+
+    af::array gathered = label.data();
+    juml::mpi::allgatherv(gathered, MPI_COMM_WORLD);
+    af::array sorted = af::sort(af::flat(gathered));
+    ASSERT_TRUE(af::allTrue<bool>(sorted == af::range(af::dim4(sorted.elements()), 0, s32)));
+    ASSERT_THROW(label.partial_shuffle(1.5f, 7), std::invalid_argument);
+}
+
 TEST_ALL_F(DATASET_TEST, NORMALIZE_0_TO_1_DEP_ALL) {
     juml::Dataset data_2D(FILE_PATH, TWO_D_FLOAT);
     data_2D.load_equal_chunks();
@@ -211,6 +1232,44 @@ TEST_ALL_F(DATASET_TEST, NORMALIZE_STD_3_INDEP_1_2) {
             ASSERT_FLOAT_EQ(1.0671874, std(row).scalar<float>());
 }
 
+TEST_ALL_F(DATASET_TEST, MOMENTS) {
+    juml::Dataset data_2D(FILE_PATH, TWO_D_FLOAT);
+    data_2D.load_equal_chunks();
+    juml::Moments moments = data_2D.moments();
+    ASSERT_EQ(data_2D.n_features(), moments.mean.elements());
+    ASSERT_EQ(f64, moments.count.type());
+    ASSERT_EQ(f32, moments.type);
+    ASSERT_EQ(f32, data_2D.mean().type());
+    for (size_t col=0; col < moments.mean.dims(0); col++) {
+        ASSERT_FLOAT_EQ(moments.count(col).scalar<double>(), (float)data_2D.global_n_samples());
+        ASSERT_FLOAT_EQ(moments.mean(col).scalar<double>(), 7.0/6.0);
+        ASSERT_FLOAT_EQ(moments.stddev()(col).scalar<double>(), 1.0671873);
+        ASSERT_FLOAT_EQ(moments.minimum(col).scalar<double>(), 0.0);
+        ASSERT_FLOAT_EQ(moments.maximum(col).scalar<double>(), 3.0);
+    }
+
+    // block-wise and half precision passes agree
+    juml::Dataset streamed(FILE_PATH, TWO_D_FLOAT);
+    streamed.set_block_size(2);
+    streamed.load_equal_chunks();
+    juml::Moments streamed_moments = streamed.moments(true);
+    ASSERT_FLOAT_EQ(streamed_moments.mean.scalar<double>(), 7.0/6.0);
+    ASSERT_FLOAT_EQ(streamed_moments.stddev().scalar<double>(), 1.0671873);
+
+    juml::Dataset half(FILE_PATH, TWO_D_FLOAT);
+    half.set_half_precision(true);
+    half.load_equal_chunks();
+    ASSERT_TRUE(af::allTrue<bool>(half.moments().m2 == moments.m2));
+
+    // nodes without samples take part with the shape and type of the others
+    const af::array local = this->rank_ == 0 && this->size_ > 1 ? af::array() : af::constant(2.0, 3, 4, f64);
+    juml::Dataset partial(local, MPI_COMM_WORLD, 1);
+    juml::Moments partial_moments = partial.moments();
+    ASSERT_EQ(3, partial_moments.mean.elements());
+    ASSERT_EQ(f64, partial_moments.type);
+    ASSERT_TRUE(af::allTrue<bool>(partial_moments.mean == 2.0));
+}
+
 TEST_ALL_F(DATASET_TEST, MEAN_ALL) {
     juml::Dataset data_2D(FILE_PATH, TWO_D_FLOAT);
     data_2D.load_equal_chunks();
@@ -241,6 +1300,177 @@ TEST_ALL_F(DATASET_TEST, STDDEV_ALL) {
     ASSERT_FLOAT_EQ(stddev.scalar<float>(), 1.0671873);
 }
 
+TEST_ALL_F(DATASET_TEST, FEATURE_PARTITIONING) {
+    const hsize_t rows = 6;
+    const hsize_t columns = 2 * static_cast<hsize_t>(size_) + 1;
+    if (rank_ == 0) write_grid(rows, columns);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    juml::Dataset data(DUMP_FILE, DUMP_DATASET);
+    data.set_partitioning(juml::Dataset::FEATURES);
+    data.load_equal_chunks();
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(DUMP_FILE.c_str());
+    }
+
+    // every node holds all samples of its feature range
+    ASSERT_EQ(juml::Dataset::FEATURES, data.partitioning());
+    ASSERT_EQ(size_, data.feature_parts());
+    ASSERT_EQ(1, data.sample_parts());
+    ASSERT_EQ(static_cast<dim_t>(rows), data.n_samples());
+    ASSERT_EQ(static_cast<dim_t>(rows), data.global_n_samples());
+    ASSERT_EQ(0, data.global_offset());
+    ASSERT_EQ(static_cast<dim_t>(columns), data.global_n_features());
+    long long n_features = data.n_features();
+    MPI_Allreduce(MPI_IN_PLACE, &n_features, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(static_cast<long long>(columns), n_features);
+    af::array features = af::range(af::dim4(data.n_features(), rows), 0) + static_cast<float>(data.feature_offset());
+    af::array samples = af::range(af::dim4(data.n_features(), rows), 1);
+    ASSERT_TRUE(af::allTrue<bool>(data.data() == samples * static_cast<float>(columns) + features));
+
+    // per-feature moments are reduced along the samples, the total ones across all nodes
+    const af::array expected_mean = (rows - 1) / 2.0f * columns + features.col(0);
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(data.mean() - expected_mean) < 1e-4));
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(data.stddev() - columns * std::sqrt(35.0f / 12.0f)) < 1e-3));
+    ASSERT_NEAR((rows * columns - 1) / 2.0, data.mean(true).scalar<float>(), 1e-4);
+
+    // the distances sum up the partial distances of all feature ranges
+    const af::array origin = af::constant(0, data.n_features(), 1);
+    const af::array euclidean = juml::euclidean(data.data(), origin, data.feature_comm());
+    const af::array manhattan = juml::manhattan(data.data(), origin, data.feature_comm());
+    for (hsize_t row = 0; row < rows; ++row) {
+        double squares = 0.0;
+        double sum = 0.0;
+        for (hsize_t column = 0; column < columns; ++column) {
+            const double value = static_cast<double>(row * columns + column);
+            squares += value * value;
+            sum += value;
+        }
+        ASSERT_NEAR(std::sqrt(squares), euclidean(row).scalar<float>(), 1e-3);
+        ASSERT_NEAR(sum, manhattan(row).scalar<float>(), 1e-3);
+    }
+
+    // the sample exchanges and weighted partitions are bound to the sample partitioning
+    if (size_ > 1) {
+        ASSERT_THROW(data.load_weighted_chunks(std::vector<double>(size_, 1.0)), std::domain_error);
+        ASSERT_THROW(data.redistribute(), std::domain_error);
+        ASSERT_THROW(data.shuffle(42), std::domain_error);
+    }
+    ASSERT_THROW(data.set_partitioning(juml::Dataset::BLOCKS, -1), std::invalid_argument);
+}
+
+TEST_ALL_F(DATASET_TEST, BLOCK_PARTITIONING) {
+    const hsize_t rows = 2 * static_cast<hsize_t>(size_) + 1;
+    const hsize_t columns = 2 * static_cast<hsize_t>(size_) + 1;
+    if (rank_ == 0) write_grid(rows, columns);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    juml::Dataset data(DUMP_FILE, DUMP_DATASET);
+    data.set_partitioning(juml::Dataset::BLOCKS);
+    data.load_equal_chunks();
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        std::remove(DUMP_FILE.c_str());
+    }
+
+    // the blocks of the grid tile the matrix
+    ASSERT_EQ(size_, data.feature_parts() * data.sample_parts());
+    ASSERT_EQ(static_cast<dim_t>(rows), data.global_n_samples());
+    ASSERT_EQ(static_cast<dim_t>(columns), data.global_n_features());
+    long long n_elements = data.n_samples() * data.n_features();
+    MPI_Allreduce(MPI_IN_PLACE, &n_elements, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(static_cast<long long>(rows * columns), n_elements);
+    const af::dim4 dims(data.n_features(), data.n_samples());
+    af::array features = af::range(dims, 0) + static_cast<float>(data.feature_offset());
+    af::array samples = af::range(dims, 1) + static_cast<float>(data.global_offset());
+    ASSERT_TRUE(af::allTrue<bool>(data.data() == samples * static_cast<float>(columns) + features));
+
+    // per-feature moments span the grid column, the total ones the whole grid
+    const af::array expected_mean = (rows - 1) / 2.0f * columns + features.col(0);
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(data.mean() - expected_mean) < 1e-4));
+    ASSERT_NEAR((rows * columns - 1) / 2.0, data.mean(true).scalar<float>(), 1e-4);
+
+    // views resolve their global metadata within the grid column
+    juml::Dataset view = data.view(0, data.n_samples());
+    ASSERT_EQ(static_cast<dim_t>(rows), view.global_n_samples());
+    ASSERT_EQ(data.global_offset(), view.global_offset());
+    ASSERT_EQ(data.feature_offset(), view.feature_offset());
+}
+
+TEST_ALL_F(DATASET_TEST, SHARDED_DATASET) {
+    // shard i holds i + 1 rows, there are more shards than nodes
+    const size_t n_shards = static_cast<size_t>(size_) + 2;
+    std::vector<std::string> files;
+    std::vector<hsize_t> boundaries(1, 0);
+    for (size_t i = 0; i < n_shards; ++i) {
+        std::stringstream name;
+        name << "shardTest" << (i < 10 ? "0" : "") << i << ".h5";
+        files.push_back(name.str());
+        boundaries.push_back(boundaries.back() + i + 1);
+    }
+    const hsize_t n_rows = boundaries.back();
+    if (rank_ == 0) {
+        for (size_t i = 0; i < n_shards; ++i) {
+            write_shard(files[i], boundaries[i], boundaries[i + 1]);
+        }
+        write_virtual(files, boundaries);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // the matched shards form a single dataset, each node holding whole shards
+    juml::ShardedDataset data({SHARD_PATTERN}, DUMP_DATASET);
+    data.load_equal_chunks();
+    ASSERT_EQ(n_shards, data.shards().size());
+    ASSERT_EQ(files.back(), data.shards().back().filename);
+    ASSERT_EQ(static_cast<dim_t>(n_rows), data.global_n_samples());
+    long long n_samples = data.n_samples();
+    MPI_Allreduce(MPI_IN_PLACE, &n_samples, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    ASSERT_EQ(static_cast<long long>(n_rows), n_samples);
+    ASSERT_NE(boundaries.end(), std::find(boundaries.begin(), boundaries.end(), data.global_offset()));
+    if (data.n_samples() > 0) {
+        af::array rows = af::range(af::dim4(3, data.n_samples()), 1) + static_cast<float>(data.global_offset());
+        ASSERT_TRUE(af::allTrue<bool>(data.data().as(f32) == rows));
+    }
+
+    // an unchanged set of shards is not reloaded
+    data.load_incremental();
+    ASSERT_EQ(static_cast<dim_t>(n_rows), data.global_n_samples());
+
+    // explicit file names and a virtual dataset stacking the shards are equivalent to the pattern
+    juml::ShardedDataset list(files, DUMP_DATASET);
+    list.load_equal_chunks();
+    ASSERT_EQ(data.global_offset(), list.global_offset());
+    ASSERT_EQ(data.n_samples(), list.n_samples());
+    juml::ShardedDataset stacked({VIRTUAL_FILE}, DUMP_DATASET);
+    stacked.load_equal_chunks();
+    ASSERT_EQ(n_shards, stacked.shards().size());
+    ASSERT_EQ(files.front(), stacked.shards().front().filename);
+    ASSERT_EQ(data.global_offset(), stacked.global_offset());
+    ASSERT_EQ(data.n_samples(), stacked.n_samples());
+
+    // a single shard is split into equal sample ranges
+    juml::ShardedDataset single({files.back()}, DUMP_DATASET);
+    single.load_equal_chunks();
+    ASSERT_EQ(static_cast<dim_t>(n_shards), single.global_n_samples());
+    ASSERT_GT(single.n_samples(), 0);
+    af::array rows = af::range(af::dim4(3, single.n_samples()), 1)
+                   + static_cast<float>(boundaries[n_shards - 1] + single.global_offset());
+    ASSERT_TRUE(af::allTrue<bool>(single.data().as(f32) == rows));
+
+    juml::ShardedDataset missing({"shardMissing*.h5"}, DUMP_DATASET);
+    ASSERT_THROW(missing.load_equal_chunks(), std::runtime_error);
+    ASSERT_THROW(juml::ShardedDataset(std::vector<std::string>(), DUMP_DATASET), std::invalid_argument);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank_ == 0) {
+        for (const std::string& file : files) {
+            std::remove(file.c_str());
+        }
+        std::remove(VIRTUAL_FILE.c_str());
+    }
+}
+
 int main(int argc, char** argv) {
     int result = -1;
     int rank;
@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <exception>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <mpi.h>
+#include <string>
+
+#include "core/Test.h"
+#include "data/ChunkIterator.h"
+#include "data/Dataset.h"
+#include "preprocessing/MinMaxScaler.h"
+#include "preprocessing/StandardScaler.h"
+
+static const std::string FILE_PATH = JUML_DATASETS"/iris.h5";
+static const std::string SAMPLES = "samples";
+
+static const std::string DUMP_SCALER = "scaler_model.h5";
+
+TEST_ALL(SCALER_TEST, MIN_MAX) {
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::MinMaxScaler scaler(-1, 1, BACKEND);
+    scaler.fit_transform(X);
+
+    juml::Moments moments = X.moments();
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(moments.minimum + 1.0f) < 1e-5));
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(moments.maximum - 1.0f) < 1e-5));
+    ASSERT_NEAR(scaler.data_min()(0).scalar<float>(), 4.3f, 1e-5);
+    ASSERT_NEAR(scaler.data_max()(0).scalar<float>(), 7.9f, 1e-5);
+}
+
+TEST_ALL(SCALER_TEST, STANDARD) {
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::StandardScaler scaler(1, BACKEND);
+    scaler.fit_transform(X);
+
+    juml::Moments moments = X.moments();
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(moments.mean) < 1e-5));
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(moments.stddev() - 1.0f) < 1e-5));
+}
+
+TEST_ALL(SCALER_TEST, NOT_FITTED) {
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::StandardScaler scaler(1, BACKEND);
+    ASSERT_THROW(scaler.transform(X), std::runtime_error);
+
+    af::array misshaped = af::constant(0, 3, 10);
+    scaler.fit(X);
+    ASSERT_THROW(scaler.transform(misshaped), std::invalid_argument);
+}
+
+TEST_ALL(SCALER_TEST, SAVE_LOAD) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::StandardScaler scaler(2, BACKEND);
+    scaler.fit(X);
+    scaler.save(DUMP_SCALER);
+
+    juml::StandardScaler loaded(1, BACKEND);
+    loaded.load(DUMP_SCALER);
+    if (rank == 0) {
+        std::remove(DUMP_SCALER.c_str());
+    }
+    ASSERT_TRUE(af::allTrue<bool>(loaded.scale() == scaler.scale()));
+    ASSERT_TRUE(af::allTrue<bool>(loaded.offset() == scaler.offset()));
+    ASSERT_TRUE(af::allTrue<bool>(loaded.mean() == scaler.mean()));
+
+    // the loaded statistics transform further data without refitting
+    juml::Dataset Y(FILE_PATH, SAMPLES);
+    Y.load_equal_chunks();
+    af::array original = Y.data().copy();
+    loaded.transform(Y);
+    af::array expected = (original - af::tile(scaler.mean(), 1, original.dims(1)))
+                       / af::tile(scaler.stddev() / 2.0f, 1, original.dims(1));
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(Y.data() - expected) < 1e-5));
+
+    loaded.inverse_transform(Y);
+    ASSERT_TRUE(af::allTrue<bool>(af::abs(Y.data() - original) < 1e-5));
+}
+
+TEST_ALL(SCALER_TEST, BLOCKS) {
+    juml::Dataset X(FILE_PATH, SAMPLES);
+    juml::MinMaxScaler scaler(0, 1, BACKEND);
+    scaler.fit_transform(X);
+
+    // out-of-core data is transformed block by block
+    juml::Dataset streamed(FILE_PATH, SAMPLES);
+    streamed.set_block_size(16);
+    streamed.load_equal_chunks();
+    for (juml::ChunkIterator blocks(streamed); blocks.has_next();) {
+        af::array block = blocks.next();
+        scaler.transform(block);
+        af::array expected = X.data()(af::span, af::seq(blocks.offset(), blocks.offset() + block.dims(1) - 1));
+        ASSERT_TRUE(af::allTrue<bool>(af::abs(block - expected) < 1e-6));
+    }
+}
+
+int main(int argc, char** argv) {
+    int result = -1;
+    int rank;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    ::testing::InitGoogleTest(&argc, argv);
+
+    // suppress output from the other ranks
+    if (rank > 0) {
+        ::testing::UnitTest& unit_test = *::testing::UnitTest::GetInstance();
+        ::testing::TestEventListeners& listeners = unit_test.listeners();
+        delete listeners.Release(listeners.default_result_printer());
+        listeners.Append(new ::testing::EmptyTestEventListener);
+    }
+
+    try {
+        result = RUN_ALL_TESTS();
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+    }
+    MPI_Finalize();
+
+    return result;
+}
@@ -52,6 +52,21 @@ TEST_ALL(DISTANCES_TEST, EUCLIDEAN_TEST) {
     }
 }
 
+TEST_ALL(DISTANCES_TEST, EUCLIDEAN_SPARSE_TEST) {
+    af::array from(af::dim4(3, 2), reinterpret_cast<const float*>(ORIGINS));
+    af::array to(af::dim4(3, 6), reinterpret_cast<const float*>(DESTINATIONS));
+    af::array distances = juml::euclidean(af::sparse(af::transpose(from)), to);
+    ASSERT_EQ(2, distances.dims(0));
+    ASSERT_EQ(6, distances.dims(1));
+
+    for (int row = 0; row < 6; ++row) {
+        for (int col = 0; col < 2; ++col) {
+            ASSERT_NEAR(distances(col, row).scalar<float>(), EUCLIDEAN_DISTANCES[row][col], 1e-5);
+        }
+    }
+    ASSERT_THROW(juml::euclidean(af::sparse(af::transpose(from)), af::constant(0, 2, 6)), std::invalid_argument);
+}
+
 TEST_ALL(DISTANCES_TEST, MANHATTAN_EXCEPTION) {
     // to high-dimensionality
     ASSERT_THROW(juml::manhattan(af::constant(0, 1, 1, 3), af::constant(0, 1, 1)), std::invalid_argument);
@@ -63,6 +78,18 @@ TEST_ALL(DISTANCES_TEST, MANHATTAN_EXCEPTION) {
     ASSERT_THROW(juml::manhattan(af::constant(0, 3), af::constant(0, 2)), std::invalid_argument);
 }
 
+TEST_ALL(DISTANCES_TEST, MANHATTAN_SPARSE_TEST) {
+    af::array from(af::dim4(3, 2), reinterpret_cast<const float*>(ORIGINS));
+    af::array to(af::dim4(3, 6), reinterpret_cast<const float*>(DESTINATIONS));
+    af::array distances = juml::manhattan(af::sparse(af::transpose(from)), to);
+
+    for (int row = 0; row < 6; ++row) {
+        for (int col = 0; col < 2; ++col) {
+            ASSERT_NEAR(distances(col, row).scalar<float>(), MANHATTAN_DISTANCES[row][col], 1e-5);
+        }
+    }
+}
+
 int main(int argc, char** argv) {
     int result = -1;
 